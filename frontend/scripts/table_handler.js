@@ -135,6 +135,14 @@ function createDataTable(options) {
     ajax: {
       url: ajaxUrl,
       type: "POST",
+      // 보이는 colN 열 번호만 전달 → 서버는 그 열만 복호화
+      data: function(d, settings) {
+        const visible = new $.fn.dataTable.Api(settings).columns(":visible").dataSrc().toArray();
+        d.visible_cols = visible
+          .filter(name => /^col\d+$/.test(name))
+          .map(name => name.substring(3))
+          .join(",");
+      },
       dataSrc: function(json) {
         // 메모리에 있는 modifiedData를 서버에서 받은 json.data에 병합
         const modifiedData = getModifiedData();
@@ -4,8 +4,64 @@
 #include <vector>
 #include <cstdint>
 #include <string>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <condition_variable>
 
 
+// IV(Nonce) 생성 방식
+//  - RANDOM : 셀마다 RAND_bytes 12바이트 (기본)
+//  - COUNTER: NIST SP 800-38D 8.2.1 결정적 구성
+//             IV = [고정 필드 32비트] + [호출 카운터 64비트]
+//             스레드마다 고정 필드/카운터 시작값을 한 번만 무작위로 뽑고 이후 1씩 증가
+enum hcrypt_nonce_mode {
+    HCRYPT_NONCE_RANDOM  = 0,
+    HCRYPT_NONCE_COUNTER = 1
+};
+
+// 스트리밍 출력 형식
+//  - FRAMED: [4바이트 encSize][IV + 암호문 + 태그] × 셀 (테이블 API 와 동일)
+//  - BASE64: Base64 암호문을 이어 붙인 버퍼 + 셀 오프셋 (hcrypt_encrypt_table_b64_* 와 동일)
+enum hcrypt_stream_format {
+    HCRYPT_STREAM_FRAMED = 0,
+    HCRYPT_STREAM_BASE64 = 1
+};
+
+// SIMD 커널 단계 (hcrypt_get_capabilities / 환경 변수 HCRYPT_FORCE_ISA)
+//  - SCALAR: SIMD 커널 없음 (작은 셀도 EVP, Base64/PBKDF2 스칼라)
+//  - SSE41 : SSSE3/SSE4.1 + AES-NI/PCLMUL (+ SHA-NI)
+//  - AVX2  : + AVX2, VAES(256비트)
+//  - AVX512: + AVX-512F, VAES(512비트)
+enum hcrypt_isa_level {
+    HCRYPT_ISA_SCALAR = 0,
+    HCRYPT_ISA_SSE41  = 1,
+    HCRYPT_ISA_AVX2   = 2,
+    HCRYPT_ISA_AVX512 = 3
+};
+
+// CPU 기능 비트 (hcrypt_capabilities.cpu_features)
+enum hcrypt_cpu_feature {
+    HCRYPT_CPU_SSSE3   = 1 << 0,
+    HCRYPT_CPU_SSE41   = 1 << 1,
+    HCRYPT_CPU_AESNI   = 1 << 2,
+    HCRYPT_CPU_PCLMUL  = 1 << 3,
+    HCRYPT_CPU_SHA     = 1 << 4,
+    HCRYPT_CPU_AVX2    = 1 << 5,
+    HCRYPT_CPU_VAES    = 1 << 6,
+    HCRYPT_CPU_AVX512F = 1 << 7
+};
+
+// 셀별 복호화 상태 (hcrypt_table_opts.cell_status)
+enum hcrypt_cell_status {
+    HCRYPT_CELL_OK           = 0,   // 복호화 성공 (빈 셀 포함)
+    HCRYPT_CELL_TAG_MISMATCH = 1,   // GCM 태그 불일치 (위조/손상/다른 키)
+    HCRYPT_CELL_BAD_LENGTH   = 2,   // 암호문이 IV + 태그(28바이트)보다 짧음
+    HCRYPT_CELL_BAD_BASE64   = 3,   // Base64 디코딩 실패
+    HCRYPT_CELL_SKIPPED      = 4    // col_mask 로 뺀 열 (인증/복호화 안 함)
+};
+
 // =============  hcrypt_gcm_kdf 클래스  =============
 //
 // AES-GCM + KDF(PBKDF2) 적용
@@ -23,6 +79,10 @@ public:
     hcrypt_gcm_kdf();
     ~hcrypt_gcm_kdf();
 
+    // 키 스케줄(EVP 컨텍스트)을 소유하므로 복사 금지
+    hcrypt_gcm_kdf(const hcrypt_gcm_kdf&) = delete;
+    hcrypt_gcm_kdf& operator=(const hcrypt_gcm_kdf&) = delete;
+
     // 1) PBKDF2로 키 생성
     //    - keyLen: 16, 24, 32
     //    - iterationCount: 기본 10000
@@ -33,31 +93,96 @@ public:
 
     // 2) 이미 만들어둔 키 설정
     //    - 길이가 16,24,32가 아니면 예외
+    //    - 키 확장(라운드 키 + GHASH 테이블)은 여기서 한 번만 수행
     void setKey(const std::vector<uint8_t>& keyData);
-    // 3) 현재 키 읽기 (스레드마다 새 객체를 만들 때 사용)
+    // 3) 현재 키 읽기 (복사본) / 키 길이 (미설정이면 0)
     std::vector<uint8_t> getKey() const;
+    int getKeyLength() const;
 
     // 4) 무작위 IV(Nonce) 생성 (12바이트 권장)
     static std::vector<uint8_t> generateRandomIV();
+    //    iv(12바이트)에 mode 방식으로 바로 기록
+    static void fillIV(uint8_t* iv, hcrypt_nonce_mode mode);
 
     // 5) AES-GCM 암/복호화 (단일 청크)
     //    결과 = [IV(12)] + [암호문] + [태그(16)]
-    std::vector<uint8_t> encrypt(const std::vector<uint8_t>& plaintext);
-    std::vector<uint8_t> decrypt(const std::vector<uint8_t>& ciphertext);
+    //    - 한 객체를 여러 스레드가 동시에 호출해도 안전 (단, setKey와 동시 호출은 금지)
+    std::vector<uint8_t> encrypt(const std::vector<uint8_t>& plaintext) const;
+    std::vector<uint8_t> decrypt(const std::vector<uint8_t>& ciphertext) const;
+
+    // 6) 호출자 버퍼에 직접 암/복호화 (추가 할당 없음)
+    //    - encryptInto: out에 plainLen + 28 바이트 기록 ([IV] + [암호문] + [태그])
+    //    - decryptInto: out에 cipherLen - 28 바이트 기록 (cipherLen >= 28), 태그 불일치 시 예외
+    //    - tryDecryptInto: decryptInto 와 같지만 태그 불일치면 예외 대신 false (출력은 지움)
+    void encryptInto(const uint8_t* plain, size_t plainLen, uint8_t* out,
+                     hcrypt_nonce_mode nonceMode = HCRYPT_NONCE_RANDOM) const;
+    void decryptInto(const uint8_t* cipher, size_t cipherLen, uint8_t* out) const;
+    bool tryDecryptInto(const uint8_t* cipher, size_t cipherLen, uint8_t* out) const;
+
+    // 7) 작은 셀 묶음 암/복호화 (멀티 버퍼 AES-GCM)
+    //    - 평문 64바이트 이하 셀을 8개씩 묶어 AES 블록을 섞어서 처리 (결과 형식은 encryptInto 와 같음)
+    //    - encryptSmallCells: outs[i] 에 plainLens[i] + 28 바이트 기록 (IV 도 여기서 생성)
+    //    - decryptSmallCells: cells[i] (plainLens[i] + 28 바이트) → outs[i] 에 평문
+    //      태그 불일치 셀은 출력을 지우고 예외, 공유 복호화 캐시는 decryptInto 와 같이 조회/저장
+    //      (failed 를 넘기면 예외 대신 failed[i] = 1, 성공한 셀은 0)
+    //    - 더 큰 셀이나 AES-NI/PCLMUL 이 없는 CPU 는 셀마다 EVP 경로로 처리
+    void encryptSmallCells(int count, const uint8_t* const* plains, const int* plainLens,
+                           uint8_t* const* outs,
+                           hcrypt_nonce_mode nonceMode = HCRYPT_NONCE_RANDOM) const;
+    void decryptSmallCells(int count, const uint8_t* const* cells, const int* plainLens,
+                           uint8_t* const* outs, uint8_t* failed = nullptr) const;
 
 private:
     // 내부에서 AES-128/192/256-GCM 중 하나를 선택
     const void* evpCipher; // (실제로는 const EVP_CIPHER*)
     std::vector<uint8_t> key;  // 현재 세팅된 키 (16/24/32 바이트)
+    void* keyCtx;              // 키 확장이 끝난 원본 컨텍스트 (실제로는 EVP_CIPHER_CTX*)
+    void* smallKey;            // 작은 셀 엔진용 라운드 키 + H 거듭제곱 (실제로는 SmallGcmKey*, 엔진이 없으면 NULL)
+    uint64_t keyId;            // 스레드별 컨텍스트 캐시 식별자 (setKey마다 새 값)
+    uint64_t keyFingerprint;   // 공유 복호화 캐시 식별자 (키에서 HMAC으로 유도, 프로세스 간 동일)
 
-    // AES-GCM 내부 로직
-    std::vector<uint8_t> aesEncryptGcm(const std::vector<uint8_t>& plain);
-    std::vector<uint8_t> aesDecryptGcm(const std::vector<uint8_t>& cipher);
+    // 현재 스레드용 컨텍스트 (keyCtx 복사본, 셀마다 IV만 다시 설정)
+    void* threadCtx() const;
 
-    // OpenSSL 초기화/정리 (static)
-    static void opensslInit();
-    static void opensslCleanup();
-    static bool opensslInitialized;
+    // AES-GCM 내부 로직 (aesEncryptGcm: out 앞 12바이트에 IV가 이미 기록되어 있어야 함)
+    //  - aesDecryptGcm: 태그 불일치면 throwOnTag 에 따라 예외 또는 false
+    void aesEncryptGcm(const uint8_t* plain, size_t plainLen, uint8_t* out) const;
+    bool aesDecryptGcm(const uint8_t* cipher, size_t cipherLen, uint8_t* out,
+                       bool throwOnTag = true) const;
+};
+
+// =============  hcrypt_pool 클래스  =============
+//
+// 테이블 암/복호화용 상주 워커 스레드 풀
+//  - hcrypt_pool_create(n)로 한 번 만들어 두고 테이블 API에 계속 넘겨서 재사용
+//  - 유휴 워커는 condition_variable에서 대기 → 호출마다 스레드 생성 비용 없음
+//  - parallelFor()는 호출한 스레드도 작업에 참여
+//    (워커 안에서 다시 parallelFor를 불러도 교착되지 않음)
+//
+// ===================================================
+class hcrypt_pool {
+public:
+    explicit hcrypt_pool(int threadCount);
+    ~hcrypt_pool();
+
+    // 워커 스레드 수 (호출 스레드 제외)
+    int size() const;
+
+    // [0, taskCount) 작업을 워커들에 나눠 실행하고 모두 끝날 때까지 대기
+    //  - 작업 중 예외가 나면 첫 번째 예외를 호출 스레드에서 다시 던짐
+    void parallelFor(int taskCount, const std::function<void(int)>& fn);
+
+    // 작업 하나를 큐에 넣고 바로 반환 (완료 대기 없음)
+    void submit(std::function<void()> task);
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stopping;
+
+    void workerLoop();
 };
 
 // ===================== C 인터페이스 (extern "C") =====================
@@ -73,11 +198,20 @@ extern "C" {
  #define HCRYPT_DLL
 #endif
 
+// ------------ 라이브러리 초기화 ------------
+//  - OpenSSL 초기화 + AES-128/192/256-GCM, SHA-256 객체를 프로세스당 한 번만 가져옴 (call_once)
+//  - hcrypt_new 에서도 자동으로 불리므로 생략 가능
+//    (워커 시작 시 미리 불러 두면 첫 요청이 fetch 비용을 내지 않음)
+//  - 정리 함수 없음: 가져온 객체는 프로세스 끝까지 유지 (OpenSSL 이 종료 시 정리)
+//  - 반환: 0 = 성공, -1 = 실패 (다시 불러도 같은 결과)
+HCRYPT_DLL int hcrypt_library_init(void);
+
 // ------------ 객체 생성/소멸 ------------
 HCRYPT_DLL hcrypt_gcm_kdf* hcrypt_new();
 HCRYPT_DLL void hcrypt_delete(hcrypt_gcm_kdf* hc);
 
 // ------------ KDF (PBKDF2) ------------
+//  - 파생 키 캐시를 거침 (hcrypt_derive_key_cached 와 같음, 반환값만 없음)
 HCRYPT_DLL void hcrypt_deriveKeyFromPassword(
     hcrypt_gcm_kdf* hc,
     const char* password,
@@ -87,6 +221,54 @@ HCRYPT_DLL void hcrypt_deriveKeyFromPassword(
     int iteration
 );
 
+// ------------ 파생 키 캐시 ------------
+//  - (password, salt, iteration, key_len) 이 같으면 PBKDF2 없이 이전에 파생한 키를 설정
+//    검색 키 = 테이블마다 무작위 비밀값으로 만든 HMAC-SHA256 (비밀번호/salt 는 저장하지 않음)
+//  - 프로세스 캐시는 항상 사용, 공유 캐시(/dev/shm, 권한 0600)는 attach 했을 때만
+//    환경 변수 HCRYPT_KEY_CACHE 에 이름이 있으면 처음 파생할 때 자동 attach
+//  - 키가 들어 있는 페이지는 mlock + 코어 덤프 제외
+//  - derive_key_cached 반환: 1 = 캐시 적중, 0 = 새로 파생, -1 = 실패
+//  - invalidate/clear: 프로세스 + 공유 캐시에서 지움 (반환: 지운 항목 수, 이미 키를 설정한 객체는 그대로)
+//  - unlink: 공유 세그먼트 삭제 (붙어 있는 프로세스는 detach 할 때까지 기존 매핑을 씀)
+HCRYPT_DLL int hcrypt_derive_key_cached(
+    hcrypt_gcm_kdf* hc,
+    const char* password,
+    const uint8_t* salt,
+    int salt_len,
+    int key_len,
+    int iteration
+);
+
+HCRYPT_DLL int hcrypt_keycache_attach(const char* name);
+HCRYPT_DLL void hcrypt_keycache_detach(void);
+HCRYPT_DLL int hcrypt_keycache_invalidate(
+    const char* password,
+    const uint8_t* salt,
+    int salt_len,
+    int key_len,
+    int iteration
+);
+HCRYPT_DLL int hcrypt_keycache_clear(void);
+HCRYPT_DLL int hcrypt_keycache_unlink(const char* name);
+
+// ------------ 다중 PBKDF2 일괄 파생 ------------
+//  - PBKDF2-HMAC-SHA256 count 건을 SIMD 레인으로 묶어 한꺼번에 계산
+//    (AVX-512 16레인 / SHA-NI / AVX2 8레인 / 스칼라 중 CPU 에 맞게 한 번 선택)
+//  - 결과는 PKCS5_PBKDF2_HMAC 과 같음, out_keys 에 count * key_len 바이트 (입력 순서대로)
+//  - key_len 1~32, iterations[i] >= 1 (작업마다 달라도 됨), pool = NULL 이면 호출 스레드에서
+//  - 파생 키 캐시는 거치지 않음
+//  - 반환: 0 = 성공, -1 = 실패
+HCRYPT_DLL int hcrypt_derive_keys_batch(
+    hcrypt_pool* pool,
+    int count,
+    const char* const* passwords,
+    const uint8_t* const* salts,
+    const int* salt_lens,
+    const int* iterations,
+    int key_len,
+    uint8_t* out_keys
+);
+
 // ------------ 키 직접 설정 ------------
 HCRYPT_DLL void hcrypt_setKey(hcrypt_gcm_kdf* hc, const uint8_t* keydata, int key_len);
 
@@ -149,7 +331,615 @@ HCRYPT_DLL uint8_t* hcrypt_decrypt_table_mt_alloc(
     int* out_len
 );
 
+// ------------ 테이블 API 옵션 ------------
+//  - NULL을 넘기면 기본값 (모든 필드 0)
+//  - col_mask: 열 선택 비트맵 (LSB-first, 열 c = col_mask[c/8] 의 c%8 비트, 1 = 복호화)
+//      선택하지 않은 열은 인증/복호화하지 않고 빈 셀로 돌려줌 (validity 비트 0)
+//      *_size 함수는 마스크를 모르므로 상한값 → *_into 반환값이 실제 기록 크기
+//  - cell_status: 셀별 상태 코드 배열 (rowCount*colCount 바이트, hcrypt_cell_status)
+//      NULL   = 셀 하나라도 태그 불일치/잘못된 Base64 면 테이블 전체 실패 (기존 동작)
+//               IV + 태그(28바이트)보다 짧은 셀은 예전처럼 빈 셀 (hcrypt_gcm_kdf::decrypt 와 같음)
+//      넘기면 = 문제 셀만 표시하고 나머지는 계속 복호화 → 호출은 성공
+//               실패한 셀 자리는 0 으로 채워지고(길이/offsets 는 그대로) validity 비트는 0
+//      헤더가 입력 범위를 벗어나는 등 셀 경계를 알 수 없는 손상은 여전히 전체 실패
+//  - failed_cells: cell_status 와 함께 쓰면 상태가 OK/SKIPPED 가 아닌 셀 수 (NULL 가능)
+typedef struct hcrypt_table_opts {
+    int nonce_mode;           // hcrypt_nonce_mode (암호화만 해당)
+    const uint8_t* col_mask;  // 복호화할 열 (복호화만 해당, NULL = 모든 열)
+    uint8_t* cell_status;     // 셀별 상태 (복호화만 해당, NULL = 전체 실패 방식)
+    int64_t* failed_cells;    // 실패한 셀 수 (복호화만 해당, NULL 가능)
+} hcrypt_table_opts;
+
+// hcrypt_decrypt_table_mt_alloc + opts (col_mask, cell_status)
+//  - cell_status 를 넘기면 문제 셀이 있어도 결과를 돌려줌 → 실패한 셀만 따로 다시 처리
+HCRYPT_DLL uint8_t* hcrypt_decrypt_table_mt_alloc_opts(
+    hcrypt_gcm_kdf* hc,
+    const uint8_t* enc_data,
+    int enc_data_len,
+    int rowCount,
+    int colCount,
+    int threadCount,
+    const hcrypt_table_opts* opts,
+    int* out_len
+);
+
+// ------------ 호출자 버퍼로 N×M 테이블 암/복호화 ------------
+//  - *_size 로 정확한 결과 크기를 먼저 구하고, 그만큼 잡은 버퍼를 넘김
+//  - 스레드는 각자 구간의 위치(prefix-sum)에 바로 기록 → 중간 버퍼/복사 없음
+//  - pool 이 NULL이면 호출 스레드에서만 실행
+//  - 반환: 기록한 바이트 수, 실패(입력 오류/용량 부족 등) 시 -1
+//
+//  암호화 결과 크기 = Σ (셀 길이 > 0 ? 4 + 12 + 셀 길이 + 16 : 4)
+HCRYPT_DLL int64_t hcrypt_table_encrypted_size(
+    const int* cell_sizes,
+    int rowCount,
+    int colCount
+);
+
+HCRYPT_DLL int64_t hcrypt_encrypt_table_into(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t** table,
+    const int* cell_sizes,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    uint8_t* out,
+    int64_t capacity
+);
+
+//  복호화 결과 크기 = Σ (4 + 평문 길이), enc_data 헤더만 훑어서 계산 (형식 오류 시 -1)
+HCRYPT_DLL int64_t hcrypt_table_decrypted_size(
+    const uint8_t* enc_data,
+    int64_t enc_data_len,
+    int rowCount,
+    int colCount
+);
+
+HCRYPT_DLL int64_t hcrypt_decrypt_table_into(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* enc_data,
+    int64_t enc_data_len,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    uint8_t* out,
+    int64_t capacity
+);
+
+// ------------ Arrow 레이아웃 입력 (values + offsets) ------------
+//  - 셀 i 의 평문 = values[offsets[i] .. offsets[i+1]), offsets 는 rowCount*colCount+1 개
+//  - 셀마다 따로 할당할 필요 없이 버퍼 하나(예: PHP implode 결과) + 오프셋 배열 하나로 전달
+//  - C++ 쪽은 values 를 복사하지 않고 그대로 읽음
+//  - 결과 형식/반환 규칙은 hcrypt_encrypt_table_into 와 동일 (pool 이 NULL이면 호출 스레드에서만 실행)
+HCRYPT_DLL int64_t hcrypt_table_encrypted_size_values(
+    const int64_t* offsets,
+    int rowCount,
+    int colCount
+);
+
+HCRYPT_DLL int64_t hcrypt_encrypt_table_values_into(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* values,
+    int64_t values_len,
+    const int64_t* offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    uint8_t* out,
+    int64_t capacity
+);
+
+HCRYPT_DLL uint8_t* hcrypt_encrypt_table_values_alloc(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* values,
+    int64_t values_len,
+    const int64_t* offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    int* out_len
+);
+
+// ------------ values + offsets 형식 복호화 결과 ------------
+//  - 평문만 이어 붙인 values 버퍼 + int64 offsets(rowCount*colCount+1 개)
+//    셀 (r, c) 평문 = values[offsets[r*colCount+c] .. offsets[r*colCount+c+1]) → 행/열 임의 접근 O(1)
+//  - validity(NULL 가능): (rowCount*colCount+7)/8 바이트 LSB-first 비트맵
+//    비트 1 = 값 있음, 0 = 빈 셀(NULL)
+//  - offsets/validity 는 호출자가 준비 (셀 개수로 크기가 정해짐)
+//  - *_values_into: values 에 쓴 바이트 수 반환 (실패 시 -1)
+//  - *_values_alloc: values 를 할당해서 반환 (hcrypt_free 로 해제, 2GB 미만)
+HCRYPT_DLL int64_t hcrypt_table_decrypted_values_size(
+    const uint8_t* enc_data,
+    int64_t enc_data_len,
+    int rowCount,
+    int colCount
+);
+
+HCRYPT_DLL int64_t hcrypt_decrypt_table_values_into(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* enc_data,
+    int64_t enc_data_len,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    uint8_t* values,
+    int64_t capacity,
+    int64_t* offsets,
+    uint8_t* validity
+);
+
+HCRYPT_DLL uint8_t* hcrypt_decrypt_table_values_alloc(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* enc_data,
+    int64_t enc_data_len,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    int64_t* offsets,
+    uint8_t* validity,
+    int* out_len
+);
+
+// ------------ Base64 암호문 입출력 ------------
+//  - 셀 암호문 = Base64([IV 12][암호문][태그 16]), 빈 셀은 빈 문자열
+//    (PHP 에서 base64_encode 로 저장하던 값과 동일 → DB 값을 그대로 넣고 뺄 수 있음)
+//  - Base64 변환은 워커 스레드가 AES 와 같은 패스에서 처리 (AVX2/SSSE3, 없으면 스칼라)
+//  - 평문/암호문 모두 values + offsets(rowCount*colCount+1 개) 형식
+//  - 암호화: out_offsets 에 셀별 Base64 글자 위치 기록
+//  - 복호화: 잘못된 Base64 가 하나라도 있으면 실패 (-1 / NULL), opts->cell_status 를 넘기면 그 셀만 HCRYPT_CELL_BAD_BASE64
+//    (길이가 4의 배수가 아닌 셀 포함 - 그 셀은 평문 0 바이트, hcrypt_table_decrypted_b64_size 도 0 으로 계산)
+HCRYPT_DLL int64_t hcrypt_table_encrypted_b64_size(
+    const int64_t* offsets,
+    int rowCount,
+    int colCount
+);
+
+HCRYPT_DLL int64_t hcrypt_encrypt_table_b64_into(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* values,
+    int64_t values_len,
+    const int64_t* offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    uint8_t* out,
+    int64_t capacity,
+    int64_t* out_offsets
+);
+
+HCRYPT_DLL uint8_t* hcrypt_encrypt_table_b64_alloc(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* values,
+    int64_t values_len,
+    const int64_t* offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    int64_t* out_offsets,
+    int* out_len
+);
+
+HCRYPT_DLL int64_t hcrypt_table_decrypted_b64_size(
+    const uint8_t* b64,
+    int64_t b64_len,
+    const int64_t* b64_offsets,
+    int rowCount,
+    int colCount
+);
+
+HCRYPT_DLL int64_t hcrypt_decrypt_table_b64_into(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* b64,
+    int64_t b64_len,
+    const int64_t* b64_offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    uint8_t* values,
+    int64_t capacity,
+    int64_t* offsets,
+    uint8_t* validity
+);
+
+HCRYPT_DLL uint8_t* hcrypt_decrypt_table_b64_alloc(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* b64,
+    int64_t b64_len,
+    const int64_t* b64_offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    int64_t* offsets,
+    uint8_t* validity,
+    int* out_len
+);
+
+// ------------ 스트리밍 암호화 (메모리 상한) ------------
+//  - begin     : hc/pool 은 finish 까지 살아 있어야 함 (pool 이 NULL이면 라이브러리 공용 풀)
+//                window_bytes = pull 하지 않은 묶음의 입력+출력 바이트 상한
+//  - push_rows : rowCount 행 (values + offsets, rowCount*colCount+1 개) 을 복사해서 풀에 넘김
+//                1 = 받음, 0 = window 가 참 (pull_output 을 먼저 호출), -1 = 오류
+//                window 가 비어 있으면 window 보다 큰 묶음도 하나는 받음
+//  - pull_output: push 순서대로 다음 묶음 결과를 chunk 에 채움
+//                1 = 결과 있음, 0 = 남은 묶음 없음 (wait=0 이면 아직 안 끝난 경우도 0), -1 = 오류
+//                chunk 의 포인터는 다음 pull_output/finish 호출 전까지만 유효
+//  - finish    : 실행 중인 묶음을 기다린 뒤 세션 해제 (pull 안 한 결과는 버림)
+//                push 한 전체 행 수 반환, 오류가 있었으면 -1
+typedef struct hcrypt_stream hcrypt_stream;
+
+typedef struct hcrypt_stream_chunk {
+    int64_t first_row;        // 스트림 전체 기준 첫 행 번호
+    int row_count;
+    const uint8_t* data;      // 암호문 (형식은 begin 의 format)
+    int64_t data_len;
+    const int64_t* offsets;   // BASE64: 셀 위치 (row_count*colCount+1 개), FRAMED: NULL
+} hcrypt_stream_chunk;
+
+HCRYPT_DLL hcrypt_stream* hcrypt_stream_begin(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    int colCount,
+    int format,
+    int64_t window_bytes,
+    const hcrypt_table_opts* opts
+);
+
+HCRYPT_DLL int hcrypt_stream_push_rows(
+    hcrypt_stream* s,
+    const uint8_t* values,
+    int64_t values_len,
+    const int64_t* offsets,
+    int rowCount
+);
+
+HCRYPT_DLL int hcrypt_stream_pull_output(
+    hcrypt_stream* s,
+    int wait,
+    hcrypt_stream_chunk* chunk
+);
+
+HCRYPT_DLL int64_t hcrypt_stream_finish(hcrypt_stream* s);
+
+// ------------ 비동기 테이블 작업 (submit / poll / wait / result) ------------
+//  - hcrypt_submit_*: 입력(셀 데이터, offsets, col_mask)을 복사해서 풀에 넘기고 바로 작업 번호(> 0) 반환
+//                입력 오류/키 없음은 바로 -1, 호출자는 반환 즉시 입력 버퍼를 재사용할 수 있음
+//                pool 이 NULL 이면 라이브러리 공용 풀 (워커가 없는 풀이면 submit 안에서 바로 실행)
+//                hc/pool 은 작업이 끝날 때까지 살아 있어야 함 (hc 의 키도 바꾸면 안 됨)
+//                opts->cell_status 는 "셀별 상태 사용" 표시로만 보고, 상태 배열은 작업이 가짐 (result.cell_status)
+//  - 결과 형식 (같은 이름의 동기 함수와 같음)
+//      encrypt_table / encrypt_table_values : [4바이트 encSize][IV][암호문][태그] × 셀
+//      encrypt_table_b64                    : Base64 글자 + offsets
+//      decrypt_table                        : [4바이트 plainLen][평문] × 셀
+//      decrypt_table_values / _b64          : 평문 values + offsets + validity
+//  - job_poll  : 1 = 끝남(성공), 0 = 실행 중, -1 = 실패 또는 없는 작업 번호
+//  - job_wait  : 끝날 때까지 대기 (timeout_ms 음수 = 무한), 반환값은 job_poll 과 같음
+//  - job_result: 끝난 작업의 결과를 result 에 채움 (0 / -1), 포인터는 job_release 전까지 유효
+//  - job_release: 작업과 결과 해제 (끝난 작업은 반드시 호출, 실행 중이면 끝난 뒤 해제)
+typedef struct hcrypt_job_output {
+    const uint8_t* data;
+    int64_t data_len;
+    const int64_t* offsets;      // Base64 암호화/values 복호화: rowCount*colCount+1 개, 나머지 NULL
+    const uint8_t* validity;     // decrypt_table_values/_b64 만, 나머지 NULL
+    const uint8_t* cell_status;  // opts->cell_status 를 넘긴 복호화만, 나머지 NULL
+    int64_t failed_cells;
+} hcrypt_job_output;
+
+HCRYPT_DLL int64_t hcrypt_submit_encrypt_table(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t** table,
+    const int* cell_sizes,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts
+);
+
+HCRYPT_DLL int64_t hcrypt_submit_encrypt_table_values(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* values,
+    int64_t values_len,
+    const int64_t* offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts
+);
+
+HCRYPT_DLL int64_t hcrypt_submit_encrypt_table_b64(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* values,
+    int64_t values_len,
+    const int64_t* offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts
+);
+
+HCRYPT_DLL int64_t hcrypt_submit_decrypt_table(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* enc_data,
+    int64_t enc_data_len,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts
+);
+
+HCRYPT_DLL int64_t hcrypt_submit_decrypt_table_values(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* enc_data,
+    int64_t enc_data_len,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts
+);
+
+HCRYPT_DLL int64_t hcrypt_submit_decrypt_table_b64(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* b64,
+    int64_t b64_len,
+    const int64_t* b64_offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts
+);
+
+HCRYPT_DLL int hcrypt_job_poll(int64_t job_id);
+HCRYPT_DLL int hcrypt_job_wait(int64_t job_id, int timeout_ms);
+HCRYPT_DLL int hcrypt_job_result(int64_t job_id, hcrypt_job_output* result);
+HCRYPT_DLL void hcrypt_job_release(int64_t job_id);
+
+// ------------ 행 인덱스 컨테이너 (페이지 단위 복호화) ------------
+//  - 컨테이너 = [테이블 본문 ([4바이트 encSize][enc] × 셀)] + [행 오프셋 인덱스] + [32바이트 트레일러]
+//    본문은 기존 테이블 형식 그대로이고, 인덱스/트레일러가 뒤에 붙음
+//  - hcrypt_encrypt_table_container_alloc: 암호화하면서 바로 컨테이너로 만듦
+//  - hcrypt_table_build_index: 예전 blob(본문만) 뒤에 붙일 인덱스+트레일러 생성
+//      (out 크기 = hcrypt_table_index_size(rowCount), 헤더 스캔은 pool 로 병렬 처리)
+//  - hcrypt_decrypt_rows*: [first_row, first_row+row_count) 행만 복호화
+//      결과는 values + offsets(row_count*colCount+1 개) (+ validity) 형식
+//      행 위치는 트레일러/인덱스에서 O(1)로 찾고, 해당 행 범위의 바이트만 읽음
+//  - hcrypt_table_container_info: rowCount/colCount 조회 (0 = 성공, -1 = 인덱스 없음/오류)
+HCRYPT_DLL int64_t hcrypt_table_index_size(int rowCount);
+
+HCRYPT_DLL int64_t hcrypt_table_build_index(
+    hcrypt_pool* pool,
+    const uint8_t* body,
+    int64_t body_len,
+    int rowCount,
+    int colCount,
+    uint8_t* out,
+    int64_t capacity
+);
+
+HCRYPT_DLL uint8_t* hcrypt_encrypt_table_container_alloc(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* values,
+    int64_t values_len,
+    const int64_t* offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    int* out_len
+);
+
+HCRYPT_DLL int hcrypt_table_container_info(
+    const uint8_t* blob,
+    int64_t blob_len,
+    int* rowCount,
+    int* colCount
+);
+
+HCRYPT_DLL int64_t hcrypt_rows_decrypted_size(
+    const uint8_t* blob,
+    int64_t blob_len,
+    int first_row,
+    int row_count
+);
+
+HCRYPT_DLL int64_t hcrypt_decrypt_rows_into(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* blob,
+    int64_t blob_len,
+    int first_row,
+    int row_count,
+    const hcrypt_table_opts* opts,
+    uint8_t* values,
+    int64_t capacity,
+    int64_t* offsets,
+    uint8_t* validity
+);
+
+HCRYPT_DLL uint8_t* hcrypt_decrypt_rows(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* blob,
+    int64_t blob_len,
+    int first_row,
+    int row_count,
+    const hcrypt_table_opts* opts,
+    int64_t* offsets,
+    uint8_t* validity,
+    int* out_len
+);
+
+// ------------ 지연 복호화 테이블 핸들 ------------
+//  - open     : 셀 헤더만 훑어서 셀 위치를 기록 (복호화 없음)
+//               blob 은 복사하지 않으므로 close 전까지 호출자가 유지해야 함
+//               rowCount < 0 이면 행 인덱스 컨테이너로 보고 트레일러에서 rowCount/colCount 를 읽음
+//               cache_bytes: 복호화한 평문을 보관할 LRU 예산 (0 = 마지막으로 읽은 셀만 보관)
+//  - get_cell : 처음 읽을 때 그 셀만 복호화 → LRU 보관, 밀려난 평문은 0으로 지운 뒤 해제
+//               *data 는 같은 핸들의 다음 get_cell/close 전까지 유효 (빈 셀은 *len = 0)
+//               반환: 0 = 성공, -1 = 범위 오류/인증 실패/암호문이 IV + 태그보다 짧은 셀
+//  - 핸들 하나는 스레드 하나에서 사용 (hc 는 close 전까지 유지)
+typedef struct hcrypt_table hcrypt_table;
+
+HCRYPT_DLL hcrypt_table* hcrypt_table_open(
+    hcrypt_gcm_kdf* hc,
+    const uint8_t* blob,
+    int64_t blob_len,
+    int rowCount,
+    int colCount,
+    int64_t cache_bytes
+);
+
+HCRYPT_DLL int hcrypt_table_dims(const hcrypt_table* t, int* rowCount, int* colCount);
+
+HCRYPT_DLL int hcrypt_table_get_cell(
+    hcrypt_table* t,
+    int row,
+    int col,
+    const uint8_t** data,
+    int* len
+);
+
+HCRYPT_DLL void hcrypt_table_close(hcrypt_table* t);
+
+// ------------ 프로세스 간 공유 복호화 캐시 (/dev/shm) ------------
+//  - attach 한 프로세스에서는 모든 복호화 경로(hcrypt_decrypt_alloc, 테이블 API, 지연 핸들)가
+//    먼저 캐시를 찾고, 없으면 복호화 후 인증을 통과한 평문을 넣음
+//  - 같은 name 으로 attach 한 프로세스끼리 공유 (세그먼트 권한 0600, 평문이 들어가므로 opt-in)
+//    budget_bytes 는 세그먼트를 새로 만들 때만 쓰이고, 이미 있으면 그 크기를 그대로 씀
+//    이미 같은 name/budget_bytes 로 붙어 있으면 아무것도 하지 않고 0 (요청마다 불러도 됨), 다르면 -1
+//  - 적중 조건 = 같은 키 + 같은 암호문(IV + 암호문 + 태그) → 위조 암호문은 항상 새로 인증
+//  - 평문 max_cell_bytes 이하 셀만 보관, 가득 차면 CLOCK 교체
+//  - detach 는 다른 스레드가 복호화 중이 아닐 때 호출 / unlink 는 세그먼트 삭제 (무효화)
+//  - 반환: 0 = 성공, -1 = 실패 (get_stats 는 attach 전이면 -1)
+typedef struct hcrypt_cache_stats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t inserts;
+    uint64_t evictions;
+    int64_t capacity_bytes;   // 세그먼트 크기
+    int max_cell_bytes;       // 보관할 수 있는 평문 최대 길이
+} hcrypt_cache_stats;
+
+HCRYPT_DLL int hcrypt_cache_attach(const char* name, int64_t budget_bytes);
+HCRYPT_DLL void hcrypt_cache_detach(void);
+HCRYPT_DLL int hcrypt_cache_unlink(const char* name);
+HCRYPT_DLL int hcrypt_cache_get_stats(hcrypt_cache_stats* out);
+
+// ------------ CPU 기능 / 사용 중인 커널 ------------
+//  - 커널은 처음 쓸 때 cpuid 로 한 번만 고르고 프로세스 안에서는 바뀌지 않음
+//  - 환경 변수 HCRYPT_FORCE_ISA=scalar|sse4.1|avx2|avx512 로 단계를 낮춰 경로별 테스트 가능
+//    (CPU 가 지원하는 단계보다 올릴 수는 없음, PHP-FPM 은 clear_env 때문에 풀 설정 env[] 로 넘겨야 함)
+//  - 이름 문자열은 라이브러리 정적 저장소 (해제하지 않음)
+//  - 반환: 0 = 성공, -1 = out 이 NULL
+typedef struct hcrypt_capabilities {
+    uint32_t cpu_features;    // CPU 가 지원하는 HCRYPT_CPU_* 비트
+    int detected_level;       // CPU 가 지원하는 최고 단계 (hcrypt_isa_level)
+    int active_level;         // 실제로 쓰는 단계 (HCRYPT_FORCE_ISA 반영)
+    const char* small_gcm;    // 작은 셀 AES-GCM: "vaes512" / "vaes256" / "aesni" / "evp"
+    const char* base64;       // Base64: "avx2" / "ssse3" / "scalar"
+    const char* pbkdf2;       // 다중 PBKDF2: "avx512" / "sha-ni" / "avx2" / "scalar"
+} hcrypt_capabilities;
+
+HCRYPT_DLL int hcrypt_get_capabilities(hcrypt_capabilities* out);
+
+// ------------ 성능 카운터 ------------
+//  - 스레드별 잠금 없는 카운터, snapshot 은 모든 스레드(끝난 스레드 포함) 합계
+//  - 기본은 꺼짐: 환경 변수 HCRYPT_STATS=1 또는 hcrypt_stats_enable(1)
+//    (꺼져 있는 동안은 기록하지 않으므로 비용이 거의 없음)
+//  - ns_* 는 단계별 스레드 시간 합계 (여러 스레드가 일하면 벽시계 시간보다 클 수 있음)
+//      nonce  = IV 생성, aes_gcm = 셀 암/복호화, output = 출력 배치 계산/조립, alloc = 결과 버퍼 할당
+//  - reset 은 지금까지의 합계를 0 으로 보이게 함 (이후 snapshot 은 그 시점부터의 증가분)
+//  - prometheus: text exposition 형식을 buf 에 기록 (snprintf 처럼 NUL 포함, cap 이 모자라면 잘림)
+//    반환 = NUL 을 뺀 전체 길이 (cap 보다 크거나 같으면 더 큰 버퍼로 다시 호출), -1 = 실패
+typedef struct hcrypt_stats {
+    uint64_t calls;           // 테이블/단일 API 호출 수
+    uint64_t cells;           // 암/복호화한 셀 수
+    uint64_t plain_bytes;     // 평문 바이트
+    uint64_t cipher_bytes;    // 암호문 바이트 (IV + 암호문 + 태그)
+    uint64_t tag_failures;    // 태그 불일치 셀 수
+    uint64_t ns_nonce;
+    uint64_t ns_aes_gcm;
+    uint64_t ns_output;
+    uint64_t ns_alloc;
+} hcrypt_stats;
+
+HCRYPT_DLL void hcrypt_stats_enable(int on);
+HCRYPT_DLL int hcrypt_stats_enabled(void);
+HCRYPT_DLL int hcrypt_stats_snapshot(hcrypt_stats* out);
+HCRYPT_DLL void hcrypt_stats_reset(void);
+HCRYPT_DLL int64_t hcrypt_stats_prometheus(char* buf, int64_t cap);
+
+// ------------ 추적 링 버퍼 (Chrome trace-event JSON) ------------
+//  - 테이블 API 호출마다 단계별 시작/끝 시각을 실제로 일한 스레드 기준으로 기록
+//      <함수 이름> = 호출 전체 (호출 스레드)
+//      plan        = 헤더/길이를 훑어 구간과 출력 위치를 정하는 직렬 단계
+//      alloc       = *_alloc 결과 버퍼 할당
+//      chunk       = 구간 하나 암/복호화 (args.chunk = 구간 번호) → 스레드별 불균형/낙오 확인
+//      validity    = values 형식 validity 비트맵 채우기 (직렬)
+//    args.call 이 같은 이벤트가 한 호출
+//  - 가장 최근 65536 개 이벤트만 보관 (오래된 것부터 덮어씀)
+//  - 기본은 꺼짐: 환경 변수 HCRYPT_TRACE=1 또는 hcrypt_trace_enable(1)
+//  - clear 는 지금까지의 기록을 덤프에서 뺌
+//  - dump_json: JSON 을 buf 에 기록 (hcrypt_stats_prometheus 와 같은 규칙, 반환 = 필요한 길이)
+//    파일로 저장해 Perfetto(ui.perfetto.dev) 나 chrome://tracing 에서 열면 됨
+HCRYPT_DLL void hcrypt_trace_enable(int on);
+HCRYPT_DLL int hcrypt_trace_enabled(void);
+HCRYPT_DLL void hcrypt_trace_clear(void);
+HCRYPT_DLL int64_t hcrypt_trace_dump_json(char* buf, int64_t cap);
+
+// ------------ 워커 스레드 풀 ------------
+//  - 한 번 만들어 두고 *_pool_alloc 함수에 계속 넘겨서 사용
+//  - *_mt_alloc 함수는 라이브러리 내부 공용 풀을 사용
+//    (공용 풀 워커 = 하드웨어 스레드 수 - 1, threadCount = 그 호출이 쓸 스레드 수 상한)
+HCRYPT_DLL hcrypt_pool* hcrypt_pool_create(int threadCount);
+HCRYPT_DLL void hcrypt_pool_destroy(hcrypt_pool* pool);
+HCRYPT_DLL int hcrypt_pool_size(hcrypt_pool* pool);
+
+// ------------ (스레드 풀) N×M 테이블 일괄 암/복호화 ------------
+//  - 결과 형식은 *_mt_alloc 과 동일
+HCRYPT_DLL uint8_t* hcrypt_encrypt_table_pool_alloc(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t** table,
+    const int* cell_sizes,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    int* out_len
+);
+
+HCRYPT_DLL uint8_t* hcrypt_decrypt_table_pool_alloc(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* enc_data,
+    int enc_data_len,
+    int rowCount,
+    int colCount,
+    int* out_len
+);
+
+// hcrypt_decrypt_table_pool_alloc + opts (col_mask, cell_status)
+//  - opts 규칙은 hcrypt_decrypt_table_mt_alloc_opts 와 동일
+HCRYPT_DLL uint8_t* hcrypt_decrypt_table_pool_alloc_opts(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* enc_data,
+    int enc_data_len,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    int* out_len
+);
+
 } // extern "C"
 
-//g++ -std=c++11 -fPIC -shared aes_gcm_multi.cpp -o aes_gcm_multi.so -lssl -lcrypto -pthread
+//g++ -std=c++17 -fPIC -shared aes_gcm_multi.cpp -o aes_gcm_multi.so -lssl -lcrypto -pthread
 //psql -h localhost -U osy -d login_crypto_db
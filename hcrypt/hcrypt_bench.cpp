@@ -0,0 +1,574 @@
+// hcrypt_bench.cpp
+//  - C API 진입점별 처리량/지연/할당 횟수 측정 (예전 dummy_test.cpp 대체)
+//    enc_single / dec_single : 셀마다 hcrypt_encrypt_alloc / hcrypt_decrypt_alloc
+//    enc_table  / dec_table  : hcrypt_encrypt_table_alloc / hcrypt_decrypt_table_alloc
+//    enc_mt     / dec_mt     : hcrypt_encrypt_table_mt_alloc / hcrypt_decrypt_table_mt_alloc
+//  - 셀 크기(8B ~ 1MB) × 열 수(1/8/120) × 스레드 수를 훑음
+//    행 수는 테이블 평문이 예산(기본 16MB, --quick 2MB)에 맞게 정함
+//  - 지표: cells/s, GB/s(평문 기준, 라운드 중 최고값), 호출당 지연 p50/p99(us), 호출당 malloc 횟수
+//  - 케이스마다 한 번 복호화 결과를 원본과 비교 (틀리면 종료 코드 1)
+//
+//  사용법:
+//    hcrypt_bench [--quick] [--filter 문자열] [--case 이름] [--threads N] [--min-time 초] [--rounds N]
+//                 [--json 결과.json] [--baseline 기준.json] [--compare 결과.json] [--tolerance 0.15]
+//    hcrypt_bench [--quick] --list
+//  - --json: 케이스마다 한 줄짜리 JSON 객체 → 커밋 간 diff 용
+//  - --baseline: 같은 이름의 케이스와 cells/s, 할당 횟수를 비교
+//                cells/s 가 tolerance 이상 떨어지거나 할당이 늘면 회귀 → 종료 코드 2
+//                마지막 줄 geomean = 케이스별 cells/s 비율의 기하 평균
+//                파일에 같은 케이스가 여러 번 있으면(여러 실행 결과를 이어 붙인 파일) 중앙값으로 비교
+//  - --compare : 측정하지 않고 이 파일(들의 중앙값)을 현재 결과로 써서 --baseline 과 비교
+//  - --case    : 이름이 정확히 같은 케이스 하나만 실행, --list: 케이스 이름만 출력
+//  - 절대 cells/s 는 호스트마다 크게 다르므로 다른 호스트에서 잰 기준값과 비교하지 않음
+//    → 회귀 확인은 make bench-ab (같은 호스트에서 기준 커밋과 케이스별로 번갈아 실행)
+#include "aes_gcm_multi.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <cmath>
+
+// ---- 할당 횟수: glibc malloc 계열을 가로채서 셈 (operator new, OpenSSL 포함) ----
+namespace {
+std::atomic<uint64_t> g_allocs(0);
+}
+
+#ifdef __GLIBC__
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void* __libc_memalign(size_t align, size_t size);
+
+void* malloc(size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* p, size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+
+void* memalign(size_t align, size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(align, size);
+}
+
+void* aligned_alloc(size_t align, size_t size) {
+    return memalign(align, size);
+}
+
+int posix_memalign(void** out, size_t align, size_t size) {
+    void* p = memalign(align, size);
+    if (!p) return ENOMEM;
+    *out = p;
+    return 0;
+}
+} // extern "C"
+#endif
+
+namespace {
+
+struct Options {
+    bool quick = false;
+    std::string filter;
+    std::string exactCase;
+    bool listOnly = false;
+    std::string comparePath;
+    int maxThreads = 0;
+    double minTime = 0.3;
+    int rounds = 3;
+    std::string jsonPath;
+    std::string baselinePath;
+    double tolerance = 0.15;
+};
+
+struct Case {
+    std::string entry;
+    int cellBytes;
+    int rows;
+    int cols;
+    int threads;
+    std::string name;
+};
+
+struct Result {
+    Case c;
+    uint64_t calls;
+    uint64_t cells;
+    double seconds;
+    double cellsPerSec;
+    double gbPerSec;
+    double p50Us;
+    double p99Us;
+    double allocsPerCall;
+};
+
+double seconds(std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+std::string sizeLabel(int bytes) {
+    if (bytes >= (1 << 20) && bytes % (1 << 20) == 0) return std::to_string(bytes >> 20) + "MB";
+    if (bytes >= 1024 && bytes % 1024 == 0) return std::to_string(bytes >> 10) + "KB";
+    return std::to_string(bytes) + "B";
+}
+
+// 셀 내용은 셀마다 다르게 (같은 셀 반복으로 캐시 효과가 나지 않도록)
+struct Table {
+    std::vector<uint8_t> values;
+    std::vector<const uint8_t*> ptrs;
+    std::vector<int> sizes;
+};
+
+Table makeTable(int rows, int cols, int cellBytes) {
+    Table t;
+    size_t cells = (size_t)rows * cols;
+    t.values.resize(cells * cellBytes);
+    uint32_t x = 0x9E3779B9u;
+    for (auto &b : t.values) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        b = (uint8_t)('0' + x % 64);
+    }
+    for (size_t i = 0; i < cells; i++) {
+        t.ptrs.push_back(t.values.data() + i * cellBytes);
+        t.sizes.push_back(cellBytes);
+    }
+    return t;
+}
+
+double percentileUs(std::vector<double>& samples, double p) {
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    size_t idx = std::min(samples.size() - 1, (size_t)(p * samples.size()));
+    return samples[idx] * 1e6;
+}
+
+// 테이블 한 벌을 암호화해 둔 결과 (복호화 케이스 입력)
+struct Encrypted {
+    uint8_t* data = nullptr;
+    int len = 0;
+    std::vector<std::pair<const uint8_t*, int>> cells;   // enc_single 결과 (dec_single 입력)
+};
+
+// 진입점 하나 호출 → 처리한 셀 수 (실패하면 -1)
+//  - single 은 호출 한 번에 셀 하나 (cursor 로 순환)
+int64_t callEntry(hcrypt_gcm_kdf* hc, const Case& c, const Table& t, const Encrypted& enc,
+                  size_t& cursor) {
+    int outLen = 0;
+    uint8_t* out = nullptr;
+    int64_t cells = (int64_t)c.rows * c.cols;
+    if (c.entry == "enc_single") {
+        size_t i = cursor++ % t.ptrs.size();
+        out = hcrypt_encrypt_alloc(hc, t.ptrs[i], t.sizes[i], &outLen);
+        cells = 1;
+    } else if (c.entry == "dec_single") {
+        size_t i = cursor++ % enc.cells.size();
+        out = hcrypt_decrypt_alloc(hc, enc.cells[i].first, enc.cells[i].second, &outLen);
+        cells = 1;
+    } else if (c.entry == "enc_table") {
+        out = hcrypt_encrypt_table_alloc(hc, const_cast<const uint8_t**>(t.ptrs.data()), t.sizes.data(),
+                                         c.rows, c.cols, &outLen);
+    } else if (c.entry == "dec_table") {
+        out = hcrypt_decrypt_table_alloc(hc, enc.data, enc.len, c.rows, c.cols, &outLen);
+    } else if (c.entry == "enc_mt") {
+        out = hcrypt_encrypt_table_mt_alloc(hc, const_cast<const uint8_t**>(t.ptrs.data()), t.sizes.data(),
+                                            c.rows, c.cols, c.threads, &outLen);
+    } else if (c.entry == "dec_mt") {
+        out = hcrypt_decrypt_table_mt_alloc(hc, enc.data, enc.len, c.rows, c.cols, c.threads, &outLen);
+    }
+    if (!out) return -1;
+    hcrypt_free(out);
+    return cells;
+}
+
+bool prepare(hcrypt_gcm_kdf* hc, const Case& c, const Table& t, Encrypted& enc) {
+    bool single = c.entry == "enc_single" || c.entry == "dec_single";
+    if (single) {
+        for (size_t i = 0; i < t.ptrs.size(); i++) {
+            int len = 0;
+            uint8_t* e = hcrypt_encrypt_alloc(hc, t.ptrs[i], t.sizes[i], &len);
+            if (!e) return false;
+            enc.cells.push_back({ e, len });
+        }
+        // 한 번 복호화해서 원본과 비교
+        int len = 0;
+        uint8_t* d = hcrypt_decrypt_alloc(hc, enc.cells[0].first, enc.cells[0].second, &len);
+        bool ok = d && len == t.sizes[0] && std::memcmp(d, t.ptrs[0], len) == 0;
+        hcrypt_free(d);
+        return ok;
+    }
+
+    enc.data = hcrypt_encrypt_table_alloc(hc, const_cast<const uint8_t**>(t.ptrs.data()), t.sizes.data(),
+                                          c.rows, c.cols, &enc.len);
+    if (!enc.data) return false;
+    int len = 0;
+    // hcrypt_decrypt_table_alloc 결과 = 평문을 그대로 이어 붙인 것 (*_mt_alloc 은 셀마다 길이 4바이트가 붙음)
+    uint8_t* d = hcrypt_decrypt_table_alloc(hc, enc.data, enc.len, c.rows, c.cols, &len);
+    bool ok = d && (size_t)len == t.values.size() && std::memcmp(d, t.values.data(), len) == 0;
+    hcrypt_free(d);
+    return ok;
+}
+
+void release(Encrypted& enc) {
+    hcrypt_free(enc.data);
+    for (auto &cell : enc.cells) hcrypt_free(const_cast<uint8_t*>(cell.first));
+    enc = Encrypted();
+}
+
+bool runCase(hcrypt_gcm_kdf* hc, const Case& c, const Options& opt, Result& r) {
+    Table t = makeTable(c.rows, c.cols, c.cellBytes);
+    Encrypted enc;
+    if (!prepare(hc, c, t, enc)) {
+        std::cerr << "[" << c.name << "] 암/복호화 결과가 원본과 다릅니다." << std::endl;
+        release(enc);
+        return false;
+    }
+
+    size_t cursor = 0;
+    if (callEntry(hc, c, t, enc, cursor) < 0) {   // 워밍업 (스레드별 컨텍스트, 공용 풀)
+        release(enc);
+        return false;
+    }
+
+    // 라운드 opt.rounds 번 중 처리량이 가장 좋은 라운드를 씀 (공유 호스트 잡음 완화)
+    //  - 지연 p50/p99 와 할당 횟수는 모든 라운드의 호출을 합쳐서 계산
+    std::vector<double> samples;
+    uint64_t allocsBefore = g_allocs.load();
+    double bestRate = 0;
+    uint64_t totalCells = 0;
+    double totalSeconds = 0;
+    for (int round = 0; round < opt.rounds; round++) {
+        uint64_t cells = 0;
+        size_t calls = 0;
+        auto begin = std::chrono::steady_clock::now();
+        double elapsed = 0;
+        while (elapsed < opt.minTime / opt.rounds || calls < 3) {
+            auto callBegin = std::chrono::steady_clock::now();
+            int64_t n = callEntry(hc, c, t, enc, cursor);
+            samples.push_back(seconds(callBegin));
+            if (n < 0) {
+                release(enc);
+                return false;
+            }
+            cells += (uint64_t)n;
+            calls++;
+            elapsed = seconds(begin);
+        }
+        bestRate = std::max(bestRate, cells / elapsed);
+        totalCells += cells;
+        totalSeconds += elapsed;
+    }
+    uint64_t allocs = g_allocs.load() - allocsBefore;
+    release(enc);
+
+    r.c = c;
+    r.calls = samples.size();
+    r.cells = totalCells;
+    r.seconds = totalSeconds;
+    r.cellsPerSec = bestRate;
+    r.gbPerSec = bestRate * c.cellBytes / 1e9;
+    r.p50Us = percentileUs(samples, 0.50);
+    r.p99Us = percentileUs(samples, 0.99);
+    r.allocsPerCall = (double)allocs / r.calls;
+    return true;
+}
+
+std::vector<Case> makeCases(const Options& opt) {
+    const int sizes[] = { 8, 64, 1024, 16 * 1024, 1 << 20 };
+    const int colsList[] = { 1, 8, 120 };
+    const int64_t budget = opt.quick ? (2 << 20) : (16 << 20);
+    const int maxCells = opt.quick ? 20000 : 100000;
+
+    std::vector<int> threadList;
+    for (int th = 1; th <= opt.maxThreads; th *= 2) threadList.push_back(th);
+    if (threadList.back() != opt.maxThreads) threadList.push_back(opt.maxThreads);
+
+    std::vector<Case> cases;
+    auto add = [&](const std::string& entry, int size, int rows, int cols, int threads) {
+        Case c = { entry, size, rows, cols, threads, "" };
+        c.name = entry + "/" + sizeLabel(size) + "/" + std::to_string(rows) + "x" +
+                 std::to_string(cols) + "/t" + std::to_string(threads);
+        if (!opt.exactCase.empty() ? c.name == opt.exactCase
+                                   : (opt.filter.empty() || c.name.find(opt.filter) != std::string::npos)) {
+            cases.push_back(c);
+        }
+    };
+
+    for (int size : sizes) {
+        for (int cols : colsList) {
+            int64_t rowBytes = (int64_t)size * cols;
+            if (rowBytes > 2 * budget) continue;   // 한 행이 예산을 크게 넘는 모양은 생략
+            int rows = (int)std::max<int64_t>(1, std::min<int64_t>(budget / rowBytes, maxCells / cols));
+            if (cols == 1) {
+                add("enc_single", size, rows, 1, 1);
+                add("dec_single", size, rows, 1, 1);
+            }
+            add("enc_table", size, rows, cols, 1);
+            add("dec_table", size, rows, cols, 1);
+            for (int th : threadList) {
+                add("enc_mt", size, rows, cols, th);
+                add("dec_mt", size, rows, cols, th);
+            }
+        }
+    }
+    return cases;
+}
+
+// ---- JSON (케이스마다 한 줄, 기준값 파일도 같은 형식) ----
+std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char ch : s) {
+        if (ch == '"' || ch == '\\') out += '\\';
+        out += ch;
+    }
+    return out;
+}
+
+std::string resultJson(const Result& r) {
+    char buf[512];
+    std::snprintf(buf, sizeof(buf),
+                  "{\"name\":\"%s\",\"entry\":\"%s\",\"cell_bytes\":%d,\"rows\":%d,\"cols\":%d,"
+                  "\"threads\":%d,\"calls\":%llu,\"cells_per_s\":%.1f,\"gb_per_s\":%.4f,"
+                  "\"p50_us\":%.2f,\"p99_us\":%.2f,\"allocs_per_call\":%.2f}",
+                  jsonEscape(r.c.name).c_str(), r.c.entry.c_str(), r.c.cellBytes, r.c.rows, r.c.cols,
+                  r.c.threads, (unsigned long long)r.calls, r.cellsPerSec, r.gbPerSec,
+                  r.p50Us, r.p99Us, r.allocsPerCall);
+    return buf;
+}
+
+// 기준값을 잰 호스트 구분용 (/proc/cpuinfo 가 없으면 빈 문자열)
+std::string cpuModel() {
+    std::ifstream in("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            size_t pos = line.find(':');
+            if (pos != std::string::npos) return line.substr(line.find_first_not_of(' ', pos + 1));
+        }
+    }
+    return "";
+}
+
+bool writeJson(const std::string& path, const Options& opt, const std::vector<Result>& results) {
+    std::ofstream out(path);
+    if (!out) return false;
+    hcrypt_capabilities caps = {};
+    hcrypt_get_capabilities(&caps);
+    out << "{\"meta\":{\"cpu\":\"" << jsonEscape(cpuModel()) << "\",\"quick\":" << (opt.quick ? "true" : "false")
+        << ",\"hardware_threads\":" << std::thread::hardware_concurrency()
+        << ",\"isa_level\":" << caps.active_level
+        << ",\"small_gcm\":\"" << caps.small_gcm << "\",\"base64\":\"" << caps.base64
+        << "\",\"pbkdf2\":\"" << caps.pbkdf2 << "\"},\n\"results\":[\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        out << resultJson(results[i]) << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "]}\n";
+    return (bool)out;
+}
+
+// 줄 단위로 "name", "cells_per_s", "allocs_per_call" 만 읽음 (writeJson 형식 전용)
+bool jsonNumber(const std::string& line, const char* key, double& value) {
+    std::string pat = std::string("\"") + key + "\":";
+    size_t pos = line.find(pat);
+    if (pos == std::string::npos) return false;
+    value = std::strtod(line.c_str() + pos + pat.size(), nullptr);
+    return true;
+}
+
+struct Baseline {
+    double cellsPerSec;
+    double allocsPerCall;
+};
+
+double median(std::vector<double> v) {
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+// 같은 케이스가 여러 줄이면 cells/s, allocs/call 각각 중앙값
+//  - order 가 있으면 처음 나온 순서대로 케이스 이름을 넣음
+bool readBaseline(const std::string& path, std::map<std::string, Baseline>& out,
+                  std::vector<std::string>* order = nullptr) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::map<std::string, std::pair<std::vector<double>, std::vector<double>>> runs;
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t pos = line.find("\"name\":\"");
+        if (pos == std::string::npos) continue;
+        pos += 8;
+        size_t end = line.find('"', pos);
+        if (end == std::string::npos) continue;
+        double rate = 0, allocs = 0;
+        if (!jsonNumber(line, "cells_per_s", rate)) continue;
+        jsonNumber(line, "allocs_per_call", allocs);
+        std::string name = line.substr(pos, end - pos);
+        auto &r = runs[name];
+        if (r.first.empty() && order) order->push_back(name);
+        r.first.push_back(rate);
+        r.second.push_back(allocs);
+    }
+    for (auto &r : runs) {
+        Baseline b = { median(r.second.first), median(r.second.second) };
+        out[r.first] = b;
+    }
+    return true;
+}
+
+// 반환: 회귀 케이스 수
+//  - names 순서대로 now 와 base 에 모두 있는 케이스만 비교
+int compareBaseline(const std::map<std::string, Baseline>& base,
+                    const std::map<std::string, Baseline>& now,
+                    const std::vector<std::string>& names, double tolerance) {
+    int regressions = 0, compared = 0;
+    double logSum = 0;
+    std::cout << "\nbaseline\tcase\tratio\tallocs(base→now)" << std::endl;
+    for (auto &name : names) {
+        auto it = base.find(name);
+        auto cur = now.find(name);
+        if (it == base.end() || cur == now.end() || it->second.cellsPerSec <= 0) continue;
+        compared++;
+        double ratio = cur->second.cellsPerSec / it->second.cellsPerSec;
+        logSum += std::log(ratio);
+        bool slow = ratio < 1.0 - tolerance;
+        bool moreAllocs = cur->second.allocsPerCall > it->second.allocsPerCall * 1.02 + 0.5;
+        if (slow || moreAllocs) {
+            regressions++;
+            std::cout << (slow ? "SLOWER" : "ALLOCS") << "\t" << name << "\t" << ratio << "\t"
+                      << it->second.allocsPerCall << "→" << cur->second.allocsPerCall << std::endl;
+        }
+    }
+    // 전체 변화 = 케이스별 cells/s 비율의 기하 평균 (빌드 옵션 비교용)
+    double geomean = compared > 0 ? std::exp(logSum / compared) : 1.0;
+    std::cout << "compared=" << compared << " regressions=" << regressions
+              << " (tolerance " << tolerance * 100 << "%) geomean=" << geomean << std::endl;
+    return regressions;
+}
+
+bool parseOptions(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (a == "--quick") {
+            opt.quick = true;
+            opt.minTime = 0.06;
+        } else if (a == "--filter" && hasValue) {
+            opt.filter = argv[++i];
+        } else if (a == "--case" && hasValue) {
+            opt.exactCase = argv[++i];
+        } else if (a == "--list") {
+            opt.listOnly = true;
+        } else if (a == "--compare" && hasValue) {
+            opt.comparePath = argv[++i];
+        } else if (a == "--threads" && hasValue) {
+            opt.maxThreads = std::atoi(argv[++i]);
+        } else if (a == "--min-time" && hasValue) {
+            opt.minTime = std::atof(argv[++i]);
+        } else if (a == "--rounds" && hasValue) {
+            opt.rounds = std::max(1, std::atoi(argv[++i]));
+        } else if (a == "--json" && hasValue) {
+            opt.jsonPath = argv[++i];
+        } else if (a == "--baseline" && hasValue) {
+            opt.baselinePath = argv[++i];
+        } else if (a == "--tolerance" && hasValue) {
+            opt.tolerance = std::atof(argv[++i]);
+        } else {
+            std::cerr << "알 수 없는 인자: " << a << std::endl;
+            return false;
+        }
+    }
+    if (opt.maxThreads < 1) opt.maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) return 1;
+
+    // 저장된 결과끼리 비교 (make bench-ab)
+    if (!opt.comparePath.empty()) {
+        std::map<std::string, Baseline> base, now;
+        std::vector<std::string> names;
+        if (opt.baselinePath.empty() || !readBaseline(opt.baselinePath, base) ||
+            !readBaseline(opt.comparePath, now, &names)) {
+            std::cerr << "비교할 결과 파일을 읽지 못했습니다." << std::endl;
+            return 1;
+        }
+        return compareBaseline(base, now, names, opt.tolerance) > 0 ? 2 : 0;
+    }
+
+    hcrypt_library_init();
+    hcrypt_gcm_kdf* hc = hcrypt_new();
+    std::vector<uint8_t> key(32, 0x42);
+    hcrypt_setKey(hc, key.data(), (int)key.size());
+
+    std::vector<Case> cases = makeCases(opt);
+    if (opt.listOnly) {
+        for (auto &c : cases) std::cout << c.name << std::endl;
+        hcrypt_delete(hc);
+        return 0;
+    }
+    std::vector<Result> results;
+
+    std::cout << "case\tcells/s\tGB/s\tp50(us)\tp99(us)\tallocs/call" << std::endl;
+    for (auto &c : cases) {
+        Result r;
+        if (!runCase(hc, c, opt, r)) {
+            std::cerr << "[" << c.name << "] 실패" << std::endl;
+            hcrypt_delete(hc);
+            return 1;
+        }
+        std::cout << c.name << "\t" << r.cellsPerSec << "\t" << r.gbPerSec << "\t" << r.p50Us
+                  << "\t" << r.p99Us << "\t" << r.allocsPerCall << std::endl;
+        results.push_back(r);
+    }
+    hcrypt_delete(hc);
+
+    if (!opt.jsonPath.empty() && !writeJson(opt.jsonPath, opt, results)) {
+        std::cerr << "JSON 저장 실패: " << opt.jsonPath << std::endl;
+        return 1;
+    }
+
+    if (!opt.baselinePath.empty()) {
+        std::map<std::string, Baseline> base;
+        if (!readBaseline(opt.baselinePath, base)) {
+            std::cerr << "기준값 파일을 읽지 못했습니다: " << opt.baselinePath << std::endl;
+            return 1;
+        }
+        std::map<std::string, Baseline> now;
+        std::vector<std::string> names;
+        for (auto &r : results) {
+            Baseline b = { r.cellsPerSec, r.allocsPerCall };
+            now[r.c.name] = b;
+            names.push_back(r.c.name);
+        }
+        if (compareBaseline(base, now, names, opt.tolerance) > 0) return 2;
+    }
+    return 0;
+}
+
+//g++ -std=c++17 -O2 hcrypt_bench.cpp aes_gcm_multi.cpp -o hcrypt_bench -lssl -lcrypto -pthread
+//./hcrypt_bench --quick --json before.json  (변경 전 빌드)
+//./hcrypt_bench --quick --baseline before.json  (변경 후 빌드, 같은 호스트)
@@ -0,0 +1,1104 @@
+// hcrypt_test.cpp
+//  - 라이브러리 동작 검증 (make check)
+//  - 암호문은 OpenSSL EVP 로 따로 복호화해서 형식([IV 12][암호문][태그 16])까지 확인
+//  - 위조/길이 오류/잘못된 Base64 셀로 실패 경로와 셀별 상태도 확인
+//  - 실패한 검사마다 한 줄 출력, 하나라도 실패하면 종료 코드 1
+//
+//  사용법: hcrypt_test
+#include "aes_gcm_multi.h"
+
+#include <openssl/evp.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <set>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <unistd.h>
+#include <dirent.h>
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            std::cout << "FAIL " << __FILE__ << ":" << __LINE__ << "  " #cond << std::endl; \
+            g_failures++;                                                             \
+        }                                                                             \
+    } while (0)
+
+const int kRows = 40;
+const int kCols = 3;
+const int kCells = kRows * kCols;
+
+// 빈 셀, 작은 셀 엔진(64바이트 이하), EVP 경로 셀이 섞이도록
+std::vector<std::string> makeCells() {
+    static const int kLens[] = { 0, 1, 13, 31, 64, 65, 300, 5000 };
+    std::vector<std::string> cells;
+    for (int i = 0; i < kCells; i++) {
+        int len = kLens[(i * 7 + i / kCols) % 8];
+        std::string s;
+        for (int j = 0; j < len; j++) s.push_back((char)('a' + (i + j) % 26));
+        cells.push_back(s);
+    }
+    return cells;
+}
+
+struct Layout {
+    std::vector<uint8_t> values;
+    std::vector<int64_t> offsets;
+    std::vector<const uint8_t*> ptrs;
+    std::vector<int> sizes;
+};
+
+Layout layoutOf(const std::vector<std::string>& cells) {
+    Layout l;
+    l.offsets.push_back(0);
+    for (auto &c : cells) {
+        l.values.insert(l.values.end(), c.begin(), c.end());
+        l.offsets.push_back((int64_t)l.values.size());
+    }
+    for (size_t i = 0; i < cells.size(); i++) {
+        l.ptrs.push_back(l.values.data() + l.offsets[i]);
+        l.sizes.push_back((int)cells[i].size());
+    }
+    return l;
+}
+
+// 라이브러리와 무관하게 EVP 로 셀 하나 복호화 (키 길이로 AES-128/192/256 선택)
+bool evpDecrypt(const std::vector<uint8_t>& key, const uint8_t* cell, size_t len, std::string& out) {
+    if (len < 12 + 16) return false;
+    const EVP_CIPHER* cipher = key.size() == 16 ? EVP_aes_128_gcm()
+                             : key.size() == 24 ? EVP_aes_192_gcm() : EVP_aes_256_gcm();
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    std::vector<uint8_t> plain(len - 28 + 1);
+    int n = 0, fin = 0;
+    bool ok = EVP_DecryptInit_ex(ctx, cipher, nullptr, key.data(), cell) == 1 &&
+              EVP_DecryptUpdate(ctx, plain.data(), &n, cell + 12, (int)len - 28) == 1 &&
+              EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, 16,
+                                  const_cast<uint8_t*>(cell + len - 16)) == 1 &&
+              EVP_DecryptFinal_ex(ctx, plain.data() + n, &fin) == 1;
+    EVP_CIPHER_CTX_free(ctx);
+    if (ok) out.assign(reinterpret_cast<char*>(plain.data()), (size_t)(n + fin));
+    return ok;
+}
+
+std::vector<uint8_t> b64Decode(const uint8_t* src, size_t len) {
+    std::vector<uint8_t> out(len / 4 * 3 + 3);
+    int n = len ? EVP_DecodeBlock(out.data(), src, (int)len) : 0;
+    if (n < 0) return {};
+    while (len > 0 && src[len - 1] == '=') { len--; n--; }
+    out.resize((size_t)n);
+    return out;
+}
+
+inline int32_t readI32(const uint8_t* p) {
+    int32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+// [4바이트 encSize][enc] × 셀 → 셀별 시작 위치
+std::vector<int64_t> cellStarts(const std::vector<uint8_t>& table) {
+    std::vector<int64_t> starts;
+    int64_t off = 0;
+    while (off + 4 <= (int64_t)table.size()) {
+        starts.push_back(off);
+        off += 4 + readI32(table.data() + off);
+    }
+    return starts;
+}
+
+// 프레임 형식 암호문을 EVP 로 셀마다 확인
+bool framedMatches(const std::vector<uint8_t>& key, const std::vector<uint8_t>& table,
+                   const std::vector<std::string>& cells) {
+    std::vector<int64_t> starts = cellStarts(table);
+    if (starts.size() != cells.size()) return false;
+    for (size_t i = 0; i < cells.size(); i++) {
+        int encSize = readI32(table.data() + starts[i]);
+        std::string plain;
+        if (encSize == 0 ? !cells[i].empty()
+                         : !evpDecrypt(key, table.data() + starts[i] + 4, (size_t)encSize, plain) ||
+                           plain != cells[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool valuesMatch(const uint8_t* values, const int64_t* offsets, const uint8_t* validity,
+                 const std::vector<std::string>& cells) {
+    for (size_t i = 0; i < cells.size(); i++) {
+        std::string got(reinterpret_cast<const char*>(values) + offsets[i],
+                        (size_t)(offsets[i + 1] - offsets[i]));
+        bool valid = (validity[i / 8] >> (i % 8)) & 1;
+        if (got != cells[i] || valid != !cells[i].empty()) return false;
+    }
+    return true;
+}
+
+std::vector<uint8_t> encryptFramed(hcrypt_gcm_kdf* hc, hcrypt_pool* pool, const Layout& l,
+                                   const hcrypt_table_opts* opts = nullptr) {
+    int64_t size = hcrypt_table_encrypted_size(l.sizes.data(), kRows, kCols);
+    std::vector<uint8_t> out((size_t)size);
+    int64_t n = hcrypt_encrypt_table_into(hc, pool, const_cast<const uint8_t**>(l.ptrs.data()),
+                                          l.sizes.data(), kRows, kCols, opts, out.data(), size);
+    if (n != size) out.clear();
+    return out;
+}
+
+int threadsInProcess() {
+    DIR* dir = opendir("/proc/self/task");
+    if (!dir) return 0;
+    int n = 0;
+    while (dirent* e = readdir(dir)) {
+        if (e->d_name[0] != '.') n++;
+    }
+    closedir(dir);
+    return n;
+}
+
+// ---- 단일/테이블 왕복 (EVP 로 형식 확인) ----
+void testRoundTrip(hcrypt_gcm_kdf* hc, hcrypt_pool* pool, const std::vector<uint8_t>& key,
+                   const std::vector<std::string>& cells, const Layout& l) {
+    std::string msg = "010-1234-5678";
+    int encLen = 0, decLen = 0;
+    uint8_t* enc = hcrypt_encrypt_alloc(hc, reinterpret_cast<const uint8_t*>(msg.data()),
+                                        (int)msg.size(), &encLen);
+    std::string plain;
+    CHECK(enc && encLen == (int)msg.size() + 28);
+    CHECK(enc && evpDecrypt(key, enc, (size_t)encLen, plain) && plain == msg);
+    uint8_t* dec = hcrypt_decrypt_alloc(hc, enc, encLen, &decLen);
+    CHECK(dec && std::string(reinterpret_cast<char*>(dec), (size_t)decLen) == msg);
+    hcrypt_free(enc);
+    hcrypt_free(dec);
+
+    for (hcrypt_pool* p : { (hcrypt_pool*)nullptr, pool }) {
+        std::vector<uint8_t> table = encryptFramed(hc, p, l);
+        CHECK(!table.empty() && framedMatches(key, table, cells));
+
+        int64_t size = hcrypt_table_decrypted_size(table.data(), (int64_t)table.size(), kRows, kCols);
+        std::vector<uint8_t> out((size_t)size);
+        CHECK(hcrypt_decrypt_table_into(hc, p, table.data(), (int64_t)table.size(), kRows, kCols,
+                                        nullptr, out.data(), size) == size);
+        int64_t off = 0;
+        bool same = true;
+        for (auto &c : cells) {
+            same = same && readI32(out.data() + off) == (int)c.size() &&
+                   std::memcmp(out.data() + off + 4, c.data(), c.size()) == 0;
+            off += 4 + (int64_t)c.size();
+        }
+        CHECK(same && off == size);
+    }
+
+    // 공용 풀은 threadCount 가 커도 하드웨어 스레드 수만큼만 만듦
+    int before = threadsInProcess();
+    int mtLen = 0;
+    uint8_t* mt = hcrypt_encrypt_table_mt_alloc(hc, const_cast<const uint8_t**>(l.ptrs.data()),
+                                                l.sizes.data(), kRows, kCols, 256, &mtLen);
+    CHECK(mt && framedMatches(key, std::vector<uint8_t>(mt, mt + mtLen), cells));
+    hcrypt_free(mt);
+    int hw = (int)std::thread::hardware_concurrency();
+    CHECK(threadsInProcess() - before <= std::max(hw, 2) - 1);
+}
+
+// ---- 카운터 nonce: 스레드 하나면 고정 필드 같고 IV 는 모두 다름 ----
+void testCounterNonce(hcrypt_gcm_kdf* hc, const std::vector<uint8_t>& key,
+                      const std::vector<std::string>& cells, const Layout& l) {
+    hcrypt_table_opts opts = {};
+    opts.nonce_mode = HCRYPT_NONCE_COUNTER;
+    std::vector<uint8_t> table = encryptFramed(hc, nullptr, l, &opts);
+    CHECK(!table.empty() && framedMatches(key, table, cells));
+
+    std::set<std::string> ivs;
+    std::string prefix;
+    bool samePrefix = true;
+    int encrypted = 0;
+    for (int64_t s : cellStarts(table)) {
+        if (readI32(table.data() + s) == 0) continue;
+        std::string iv(reinterpret_cast<const char*>(table.data() + s + 4), 12);
+        if (prefix.empty()) prefix = iv.substr(0, 4);
+        samePrefix = samePrefix && iv.substr(0, 4) == prefix;
+        ivs.insert(iv);
+        encrypted++;
+    }
+    CHECK(samePrefix);
+    CHECK((int)ivs.size() == encrypted);
+}
+
+// ---- Arrow 입력 + values/offsets/validity 출력 + col_mask ----
+void testValues(hcrypt_gcm_kdf* hc, hcrypt_pool* pool, const std::vector<uint8_t>& key,
+                const std::vector<std::string>& cells, const Layout& l) {
+    int64_t size = hcrypt_table_encrypted_size_values(l.offsets.data(), kRows, kCols);
+    std::vector<uint8_t> table((size_t)size);
+    CHECK(hcrypt_encrypt_table_values_into(hc, pool, l.values.data(), (int64_t)l.values.size(),
+                                           l.offsets.data(), kRows, kCols, nullptr,
+                                           table.data(), size) == size);
+    CHECK(framedMatches(key, table, cells));
+
+    int64_t cap = hcrypt_table_decrypted_values_size(table.data(), size, kRows, kCols);
+    std::vector<uint8_t> values((size_t)cap + 1);
+    std::vector<int64_t> offsets(kCells + 1);
+    std::vector<uint8_t> validity((kCells + 7) / 8);
+    int64_t n = hcrypt_decrypt_table_values_into(hc, pool, table.data(), size, kRows, kCols, nullptr,
+                                                 values.data(), cap, offsets.data(), validity.data());
+    CHECK(n == (int64_t)l.values.size());
+    CHECK(valuesMatch(values.data(), offsets.data(), validity.data(), cells));
+
+    // 열 1 만 선택 → 나머지는 빈 셀 + SKIPPED
+    uint8_t mask = 0x02;
+    std::vector<uint8_t> status(kCells, 0xff);
+    hcrypt_table_opts opts = {};
+    opts.col_mask = &mask;
+    opts.cell_status = status.data();
+    n = hcrypt_decrypt_table_values_into(hc, pool, table.data(), size, kRows, kCols, &opts,
+                                         values.data(), cap, offsets.data(), validity.data());
+    std::vector<std::string> picked(cells);
+    bool statusOk = true;
+    for (int i = 0; i < kCells; i++) {
+        if (i % kCols != 1) picked[i].clear();
+        statusOk = statusOk && status[i] == (i % kCols == 1 ? HCRYPT_CELL_OK : HCRYPT_CELL_SKIPPED);
+    }
+    CHECK(n >= 0 && valuesMatch(values.data(), offsets.data(), validity.data(), picked));
+    CHECK(statusOk);
+}
+
+// ---- Base64 입출력 ----
+void testBase64(hcrypt_gcm_kdf* hc, hcrypt_pool* pool, const std::vector<uint8_t>& key,
+                const std::vector<std::string>& cells, const Layout& l) {
+    int64_t size = hcrypt_table_encrypted_b64_size(l.offsets.data(), kRows, kCols);
+    std::vector<uint8_t> b64((size_t)size);
+    std::vector<int64_t> b64Offsets(kCells + 1);
+    CHECK(hcrypt_encrypt_table_b64_into(hc, pool, l.values.data(), (int64_t)l.values.size(),
+                                        l.offsets.data(), kRows, kCols, nullptr,
+                                        b64.data(), size, b64Offsets.data()) == size);
+    bool evpOk = true;
+    for (int i = 0; i < kCells; i++) {
+        std::vector<uint8_t> enc = b64Decode(b64.data() + b64Offsets[i],
+                                             (size_t)(b64Offsets[i + 1] - b64Offsets[i]));
+        std::string plain;
+        evpOk = evpOk && (cells[i].empty() ? enc.empty()
+                                           : evpDecrypt(key, enc.data(), enc.size(), plain) &&
+                                             plain == cells[i]);
+    }
+    CHECK(evpOk);
+
+    int64_t cap = hcrypt_table_decrypted_b64_size(b64.data(), size, b64Offsets.data(), kRows, kCols);
+    std::vector<uint8_t> values((size_t)cap + 1);
+    std::vector<int64_t> offsets(kCells + 1);
+    std::vector<uint8_t> validity((kCells + 7) / 8);
+    CHECK(hcrypt_decrypt_table_b64_into(hc, pool, b64.data(), size, b64Offsets.data(), kRows, kCols,
+                                        nullptr, values.data(), cap, offsets.data(),
+                                        validity.data()) == (int64_t)l.values.size());
+    CHECK(valuesMatch(values.data(), offsets.data(), validity.data(), cells));
+
+    // 잘못된 글자: 기본은 전체 실패, cell_status 면 그 셀만 BAD_BASE64
+    int bad = 7;  // 평문 5000 바이트 셀
+    std::vector<uint8_t> broken(b64);
+    broken[(size_t)b64Offsets[bad] + 5] = '*';
+    CHECK(hcrypt_decrypt_table_b64_into(hc, pool, broken.data(), size, b64Offsets.data(), kRows,
+                                        kCols, nullptr, values.data(), cap, offsets.data(),
+                                        validity.data()) == -1);
+    std::vector<uint8_t> status(kCells, 0xff);
+    int64_t failed = -1;
+    hcrypt_table_opts opts = {};
+    opts.cell_status = status.data();
+    opts.failed_cells = &failed;
+    CHECK(hcrypt_decrypt_table_b64_into(hc, pool, broken.data(), size, b64Offsets.data(), kRows,
+                                        kCols, &opts, values.data(), cap, offsets.data(),
+                                        validity.data()) >= 0);
+    CHECK(status[bad] == HCRYPT_CELL_BAD_BASE64 && failed == 1);
+    CHECK(status[bad + 1] == HCRYPT_CELL_OK && !((validity[bad / 8] >> (bad % 8)) & 1));
+
+    // 길이가 4의 배수가 아닌 셀 (잘린 값) - 글자 오류와 같이 그 셀만 BAD_BASE64, 평문 0 바이트
+    std::vector<uint8_t> cut(b64.begin(), b64.begin() + b64Offsets[bad]);
+    cut.insert(cut.end(), { 'A', 'B', 'C', 'D', 'E' });
+    std::vector<int64_t> cutOffsets(b64Offsets.begin(), b64Offsets.begin() + bad + 1);
+    cutOffsets.push_back(b64Offsets[bad] + 5);
+    for (int i = bad + 1; i < kCells; i++) {
+        cut.insert(cut.end(), b64.begin() + b64Offsets[i], b64.begin() + b64Offsets[i + 1]);
+        cutOffsets.push_back((int64_t)cut.size());
+    }
+    int64_t cutLen = (int64_t)cut.size();
+    int64_t cutCap = hcrypt_table_decrypted_b64_size(cut.data(), cutLen, cutOffsets.data(), kRows, kCols);
+    CHECK(cutCap == (int64_t)(l.values.size() - cells[bad].size()));
+    CHECK(hcrypt_decrypt_table_b64_into(hc, pool, cut.data(), cutLen, cutOffsets.data(), kRows, kCols,
+                                        nullptr, values.data(), cap, offsets.data(),
+                                        validity.data()) == -1);
+    status.assign(kCells, 0xff);
+    failed = -1;
+    CHECK(hcrypt_decrypt_table_b64_into(hc, pool, cut.data(), cutLen, cutOffsets.data(), kRows, kCols,
+                                        &opts, values.data(), cutCap, offsets.data(),
+                                        validity.data()) == cutCap);
+    CHECK(status[bad] == HCRYPT_CELL_BAD_BASE64 && failed == 1);
+    std::vector<std::string> expect(cells);
+    expect[bad].clear();
+    CHECK(valuesMatch(values.data(), offsets.data(), validity.data(), expect));
+
+    int outLen = 0;
+    uint8_t* alloc = hcrypt_decrypt_table_b64_alloc(hc, pool, cut.data(), cutLen, cutOffsets.data(),
+                                                    kRows, kCols, &opts, offsets.data(),
+                                                    validity.data(), &outLen);
+    CHECK(alloc && outLen == cutCap && status[bad] == HCRYPT_CELL_BAD_BASE64);
+    hcrypt_free(alloc);
+}
+
+// ---- 셀별 상태 (태그 불일치 / 길이 오류) ----
+void testCellStatus(hcrypt_gcm_kdf* hc, hcrypt_pool* pool, const std::vector<std::string>& cells,
+                    const Layout& l) {
+    std::vector<uint8_t> table = encryptFramed(hc, pool, l);
+    std::vector<int64_t> starts = cellStarts(table);
+
+    // 작은 셀(13바이트)과 큰 셀(5000바이트) 하나씩 태그 위조
+    int small = -1, large = -1;
+    for (int i = 0; i < kCells; i++) {
+        if (cells[i].size() == 13 && small < 0) small = i;
+        if (cells[i].size() == 5000 && large < 0) large = i;
+    }
+    CHECK(small >= 0 && large >= 0);
+    for (int i : { small, large }) {
+        table[(size_t)(starts[i] + 4 + readI32(table.data() + starts[i]) - 1)] ^= 0x01;
+    }
+
+    int64_t size = (int64_t)table.size();
+    int64_t cap = hcrypt_table_decrypted_values_size(table.data(), size, kRows, kCols);
+    std::vector<uint8_t> values((size_t)cap + 1);
+    std::vector<int64_t> offsets(kCells + 1);
+    std::vector<uint8_t> validity((kCells + 7) / 8);
+    CHECK(hcrypt_decrypt_table_values_into(hc, pool, table.data(), size, kRows, kCols, nullptr,
+                                           values.data(), cap, offsets.data(), validity.data()) == -1);
+
+    std::vector<uint8_t> status(kCells, 0xff);
+    int64_t failed = -1;
+    hcrypt_table_opts opts = {};
+    opts.cell_status = status.data();
+    opts.failed_cells = &failed;
+    CHECK(hcrypt_decrypt_table_values_into(hc, pool, table.data(), size, kRows, kCols, &opts,
+                                           values.data(), cap, offsets.data(), validity.data()) >= 0);
+    CHECK(failed == 2);
+    CHECK(status[small] == HCRYPT_CELL_TAG_MISMATCH && status[large] == HCRYPT_CELL_TAG_MISMATCH);
+    std::vector<std::string> expect(cells);
+    expect[small].assign(cells[small].size(), '\0');
+    expect[large].assign(cells[large].size(), '\0');
+    bool rest = true;
+    for (int i = 0; i < kCells; i++) {
+        std::string got(reinterpret_cast<char*>(values.data()) + offsets[i],
+                        (size_t)(offsets[i + 1] - offsets[i]));
+        bool valid = (validity[i / 8] >> (i % 8)) & 1;
+        rest = rest && got == expect[i] &&
+               valid == (i != small && i != large && !cells[i].empty());
+    }
+    CHECK(rest);
+
+    // alloc 진입점: opts 없으면 실패, cell_status 주면 결과 반환 (mt 와 풀이 같은 결과)
+    int len = 0;
+    CHECK(hcrypt_decrypt_table_pool_alloc_opts(hc, pool, table.data(), (int)size, kRows, kCols,
+                                               nullptr, &len) == nullptr);
+    std::vector<uint8_t> results[2];
+    for (int k = 0; k < 2; k++) {
+        std::fill(status.begin(), status.end(), 0xff);
+        failed = -1;
+        uint8_t* out = k == 0
+            ? hcrypt_decrypt_table_mt_alloc_opts(hc, table.data(), (int)size, kRows, kCols, 4,
+                                                 &opts, &len)
+            : hcrypt_decrypt_table_pool_alloc_opts(hc, pool, table.data(), (int)size, kRows,
+                                                   kCols, &opts, &len);
+        CHECK(out && failed == 2 && status[small] == HCRYPT_CELL_TAG_MISMATCH &&
+              status[large] == HCRYPT_CELL_TAG_MISMATCH);
+        if (out) results[k].assign(out, out + len);
+        hcrypt_free(out);
+    }
+    CHECK(!results[0].empty() && results[0] == results[1]);
+}
+
+// ---- IV + 태그보다 짧은 셀 (encSize 5) ----
+//  - cell_status 없이: 모든 진입점에서 예전처럼 빈 셀 (단일 스레드/mt/풀 결과가 같아야 함)
+//  - cell_status 있으면: BAD_LENGTH
+void testShortCell(hcrypt_gcm_kdf* hc, hcrypt_pool* pool) {
+    const std::vector<uint8_t> blob = { 5, 0, 0, 0, 1, 2, 3, 4, 5 };
+    const int64_t blobLen = (int64_t)blob.size();
+    const std::string b64 = "AQIDBAU=";
+    const int64_t b64Offsets[2] = { 0, (int64_t)b64.size() };
+    const uint8_t* b64Data = reinterpret_cast<const uint8_t*>(b64.data());
+    auto emptyFramed = [](const uint8_t* out, int len) {
+        return out && len == 4 && readI32(out) == 0;
+    };
+
+    int len = -1;
+    uint8_t* out = hcrypt_decrypt_table_alloc(hc, blob.data(), (int)blobLen, 1, 1, &len);
+    CHECK(out && len == 0);
+    hcrypt_free(out);
+    out = hcrypt_decrypt_table_mt_alloc(hc, blob.data(), (int)blobLen, 1, 1, 2, &len);
+    CHECK(emptyFramed(out, len));
+    hcrypt_free(out);
+    out = hcrypt_decrypt_table_mt_alloc_opts(hc, blob.data(), (int)blobLen, 1, 1, 2, nullptr, &len);
+    CHECK(emptyFramed(out, len));
+    hcrypt_free(out);
+    out = hcrypt_decrypt_table_pool_alloc(hc, pool, blob.data(), (int)blobLen, 1, 1, &len);
+    CHECK(emptyFramed(out, len));
+    hcrypt_free(out);
+    out = hcrypt_decrypt_table_pool_alloc_opts(hc, pool, blob.data(), (int)blobLen, 1, 1, nullptr,
+                                               &len);
+    CHECK(emptyFramed(out, len));
+    hcrypt_free(out);
+
+    uint8_t framed[16];
+    CHECK(hcrypt_decrypt_table_into(hc, pool, blob.data(), blobLen, 1, 1, nullptr, framed,
+                                    sizeof(framed)) == 4 && readI32(framed) == 0);
+    uint8_t values[16];
+    int64_t offsets[2] = { -1, -1 };
+    uint8_t validity = 0xff;
+    CHECK(hcrypt_decrypt_table_values_into(hc, pool, blob.data(), blobLen, 1, 1, nullptr, values,
+                                           sizeof(values), offsets, &validity) == 0);
+    CHECK(offsets[1] == 0 && (validity & 1) == 0);
+    validity = 0xff;
+    CHECK(hcrypt_decrypt_table_b64_into(hc, pool, b64Data, (int64_t)b64.size(), b64Offsets, 1, 1,
+                                        nullptr, values, sizeof(values), offsets, &validity) == 0);
+    CHECK(offsets[1] == 0 && (validity & 1) == 0);
+
+    uint8_t st = 0xff;
+    int64_t failed = -1;
+    hcrypt_table_opts one = {};
+    one.cell_status = &st;
+    one.failed_cells = &failed;
+    CHECK(hcrypt_decrypt_table_into(hc, pool, blob.data(), blobLen, 1, 1, &one, framed,
+                                    sizeof(framed)) == 4);
+    CHECK(st == HCRYPT_CELL_BAD_LENGTH && failed == 1);
+    st = 0xff;
+    out = hcrypt_decrypt_table_pool_alloc_opts(hc, pool, blob.data(), (int)blobLen, 1, 1, &one, &len);
+    CHECK(emptyFramed(out, len) && st == HCRYPT_CELL_BAD_LENGTH);
+    hcrypt_free(out);
+    st = 0xff;
+    CHECK(hcrypt_decrypt_table_values_into(hc, pool, blob.data(), blobLen, 1, 1, &one, values,
+                                           sizeof(values), offsets, &validity) == 0);
+    CHECK(st == HCRYPT_CELL_BAD_LENGTH);
+    st = 0xff;
+    CHECK(hcrypt_decrypt_table_b64_into(hc, pool, b64Data, (int64_t)b64.size(), b64Offsets, 1, 1,
+                                        &one, values, sizeof(values), offsets, &validity) == 0);
+    CHECK(st == HCRYPT_CELL_BAD_LENGTH);
+}
+
+// ---- 스트리밍 암호화 ----
+void testStream(hcrypt_gcm_kdf* hc, hcrypt_pool* pool, const std::vector<uint8_t>& key,
+                const std::vector<std::string>& cells, const Layout& l) {
+    hcrypt_stream* s = hcrypt_stream_begin(hc, pool, kCols, HCRYPT_STREAM_FRAMED, 16 * 1024, nullptr);
+    CHECK(s != nullptr);
+    if (!s) return;
+
+    std::vector<uint8_t> framed;
+    int64_t nextRow = 0;
+    bool ordered = true;
+    auto drain = [&](int wait) {
+        hcrypt_stream_chunk chunk;
+        while (hcrypt_stream_pull_output(s, wait, &chunk) == 1) {
+            ordered = ordered && chunk.first_row == nextRow;
+            nextRow += chunk.row_count;
+            framed.insert(framed.end(), chunk.data, chunk.data + chunk.data_len);
+        }
+    };
+    // 7행씩 push (window 가 차면 결과를 먼저 꺼냄)
+    for (int r = 0; r < kRows; r += 7) {
+        int rows = std::min(7, kRows - r);
+        std::vector<int64_t> offs(l.offsets.begin() + r * kCols,
+                                  l.offsets.begin() + (r + rows) * kCols + 1);
+        int64_t base = offs[0];
+        for (auto &o : offs) o -= base;
+        int rc;
+        while ((rc = hcrypt_stream_push_rows(s, l.values.data() + base, offs.back(), offs.data(),
+                                             rows)) == 0) {
+            drain(1);
+        }
+        CHECK(rc == 1);
+    }
+    drain(1);
+    CHECK(hcrypt_stream_finish(s) == kRows);
+    CHECK(ordered && nextRow == kRows);
+    CHECK(framedMatches(key, framed, cells));
+}
+
+// ---- 행 인덱스 컨테이너 ----
+void testRowIndex(hcrypt_gcm_kdf* hc, hcrypt_pool* pool, const std::vector<std::string>& cells,
+                  const Layout& l) {
+    int blobLen = 0;
+    uint8_t* blob = hcrypt_encrypt_table_container_alloc(hc, pool, l.values.data(),
+                                                         (int64_t)l.values.size(), l.offsets.data(),
+                                                         kRows, kCols, nullptr, &blobLen);
+    CHECK(blob != nullptr);
+    if (!blob) return;
+
+    int rows = 0, cols = 0;
+    CHECK(hcrypt_table_container_info(blob, blobLen, &rows, &cols) == 0 && rows == kRows && cols == kCols);
+
+    const int first = 11, count = 9;
+    int64_t cap = hcrypt_rows_decrypted_size(blob, blobLen, first, count);
+    std::vector<uint8_t> values((size_t)cap + 1);
+    std::vector<int64_t> offsets(count * kCols + 1);
+    std::vector<uint8_t> validity((count * kCols + 7) / 8);
+    CHECK(hcrypt_decrypt_rows_into(hc, pool, blob, blobLen, first, count, nullptr, values.data(), cap,
+                                   offsets.data(), validity.data()) >= 0);
+    std::vector<std::string> expect(cells.begin() + first * kCols,
+                                    cells.begin() + (first + count) * kCols);
+    CHECK(valuesMatch(values.data(), offsets.data(), validity.data(), expect));
+    CHECK(hcrypt_rows_decrypted_size(blob, blobLen, kRows - 1, 2) == -1);
+
+    // 예전 blob(본문만) 뒤에 인덱스를 붙여도 같은 결과
+    std::vector<uint8_t> body = encryptFramed(hc, pool, l);
+    int64_t indexSize = hcrypt_table_index_size(kRows);
+    std::vector<uint8_t> index((size_t)indexSize);
+    CHECK(hcrypt_table_build_index(pool, body.data(), (int64_t)body.size(), kRows, kCols,
+                                   index.data(), indexSize) == indexSize);
+    body.insert(body.end(), index.begin(), index.end());
+    CHECK(hcrypt_decrypt_rows_into(hc, pool, body.data(), (int64_t)body.size(), first, count, nullptr,
+                                   values.data(), cap, offsets.data(), validity.data()) >= 0);
+    CHECK(valuesMatch(values.data(), offsets.data(), validity.data(), expect));
+    hcrypt_free(blob);
+}
+
+// ---- 지연 복호화 핸들 ----
+void testLazyTable(hcrypt_gcm_kdf* hc, const std::vector<std::string>& cells, const Layout& l) {
+    std::vector<uint8_t> table = encryptFramed(hc, nullptr, l);
+    hcrypt_table* t = hcrypt_table_open(hc, table.data(), (int64_t)table.size(), kRows, kCols, 4096);
+    CHECK(t != nullptr);
+    if (!t) return;
+
+    // 뒤에서부터 두 번 읽어 LRU 적중/교체 경로 모두 거침
+    bool same = true;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = kCells - 1; i >= 0; i--) {
+            const uint8_t* data = nullptr;
+            int len = -1;
+            same = same && hcrypt_table_get_cell(t, i / kCols, i % kCols, &data, &len) == 0 &&
+                   std::string(reinterpret_cast<const char*>(data), (size_t)len) == cells[i];
+        }
+    }
+    CHECK(same);
+    const uint8_t* data = nullptr;
+    int len = 0;
+    CHECK(hcrypt_table_get_cell(t, kRows, 0, &data, &len) == -1);
+    hcrypt_table_close(t);
+
+    // 위조한 셀만 -1
+    std::vector<int64_t> starts = cellStarts(table);
+    int bad = 7;
+    table[(size_t)(starts[bad] + 4 + 12)] ^= 0x01;
+    t = hcrypt_table_open(hc, table.data(), (int64_t)table.size(), kRows, kCols, 0);
+    CHECK(t && hcrypt_table_get_cell(t, bad / kCols, bad % kCols, &data, &len) == -1);
+    CHECK(t && hcrypt_table_get_cell(t, 0, 0, &data, &len) == 0);
+    hcrypt_table_close(t);
+
+    // encSize 1~27 (잘린 셀)은 빈 셀이 아니라 오류, encSize 0 만 빈 셀
+    std::vector<uint8_t> blob = { 0, 0, 0, 0, 5, 0, 0, 0, 1, 2, 3, 4, 5 };
+    t = hcrypt_table_open(hc, blob.data(), (int64_t)blob.size(), 1, 2, 0);
+    CHECK(t && hcrypt_table_get_cell(t, 0, 0, &data, &len) == 0 && len == 0);
+    CHECK(t && hcrypt_table_get_cell(t, 0, 1, &data, &len) == -1);
+    hcrypt_table_close(t);
+}
+
+// ---- 비동기 작업 ----
+void testJobs(hcrypt_gcm_kdf* hc, hcrypt_pool* pool, const std::vector<uint8_t>& key,
+              const std::vector<std::string>& cells, const Layout& l) {
+    int64_t enc = hcrypt_submit_encrypt_table_values(hc, pool, l.values.data(), (int64_t)l.values.size(),
+                                                     l.offsets.data(), kRows, kCols, nullptr);
+    CHECK(enc > 0);
+    CHECK(hcrypt_job_wait(enc, -1) == 1);
+    hcrypt_job_output r = {};
+    CHECK(hcrypt_job_result(enc, &r) == 0);
+    std::vector<uint8_t> table(r.data, r.data + r.data_len);
+    hcrypt_job_release(enc);
+    CHECK(framedMatches(key, table, cells));
+
+    // 한 셀을 위조하고 셀별 상태로 복호화
+    std::vector<int64_t> starts = cellStarts(table);
+    int bad = 4;
+    table[(size_t)(starts[bad] + 4 + 12)] ^= 0x01;
+    uint8_t marker = 0;
+    hcrypt_table_opts opts = {};
+    opts.cell_status = &marker;
+    int64_t dec = hcrypt_submit_decrypt_table_values(hc, pool, table.data(), (int64_t)table.size(),
+                                                     kRows, kCols, &opts);
+    CHECK(dec > 0);
+    table.assign(table.size(), 0);  // submit 이 입력을 복사했는지
+    CHECK(hcrypt_job_wait(dec, -1) == 1);
+    CHECK(hcrypt_job_result(dec, &r) == 0);
+    CHECK(r.cell_status && r.cell_status[bad] == HCRYPT_CELL_TAG_MISMATCH && r.failed_cells == 1);
+    bool rest = r.offsets && r.validity;
+    for (int i = 0; rest && i < kCells; i++) {
+        if (i == bad) continue;
+        std::string got(reinterpret_cast<const char*>(r.data) + r.offsets[i],
+                        (size_t)(r.offsets[i + 1] - r.offsets[i]));
+        rest = got == cells[i];
+    }
+    CHECK(rest);
+    hcrypt_job_release(dec);
+    CHECK(hcrypt_job_poll(dec) == -1);
+}
+
+// ---- 공유 복호화 캐시 / 파생 키 캐시 (/dev/shm) ----
+void testShmCaches(hcrypt_gcm_kdf* hc, const std::vector<std::string>& cells, const Layout& l) {
+    std::string name = "/hcrypt_test_cells_" + std::to_string(getpid());
+    CHECK(hcrypt_cache_attach(name.c_str(), 1 << 20) == 0);
+    CHECK(hcrypt_cache_attach(name.c_str(), 1 << 20) == 0);
+    CHECK(hcrypt_cache_attach(name.c_str(), 2 << 20) == -1);
+
+    std::vector<uint8_t> table = encryptFramed(hc, nullptr, l);
+    int64_t size = (int64_t)table.size();
+    int64_t cap = hcrypt_table_decrypted_values_size(table.data(), size, kRows, kCols);
+    std::vector<uint8_t> values((size_t)cap + 1);
+    std::vector<int64_t> offsets(kCells + 1);
+    std::vector<uint8_t> validity((kCells + 7) / 8);
+    hcrypt_cache_stats before = {}, after = {};
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) CHECK(hcrypt_cache_get_stats(&before) == 0);
+        CHECK(hcrypt_decrypt_table_values_into(hc, nullptr, table.data(), size, kRows, kCols, nullptr,
+                                               values.data(), cap, offsets.data(), validity.data()) >= 0);
+        CHECK(valuesMatch(values.data(), offsets.data(), validity.data(), cells));
+    }
+    CHECK(hcrypt_cache_get_stats(&after) == 0);
+    CHECK(before.inserts > 0 && after.hits > before.hits);
+
+    // 캐시에 있는 셀이라도 위조하면 다시 인증해서 실패
+    std::vector<int64_t> starts = cellStarts(table);
+    int small = -1;
+    for (int i = 0; i < kCells && small < 0; i++) {
+        if (cells[i].size() == 13) small = i;
+    }
+    table[(size_t)(starts[small] + 4 + 12)] ^= 0x01;
+    CHECK(hcrypt_decrypt_table_values_into(hc, nullptr, table.data(), size, kRows, kCols, nullptr,
+                                           values.data(), cap, offsets.data(), validity.data()) == -1);
+    hcrypt_cache_detach();
+    CHECK(hcrypt_cache_unlink(name.c_str()) == 0);
+
+    // 파생 키 캐시: 두 번째부터 적중, 키는 PKCS5_PBKDF2_HMAC 와 같음
+    std::string keyName = "/hcrypt_test_keys_" + std::to_string(getpid());
+    CHECK(hcrypt_keycache_attach(keyName.c_str()) == 0);
+    const char* password = "hcrypt-test-password";
+    std::vector<uint8_t> salt = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    std::vector<uint8_t> expect(32);
+    PKCS5_PBKDF2_HMAC(password, (int)std::strlen(password), salt.data(), (int)salt.size(), 1000,
+                      EVP_sha256(), 32, expect.data());
+    hcrypt_gcm_kdf a, b;
+    CHECK(hcrypt_derive_key_cached(&a, password, salt.data(), (int)salt.size(), 32, 1000) == 0);
+    CHECK(hcrypt_derive_key_cached(&b, password, salt.data(), (int)salt.size(), 32, 1000) == 1);
+    CHECK(a.getKey() == expect && b.getKey() == expect);
+    CHECK(hcrypt_keycache_invalidate(password, salt.data(), (int)salt.size(), 32, 1000) > 0);
+    CHECK(hcrypt_derive_key_cached(&b, password, salt.data(), (int)salt.size(), 32, 1000) == 0);
+    hcrypt_keycache_clear();
+    hcrypt_keycache_detach();
+    CHECK(hcrypt_keycache_unlink(keyName.c_str()) == 0);
+}
+
+// ---- 128/192비트 키: 무작위/카운터 nonce 모두 EVP 와 일치 ----
+void testKeySizes(hcrypt_pool* pool, const std::vector<std::string>& cells, const Layout& l) {
+    for (int keyLen : { 16, 24 }) {
+        std::vector<uint8_t> key((size_t)keyLen);
+        for (int i = 0; i < keyLen; i++) key[i] = (uint8_t)(i * 29 + keyLen);
+        hcrypt_gcm_kdf* h = hcrypt_new();
+        hcrypt_setKey(h, key.data(), keyLen);
+
+        std::string msg = "key-size-" + std::to_string(keyLen);
+        int encLen = 0;
+        uint8_t* enc = hcrypt_encrypt_alloc(h, reinterpret_cast<const uint8_t*>(msg.data()),
+                                            (int)msg.size(), &encLen);
+        std::string plain;
+        CHECK(enc && evpDecrypt(key, enc, (size_t)encLen, plain) && plain == msg);
+        hcrypt_free(enc);
+
+        for (int mode : { HCRYPT_NONCE_RANDOM, HCRYPT_NONCE_COUNTER }) {
+            hcrypt_table_opts opts = {};
+            opts.nonce_mode = mode;
+            for (hcrypt_pool* p : { (hcrypt_pool*)nullptr, pool }) {
+                std::vector<uint8_t> table = encryptFramed(h, p, l, &opts);
+                CHECK(!table.empty() && framedMatches(key, table, cells));
+
+                int64_t size = hcrypt_table_decrypted_size(table.data(), (int64_t)table.size(),
+                                                           kRows, kCols);
+                std::vector<uint8_t> out((size_t)std::max<int64_t>(size, 0));
+                CHECK(size >= 0 &&
+                      hcrypt_decrypt_table_into(h, p, table.data(), (int64_t)table.size(), kRows,
+                                                kCols, nullptr, out.data(), size) == size);
+            }
+        }
+        hcrypt_delete(h);
+    }
+}
+
+// ---- 키 재설정/삭제: 스레드별 컨텍스트 캐시가 옛 키를 쓰지 않음 ----
+void testRekey(hcrypt_pool* pool, const std::vector<std::string>& cells, const Layout& l) {
+    bool same = true;
+    for (int round = 0; round < 8; round++) {
+        hcrypt_gcm_kdf* h = hcrypt_new();
+        for (int k = 0; k < 2; k++) {
+            std::vector<uint8_t> key(32);
+            for (int i = 0; i < 32; i++) key[i] = (uint8_t)(i * 7 + round * 31 + k * 101);
+            hcrypt_setKey(h, key.data(), (int)key.size());
+            std::vector<uint8_t> table = encryptFramed(h, pool, l);
+            same = same && !table.empty() && framedMatches(key, table, cells);
+        }
+        hcrypt_delete(h);
+    }
+    CHECK(same);
+}
+
+// ---- 다중 PBKDF2 ----
+void testKeyBatch(hcrypt_pool* pool) {
+    const int count = 19;
+    std::vector<std::string> passwords;
+    std::vector<std::vector<uint8_t>> salts;
+    std::vector<const char*> pw;
+    std::vector<const uint8_t*> sp;
+    std::vector<int> saltLens, iters;
+    for (int i = 0; i < count; i++) {
+        passwords.push_back("pw" + std::to_string(i * 31));
+        salts.push_back(std::vector<uint8_t>(8 + i % 5, (uint8_t)i));
+        iters.push_back(100 + i * 13);
+    }
+    for (int i = 0; i < count; i++) {
+        pw.push_back(passwords[i].c_str());
+        sp.push_back(salts[i].data());
+        saltLens.push_back((int)salts[i].size());
+    }
+    std::vector<uint8_t> keys(count * 32);
+    CHECK(hcrypt_derive_keys_batch(pool, count, pw.data(), sp.data(), saltLens.data(), iters.data(),
+                                   32, keys.data()) == 0);
+    bool same = true;
+    for (int i = 0; i < count; i++) {
+        uint8_t expect[32];
+        PKCS5_PBKDF2_HMAC(pw[i], (int)passwords[i].size(), sp[i], saltLens[i], iters[i],
+                          EVP_sha256(), 32, expect);
+        same = same && std::memcmp(expect, keys.data() + i * 32, 32) == 0;
+    }
+    CHECK(same);
+}
+
+// ---- 성능 카운터: 알려진 호출 수만큼 움직이고 Prometheus 텍스트는 형식대로 ----
+//  - # HELP/# TYPE 줄과 `이름{라벨="값",...} 숫자` 줄만 있고, 샘플마다 앞에 TYPE 이 있어야 함
+bool parsePrometheus(const std::string& text, std::map<std::string, double>& samples) {
+    static const std::regex kComment(R"(# (HELP|TYPE) ([a-zA-Z_:][a-zA-Z0-9_:]*) (.+))");
+    static const std::regex kSample(
+        R"(([a-zA-Z_:][a-zA-Z0-9_:]*)(\{[a-zA-Z_][a-zA-Z0-9_]*="[^"]*"(,[a-zA-Z_][a-zA-Z0-9_]*="[^"]*")*\})? ([-+0-9.eE]+))");
+    std::set<std::string> typed;
+    std::istringstream in(text);
+    std::string line;
+    std::smatch m;
+    while (std::getline(in, line)) {
+        if (std::regex_match(line, m, kComment)) {
+            if (m[1] == "TYPE") {
+                if (m[3] != "counter" && m[3] != "gauge") return false;
+                typed.insert(m[2]);
+            }
+        } else if (std::regex_match(line, m, kSample)) {
+            if (!typed.count(m[1])) return false;
+            samples[m[1].str() + m[2].str()] = std::stod(m[4]);
+        } else {
+            return false;
+        }
+    }
+    return !samples.empty();
+}
+
+void testStats(hcrypt_gcm_kdf* hc, hcrypt_pool* pool, const Layout& l) {
+    int wasOn = hcrypt_stats_enabled();
+    hcrypt_stats_enable(1);
+    hcrypt_stats_reset();
+
+    // 단일 암호화 5번 + 복호화 5번 + 위조 복호화 1번
+    std::string msg = "010-1234-5678";
+    const int n = 5;
+    int encLen = 0, decLen = 0;
+    uint8_t* enc = nullptr;
+    for (int i = 0; i < n; i++) {
+        hcrypt_free(enc);
+        enc = hcrypt_encrypt_alloc(hc, reinterpret_cast<const uint8_t*>(msg.data()),
+                                   (int)msg.size(), &encLen);
+    }
+    for (int i = 0; enc && i < n; i++) {
+        hcrypt_free(hcrypt_decrypt_alloc(hc, enc, encLen, &decLen));
+    }
+    if (enc) enc[encLen - 1] ^= 1;
+    CHECK(enc && hcrypt_decrypt_alloc(hc, enc, encLen, &decLen) == nullptr);
+    hcrypt_free(enc);
+
+    hcrypt_stats st = {};
+    CHECK(hcrypt_stats_snapshot(&st) == 0);
+    CHECK(st.calls == 2 * n + 1);
+    CHECK(st.cells == 2 * n);
+    CHECK(st.plain_bytes == 2 * n * msg.size());
+    CHECK(st.cipher_bytes == 2 * n * (msg.size() + 28));
+    CHECK(st.tag_failures == 1);
+    CHECK(st.ns_aes_gcm > 0);
+
+    // 테이블 호출은 워커 수와 상관없이 한 번
+    CHECK(!encryptFramed(hc, pool, l).empty());
+    hcrypt_stats table = {};
+    CHECK(hcrypt_stats_snapshot(&table) == 0);
+    CHECK(table.calls == st.calls + 1 && table.cells > st.cells);
+
+    // Prometheus 텍스트: 크기 질의 → 잘림 → 전체
+    int64_t len = hcrypt_stats_prometheus(nullptr, 0);
+    CHECK(len > 0);
+    std::vector<char> small(16, 'x');
+    CHECK(hcrypt_stats_prometheus(small.data(), (int64_t)small.size()) == len && small[15] == '\0');
+    std::vector<char> buf((size_t)len + 1);
+    CHECK(hcrypt_stats_prometheus(buf.data(), (int64_t)buf.size()) == len);
+    std::map<std::string, double> samples;
+    CHECK(parsePrometheus(std::string(buf.data(), (size_t)len), samples));
+    CHECK(samples["hcrypt_calls_total"] == (double)table.calls);
+    CHECK(samples["hcrypt_tag_failures_total"] == 1.0);
+    CHECK(samples.count("hcrypt_phase_seconds_total{phase=\"aes_gcm\"}") == 1);
+    CHECK(samples["hcrypt_stats_enabled"] == 1.0);
+
+    // 꺼져 있으면 움직이지 않고, reset 뒤에는 0 부터
+    hcrypt_stats_enable(0);
+    enc = hcrypt_encrypt_alloc(hc, reinterpret_cast<const uint8_t*>(msg.data()),
+                               (int)msg.size(), &encLen);
+    hcrypt_free(enc);
+    CHECK(hcrypt_stats_snapshot(&st) == 0 && st.calls == table.calls);
+    hcrypt_stats_reset();
+    CHECK(hcrypt_stats_snapshot(&st) == 0 && st.calls == 0 && st.cells == 0);
+    hcrypt_stats_enable(wasOn);
+}
+
+// ---- 추적 덤프: 올바른 JSON + 기대한 이벤트 이름 ----
+//  - 검사용 최소 JSON 파서 (문자열 이스케이프는 \" \\ 만 쓰므로 그 정도만)
+struct Json {
+    enum Type { kNull, kBool, kNumber, kString, kArray, kObject } type = kNull;
+    double number = 0;
+    std::string str;
+    std::vector<Json> items;
+    std::map<std::string, Json> fields;
+
+    const Json* get(const std::string& k) const {
+        auto it = fields.find(k);
+        return it == fields.end() ? nullptr : &it->second;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : s(text), pos(0) {}
+
+    bool parse(Json& out) {
+        if (!value(out)) return false;
+        skipSpace();
+        return pos == s.size();
+    }
+
+private:
+    const std::string& s;
+    size_t pos;
+
+    void skipSpace() {
+        while (pos < s.size() && std::strchr(" \t\r\n", s[pos])) pos++;
+    }
+    bool eat(char c) {
+        skipSpace();
+        if (pos < s.size() && s[pos] == c) { pos++; return true; }
+        return false;
+    }
+    bool string(std::string& out) {
+        if (!eat('"')) return false;
+        while (pos < s.size() && s[pos] != '"') {
+            if (s[pos] == '\\') {
+                if (++pos >= s.size()) return false;
+            } else if ((unsigned char)s[pos] < 0x20) {
+                return false;
+            }
+            out.push_back(s[pos++]);
+        }
+        return eat('"');
+    }
+    bool value(Json& out) {
+        skipSpace();
+        if (pos >= s.size()) return false;
+        char c = s[pos];
+        if (c == '{') {
+            out.type = Json::kObject;
+            pos++;
+            if (eat('}')) return true;
+            do {
+                std::string k;
+                Json v;
+                if (!string(k) || !eat(':') || !value(v)) return false;
+                out.fields[k] = v;
+            } while (eat(','));
+            return eat('}');
+        }
+        if (c == '[') {
+            out.type = Json::kArray;
+            pos++;
+            if (eat(']')) return true;
+            do {
+                out.items.emplace_back();
+                if (!value(out.items.back())) return false;
+            } while (eat(','));
+            return eat(']');
+        }
+        if (c == '"') {
+            out.type = Json::kString;
+            return string(out.str);
+        }
+        for (const char* word : { "true", "false", "null" }) {
+            if (s.compare(pos, std::strlen(word), word) == 0) {
+                out.type = word[0] == 'n' ? Json::kNull : Json::kBool;
+                pos += std::strlen(word);
+                return true;
+            }
+        }
+        size_t used = 0;
+        try {
+            out.number = std::stod(s.substr(pos, 32), &used);
+        } catch (const std::exception&) {
+            return false;
+        }
+        out.type = Json::kNumber;
+        pos += used;
+        return used > 0;
+    }
+};
+
+// 덤프 → traceEvents 배열 (형식이 틀리면 false)
+bool traceEvents(std::vector<Json>& events) {
+    int64_t len = hcrypt_trace_dump_json(nullptr, 0);
+    if (len <= 0) return false;
+    std::vector<char> buf((size_t)len + 1);
+    if (hcrypt_trace_dump_json(buf.data(), (int64_t)buf.size()) != len) return false;
+    Json root;
+    if (!JsonParser(std::string(buf.data(), (size_t)len)).parse(root)) return false;
+    const Json* list = root.get("traceEvents");
+    if (root.type != Json::kObject || !list || list->type != Json::kArray) return false;
+    for (const Json& e : list->items) {
+        const Json* name = e.get("name");
+        const Json* ph = e.get("ph");
+        const Json* ts = e.get("ts");
+        const Json* dur = e.get("dur");
+        const Json* args = e.get("args");
+        const Json* call = args ? args->get("call") : nullptr;
+        if (!name || name->type != Json::kString || !ph || ph->str != "X" ||
+            !ts || ts->type != Json::kNumber || !dur || dur->type != Json::kNumber ||
+            dur->number < 0 || !call || call->type != Json::kNumber) {
+            return false;
+        }
+    }
+    events = list->items;
+    return true;
+}
+
+void testTrace(hcrypt_gcm_kdf* hc, hcrypt_pool* pool, const std::vector<std::string>& cells,
+               const Layout& l) {
+    int wasOn = hcrypt_trace_enabled();
+    hcrypt_trace_enable(1);
+    hcrypt_trace_clear();
+
+    std::vector<Json> events;
+    CHECK(traceEvents(events) && events.empty());
+
+    // 풀 암호화 (호출/plan/chunk) + values 복호화 alloc (alloc/validity 포함)
+    std::vector<uint8_t> table = encryptFramed(hc, pool, l);
+    CHECK(!table.empty());
+    std::vector<int64_t> offsets(kCells + 1);
+    std::vector<uint8_t> validity((kCells + 7) / 8);
+    int outLen = 0;
+    uint8_t* values = hcrypt_decrypt_table_values_alloc(hc, pool, table.data(),
+                                                        (int64_t)table.size(), kRows, kCols,
+                                                        nullptr, offsets.data(), validity.data(),
+                                                        &outLen);
+    CHECK(values && valuesMatch(values, offsets.data(), validity.data(), cells));
+    hcrypt_free(values);
+
+    CHECK(traceEvents(events));
+    std::map<std::string, std::set<double>> callsByName;
+    for (const Json& e : events) {
+        callsByName[e.get("name")->str].insert(e.get("args")->get("call")->number);
+    }
+    for (const char* name : { "hcrypt_encrypt_table_into", "hcrypt_decrypt_table_values_alloc",
+                              "plan", "chunk", "alloc", "validity" }) {
+        CHECK(callsByName.count(name) == 1);
+    }
+    // chunk 는 두 호출 모두에서, 호출 이벤트와 같은 call 번호
+    std::set<double> calls = callsByName["hcrypt_encrypt_table_into"];
+    calls.insert(callsByName["hcrypt_decrypt_table_values_alloc"].begin(),
+                 callsByName["hcrypt_decrypt_table_values_alloc"].end());
+    CHECK(calls.size() == 2 && callsByName["chunk"] == calls);
+
+    // 꺼져 있으면 기록하지 않음, clear 뒤에는 비어 있음
+    hcrypt_trace_enable(0);
+    CHECK(!encryptFramed(hc, pool, l).empty());
+    std::vector<Json> after;
+    CHECK(traceEvents(after) && after.size() == events.size());
+    hcrypt_trace_clear();
+    CHECK(traceEvents(after) && after.empty());
+    hcrypt_trace_enable(wasOn);
+}
+
+} // namespace
+
+int main() {
+    hcrypt_library_init();
+
+    // HCRYPT_FORCE_ISA 로 고른 단계를 CPU 가 지원하지 않으면 건너뜀 (make check 가 단계마다 실행)
+    hcrypt_capabilities caps = {};
+    hcrypt_get_capabilities(&caps);
+    static const char* const kIsaNames[] = { "scalar", "sse4.1", "avx2", "avx512" };
+    const char* forced = std::getenv("HCRYPT_FORCE_ISA");
+    if (forced && *forced) {
+        int want = -1;
+        for (int i = 0; i < 4; i++) {
+            if (std::strcmp(forced, kIsaNames[i]) == 0) want = i;
+        }
+        if (want < 0) {
+            std::cout << "unknown HCRYPT_FORCE_ISA: " << forced << std::endl;
+            return 1;
+        }
+        if (want > caps.detected_level) {
+            std::cout << "skip: " << forced << " not supported by this CPU" << std::endl;
+            return 0;
+        }
+        CHECK(caps.active_level == want);
+    }
+    std::vector<uint8_t> key(32);
+    for (int i = 0; i < 32; i++) key[i] = (uint8_t)(i * 13 + 7);
+    hcrypt_gcm_kdf* hc = hcrypt_new();
+    hcrypt_setKey(hc, key.data(), (int)key.size());
+    hcrypt_pool* pool = hcrypt_pool_create(3);
+
+    std::vector<std::string> cells = makeCells();
+    Layout l = layoutOf(cells);
+
+    testRoundTrip(hc, pool, key, cells, l);
+    testCounterNonce(hc, key, cells, l);
+    testValues(hc, pool, key, cells, l);
+    testBase64(hc, pool, key, cells, l);
+    testCellStatus(hc, pool, cells, l);
+    testShortCell(hc, pool);
+    testStream(hc, pool, key, cells, l);
+    testStream(hc, nullptr, key, cells, l);  // 공용 풀
+    testRowIndex(hc, pool, cells, l);
+    testLazyTable(hc, cells, l);
+    testJobs(hc, pool, key, cells, l);
+    testShmCaches(hc, cells, l);
+    testKeyBatch(pool);
+    testKeySizes(pool, cells, l);
+    testRekey(pool, cells, l);
+    testStats(hc, pool, l);
+    testTrace(hc, pool, cells, l);
+
+    hcrypt_pool_destroy(pool);
+    hcrypt_delete(hc);
+    if (g_failures > 0) {
+        std::cout << g_failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all checks passed (" << kIsaNames[caps.active_level] << ", small_gcm "
+              << caps.small_gcm << ")" << std::endl;
+    return 0;
+}
+
+//g++ -std=c++17 -O2 hcrypt_test.cpp aes_gcm_multi.cpp -o hcrypt_test -lssl -lcrypto -pthread
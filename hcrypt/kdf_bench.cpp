@@ -0,0 +1,106 @@
+// kdf_bench.cpp
+//  - PBKDF2-HMAC-SHA256 여러 건 파생 속도 비교 (캐시 워밍업 상황)
+//    scalar : 예전 방식 - 건마다 PKCS5_PBKDF2_HMAC 를 차례로 호출
+//    batch  : hcrypt_derive_keys_batch (SIMD 다중 레인, pool 없음)
+//    pool   : hcrypt_derive_keys_batch + 스레드 풀
+//
+//  결과가 PKCS5_PBKDF2_HMAC 와 다르면 실패로 종료
+#include "aes_gcm_multi.h"
+
+#include <openssl/evp.h>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+struct Jobs {
+    std::vector<std::string> passwords;
+    std::vector<std::vector<uint8_t>> salts;
+    std::vector<const char*> pwPtrs;
+    std::vector<const uint8_t*> saltPtrs;
+    std::vector<int> saltLens;
+    std::vector<int> iterations;
+};
+
+Jobs makeJobs(int count, int iteration) {
+    Jobs j;
+    for (int i = 0; i < count; i++) {
+        j.passwords.push_back("user-password-" + std::to_string(i * 7919));
+        j.salts.emplace_back(16, (uint8_t)(i * 31 + 7));
+    }
+    for (int i = 0; i < count; i++) {
+        j.pwPtrs.push_back(j.passwords[i].c_str());
+        j.saltPtrs.push_back(j.salts[i].data());
+        j.saltLens.push_back((int)j.salts[i].size());
+        j.iterations.push_back(iteration);
+    }
+    return j;
+}
+
+double runScalar(const Jobs& j, int keyLen, std::vector<uint8_t>& out) {
+    int count = (int)j.passwords.size();
+    out.assign((size_t)count * keyLen, 0);
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        PKCS5_PBKDF2_HMAC(j.pwPtrs[i], (int)j.passwords[i].size(), j.saltPtrs[i], j.saltLens[i],
+                          j.iterations[i], EVP_sha256(), keyLen, out.data() + (size_t)i * keyLen);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+double runBatch(hcrypt_pool* pool, const Jobs& j, int keyLen, std::vector<uint8_t>& out) {
+    int count = (int)j.passwords.size();
+    out.assign((size_t)count * keyLen, 0);
+    auto begin = std::chrono::steady_clock::now();
+    int rc = hcrypt_derive_keys_batch(pool, count, j.pwPtrs.data(), j.saltPtrs.data(),
+                                      j.saltLens.data(), j.iterations.data(), keyLen, out.data());
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    if (rc != 0) {
+        std::cerr << "[runBatch] 파생 실패" << std::endl;
+    }
+    return sec;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? std::atoi(argv[1]) : 64;
+    int iteration = argc > 2 ? std::atoi(argv[2]) : 10000;
+    int threads = argc > 3 ? std::atoi(argv[3]) : (int)std::thread::hardware_concurrency();
+    if (count < 1) count = 1;
+    if (threads < 1) threads = 1;
+    const int keyLen = 32;
+
+    Jobs jobs = makeJobs(count, iteration);
+    std::vector<uint8_t> expected, got;
+
+    std::cout << "count=" << count << " iteration=" << iteration << " threads=" << threads << std::endl;
+    std::cout << "mode\tsec\tms/key\tspeedup" << std::endl;
+
+    double s = runScalar(jobs, keyLen, expected);
+    std::cout << "scalar\t" << s << "\t" << s * 1000 / count << "\t1" << std::endl;
+
+    double b = runBatch(nullptr, jobs, keyLen, got);
+    bool ok = got == expected;
+    std::cout << "batch\t" << b << "\t" << b * 1000 / count << "\t" << s / b << std::endl;
+
+    hcrypt_pool* pool = hcrypt_pool_create(threads - 1);
+    double p = runBatch(pool, jobs, keyLen, got);
+    ok = ok && got == expected;
+    std::cout << "pool\t" << p << "\t" << p * 1000 / count << "\t" << s / p << std::endl;
+    hcrypt_pool_destroy(pool);
+
+    if (!ok) {
+        std::cerr << "결과가 PKCS5_PBKDF2_HMAC 와 다릅니다." << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+//g++ -std=c++17 -O2 kdf_bench.cpp aes_gcm_multi.cpp -o kdf_bench -lssl -lcrypto -pthread
@@ -0,0 +1,114 @@
+// small_cell_bench.cpp
+//  - 작은 셀(전화번호 13바이트 등) 암/복호화 속도 비교
+//    per-cell : 예전 dummy_test.cpp 와 같은 방식 - 셀마다 hc.encrypt / hc.decrypt (EVP)
+//    table    : hcrypt_encrypt_table_into / hcrypt_decrypt_table_into (pool 없음)
+//               64바이트 이하 셀은 멀티 버퍼 AES-GCM 엔진으로 8개씩 처리
+//  - AES-128/192/256 키마다 (setKey 에서 고르는 특수화별로) 한 줄씩
+//
+//  셀 길이: 전화번호 "010-XXXX-XXXX" (13바이트), 인자로 고정 길이를 줄 수도 있음
+#include "aes_gcm_multi.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+
+namespace {
+
+std::vector<std::string> makeCells(int count, int fixedLen) {
+    std::vector<std::string> cells;
+    cells.reserve(count);
+    for (int i = 0; i < count; i++) {
+        if (fixedLen > 0) {
+            cells.emplace_back(fixedLen, (char)('a' + i % 26));
+        } else {
+            int part1 = 1000 + (i % 9000);
+            int part2 = 1000 + ((i / 9000) % 9000);
+            cells.emplace_back("010-" + std::to_string(part1) + "-" + std::to_string(part2));
+        }
+    }
+    return cells;
+}
+
+double seconds(std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+struct Result {
+    double encCell, decCell, encTable, decTable;
+};
+
+bool runKey(int keyLen, const std::vector<std::string>& cells, Result& r) {
+    int count = (int)cells.size();
+    hcrypt_gcm_kdf hc;
+    hc.setKey(std::vector<uint8_t>(keyLen, 0x42));
+
+    std::vector<const uint8_t*> ptrs;
+    std::vector<int> sizes;
+    for (auto &cell : cells) {
+        ptrs.push_back(reinterpret_cast<const uint8_t*>(cell.data()));
+        sizes.push_back((int)cell.size());
+    }
+
+    // per-cell (EVP)
+    std::vector<std::vector<uint8_t>> encrypted;
+    encrypted.reserve(count);
+    auto begin = std::chrono::steady_clock::now();
+    for (auto &cell : cells) {
+        encrypted.push_back(hc.encrypt(std::vector<uint8_t>(cell.begin(), cell.end())));
+    }
+    r.encCell = seconds(begin);
+
+    begin = std::chrono::steady_clock::now();
+    size_t checksum = 0;
+    for (auto &enc : encrypted) {
+        checksum += hc.decrypt(enc).size();
+    }
+    r.decCell = seconds(begin);
+
+    // table kernel (키 길이별 특수화)
+    int64_t encSize = hcrypt_table_encrypted_size(sizes.data(), count, 1);
+    std::vector<uint8_t> table(encSize);
+    begin = std::chrono::steady_clock::now();
+    int64_t written = hcrypt_encrypt_table_into(&hc, nullptr, ptrs.data(), sizes.data(), count, 1,
+                                                nullptr, table.data(), encSize);
+    r.encTable = seconds(begin);
+
+    int64_t decSize = hcrypt_table_decrypted_size(table.data(), encSize, count, 1);
+    std::vector<uint8_t> plain(decSize > 0 ? decSize : 1);
+    begin = std::chrono::steady_clock::now();
+    int64_t read = hcrypt_decrypt_table_into(&hc, nullptr, table.data(), encSize, count, 1,
+                                             nullptr, plain.data(), decSize);
+    r.decTable = seconds(begin);
+
+    return written == encSize && read == decSize && checksum > 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? std::atoi(argv[1]) : 200000;
+    int fixedLen = argc > 2 ? std::atoi(argv[2]) : 0;
+    if (count < 1) count = 1;
+
+    std::vector<std::string> cells = makeCells(count, fixedLen);
+
+    std::cout << "cells=" << count << " len=" << cells[0].size() << " (Mcells/s)" << std::endl;
+    std::cout << "key\tenc per-cell\tenc table\tspeedup\tdec per-cell\tdec table\tspeedup" << std::endl;
+    for (int keyLen : { 16, 24, 32 }) {
+        Result r;
+        if (!runKey(keyLen, cells, r)) {
+            std::cerr << "암/복호화 실패 (key=" << keyLen * 8 << ")" << std::endl;
+            return 1;
+        }
+        std::cout << "aes" << keyLen * 8
+                  << "\t" << count / r.encCell / 1e6 << "\t" << count / r.encTable / 1e6
+                  << "\t" << r.encCell / r.encTable
+                  << "\t" << count / r.decCell / 1e6 << "\t" << count / r.decTable / 1e6
+                  << "\t" << r.decCell / r.decTable << std::endl;
+    }
+    return 0;
+}
+
+//g++ -std=c++17 -O2 small_cell_bench.cpp aes_gcm_multi.cpp -o small_cell_bench -lssl -lcrypto -pthread
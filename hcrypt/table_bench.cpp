@@ -0,0 +1,130 @@
+// table_bench.cpp
+//  - 한쪽으로 치우친(skewed) 테이블에서 테이블 암호화 스레드 확장성 비교
+//    static : 예전 방식 - 셀 개수로 똑같이 나눠 스레드마다 한 구간씩
+//    pool   : hcrypt_encrypt_table_into + 스레드 풀 (바이트 기준 분할 + work-stealing)
+//
+//  테이블 모양: 120열, 대부분 8바이트 코드 셀
+//               앞쪽 1/8 행에만 긴 메모(16KB) 열 3개가 채워져 있음
+#include "aes_gcm_multi.h"
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+
+namespace {
+
+struct Table {
+    int rows;
+    int cols;
+    std::vector<std::string> cells;
+    std::vector<const uint8_t*> ptrs;
+    std::vector<int> sizes;
+};
+
+Table makeSkewedTable(int rows, int cols) {
+    Table t;
+    t.rows = rows;
+    t.cols = cols;
+    t.cells.reserve((size_t)rows * cols);
+    for (int r = 0; r < rows; r++) {
+        bool heavyRow = r < rows / 8;
+        for (int c = 0; c < cols; c++) {
+            bool memoCol = c < 3;
+            size_t len = (heavyRow && memoCol) ? 16 * 1024 : 8;
+            t.cells.emplace_back(len, (char)('a' + (r + c) % 26));
+        }
+    }
+    for (auto &cell : t.cells) {
+        t.ptrs.push_back(reinterpret_cast<const uint8_t*>(cell.data()));
+        t.sizes.push_back((int)cell.size());
+    }
+    return t;
+}
+
+// 예전 *_mt_alloc 과 같은 분할: 셀 개수 기준 연속 구간을 스레드마다 하나씩
+double runStatic(hcrypt_gcm_kdf* hc, Table& t, int threads, std::vector<uint8_t>& out) {
+    int totalCells = t.rows * t.cols;
+    int chunk = (totalCells + threads - 1) / threads;
+
+    // 구간별 출력 위치
+    std::vector<int64_t> outStart(threads + 1, 0);
+    for (int th = 0; th < threads; th++) {
+        int start = std::min(th * chunk, totalCells);
+        int end = std::min(start + chunk, totalCells);
+        int64_t sz = end > start ? hcrypt_table_encrypted_size(&t.sizes[start], 1, end - start) : 0;
+        outStart[th + 1] = outStart[th] + sz;
+    }
+    out.resize(outStart[threads]);
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int th = 0; th < threads; th++) {
+        int start = std::min(th * chunk, totalCells);
+        int end = std::min(start + chunk, totalCells);
+        if (start >= end) break;
+        workers.emplace_back([&, th, start, end] {
+            hcrypt_encrypt_table_into(hc, nullptr, &t.ptrs[start], &t.sizes[start], 1, end - start,
+                                      nullptr, out.data() + outStart[th],
+                                      outStart[th + 1] - outStart[th]);
+        });
+    }
+    for (auto &w : workers) w.join();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+double runPool(hcrypt_gcm_kdf* hc, hcrypt_pool* pool, Table& t, std::vector<uint8_t>& out) {
+    int64_t size = hcrypt_table_encrypted_size(t.sizes.data(), t.rows, t.cols);
+    out.resize(size);
+    auto begin = std::chrono::steady_clock::now();
+    int64_t written = hcrypt_encrypt_table_into(hc, pool, t.ptrs.data(), t.sizes.data(),
+                                                t.rows, t.cols, nullptr, out.data(), size);
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    if (written != size) {
+        std::cerr << "[runPool] 암호화 실패" << std::endl;
+    }
+    return sec;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int rows = argc > 1 ? std::atoi(argv[1]) : 4000;
+    int cols = 120;
+    int maxThreads = argc > 2 ? std::atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+    if (maxThreads < 1) maxThreads = 1;
+
+    hcrypt_gcm_kdf* hc = hcrypt_new();
+    std::vector<uint8_t> key(32, 0x42);
+    hcrypt_setKey(hc, key.data(), (int)key.size());
+
+    Table t = makeSkewedTable(rows, cols);
+    std::vector<uint8_t> out;
+
+    std::cout << "rows=" << rows << " cols=" << cols << std::endl;
+    std::cout << "threads\tstatic(s)\tspeedup\tpool(s)\tspeedup" << std::endl;
+
+    double static1 = 0, pool1 = 0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        hcrypt_pool* pool = hcrypt_pool_create(threads - 1);
+        runPool(hc, pool, t, out);  // 워밍업
+
+        double s = runStatic(hc, t, threads, out);
+        double p = runPool(hc, pool, t, out);
+        if (threads == 1) {
+            static1 = s;
+            pool1 = p;
+        }
+        std::cout << threads << "\t" << s << "\t" << static1 / s
+                  << "\t" << p << "\t" << pool1 / p << std::endl;
+        hcrypt_pool_destroy(pool);
+    }
+
+    hcrypt_delete(hc);
+    return 0;
+}
+
+//g++ -std=c++17 -O2 table_bench.cpp aes_gcm_multi.cpp -o table_bench -lssl -lcrypto -pthread
@@ -13,6 +13,7 @@ class AesGcmEncryptor {
     private $iteration;
     private $useBase64;
     private $threadCount;
+    private $jobs = [];   // 수거 전 비동기 작업 번호
     
     /**
      * 암호화 설정으로 인스턴스 초기화
@@ -42,6 +43,9 @@ class AesGcmEncryptor {
         try {
             $ffiCdef = "
                 typedef struct hcrypt_gcm_kdf hcrypt_gcm_kdf;
+                typedef struct hcrypt_pool hcrypt_pool;
+                typedef struct hcrypt_table_opts { int nonce_mode; const uint8_t* col_mask; uint8_t* cell_status; int64_t* failed_cells; } hcrypt_table_opts;
+                int hcrypt_library_init(void);
                 hcrypt_gcm_kdf* hcrypt_new();
                 void hcrypt_delete(hcrypt_gcm_kdf* hc);
                 void hcrypt_deriveKeyFromPassword(
@@ -61,6 +65,42 @@ class AesGcmEncryptor {
                     int threadCount,
                     int* out_len
                 );
+                uint8_t* hcrypt_encrypt_table_values_alloc(
+                    hcrypt_gcm_kdf* hc,
+                    hcrypt_pool* pool,
+                    const uint8_t* values,
+                    int64_t values_len,
+                    const int64_t* offsets,
+                    int rowCount,
+                    int colCount,
+                    const hcrypt_table_opts* opts,
+                    int* out_len
+                );
+                uint8_t* hcrypt_encrypt_table_b64_alloc(
+                    hcrypt_gcm_kdf* hc,
+                    hcrypt_pool* pool,
+                    const uint8_t* values,
+                    int64_t values_len,
+                    const int64_t* offsets,
+                    int rowCount,
+                    int colCount,
+                    const hcrypt_table_opts* opts,
+                    int64_t* out_offsets,
+                    int* out_len
+                );
+                uint8_t* hcrypt_decrypt_table_b64_alloc(
+                    hcrypt_gcm_kdf* hc,
+                    hcrypt_pool* pool,
+                    const uint8_t* b64,
+                    int64_t b64_len,
+                    const int64_t* b64_offsets,
+                    int rowCount,
+                    int colCount,
+                    const hcrypt_table_opts* opts,
+                    int64_t* offsets,
+                    uint8_t* validity,
+                    int* out_len
+                );
                 void hcrypt_free(uint8_t* data);
                 uint8_t* hcrypt_decrypt_table_mt_alloc(
                     hcrypt_gcm_kdf* hc,
@@ -71,6 +111,48 @@ class AesGcmEncryptor {
                     int threadCount,
                     int* out_len
                 );
+                typedef struct hcrypt_job_output {
+                    const uint8_t* data;
+                    int64_t data_len;
+                    const int64_t* offsets;
+                    const uint8_t* validity;
+                    const uint8_t* cell_status;
+                    int64_t failed_cells;
+                } hcrypt_job_output;
+                int64_t hcrypt_submit_encrypt_table_values(
+                    hcrypt_gcm_kdf* hc,
+                    hcrypt_pool* pool,
+                    const uint8_t* values,
+                    int64_t values_len,
+                    const int64_t* offsets,
+                    int rowCount,
+                    int colCount,
+                    const hcrypt_table_opts* opts
+                );
+                int64_t hcrypt_submit_encrypt_table_b64(
+                    hcrypt_gcm_kdf* hc,
+                    hcrypt_pool* pool,
+                    const uint8_t* values,
+                    int64_t values_len,
+                    const int64_t* offsets,
+                    int rowCount,
+                    int colCount,
+                    const hcrypt_table_opts* opts
+                );
+                int64_t hcrypt_submit_decrypt_table_b64(
+                    hcrypt_gcm_kdf* hc,
+                    hcrypt_pool* pool,
+                    const uint8_t* b64,
+                    int64_t b64_len,
+                    const int64_t* b64_offsets,
+                    int rowCount,
+                    int colCount,
+                    const hcrypt_table_opts* opts
+                );
+                int hcrypt_job_poll(int64_t job_id);
+                int hcrypt_job_wait(int64_t job_id, int timeout_ms);
+                int hcrypt_job_result(int64_t job_id, hcrypt_job_output* result);
+                void hcrypt_job_release(int64_t job_id);
             ";
             $this->ffi = FFI::cdef($ffiCdef, $soPath);
         } catch (\FFI\ParserException $ex) {
@@ -79,6 +161,11 @@ class AesGcmEncryptor {
             throw new Exception("암호화 라이브러리 로딩 실패: " . $ex->getMessage());
         }
         
+        // OpenSSL 초기화 + AES-GCM 객체 미리 가져오기 (프로세스당 한 번, 이후 호출은 바로 반환)
+        if ($this->ffi->hcrypt_library_init() !== 0) {
+            throw new Exception("암호화 라이브러리 초기화 실패");
+        }
+        
         // 암호화 컨텍스트 생성 및 KDF 호출
         $this->hc = $this->ffi->hcrypt_new();
         if (FFI::isNull($this->hc)) {
@@ -96,99 +183,150 @@ class AesGcmEncryptor {
      * 2D 데이터 배열 암호화
      */
     public function encryptData($dataArray, $useColumns) {
+        return $this->collectEncrypt($this->submitEncrypt($dataArray, $useColumns));
+    }
+    
+    /**
+     * 2D 데이터 배열 암호화를 라이브러리 공용 풀에 넘기고 바로 반환 (결과는 collectEncrypt)
+     *  - 공용 풀은 프로세스당 하나 (인스턴스마다 스레드를 만들지 않음)
+     *  - 입력은 라이브러리가 복사하므로 반환 뒤 $dataArray 를 버려도 됨
+     *  - 그동안 앞 청크 INSERT 등 DB 작업을 진행
+     */
+    public function submitEncrypt($dataArray, $useColumns) {
         $rowCount = count($dataArray);
         if ($rowCount == 0) {
-            return [];
+            return ['job' => 0, 'rows' => 0, 'cols' => $useColumns];
         }
         
-        // 2D 배열 -> C 포인터 변환
+        // 2D 배열 -> values 버퍼 1개 + int64 오프셋 배열 (셀마다 따로 할당하지 않음)
         $totalCells = $rowCount * $useColumns;
-        try {
-            $table_c = $this->ffi->new("const uint8_t*[$totalCells]");
-            $size_c = $this->ffi->new("int[$totalCells]");
-        } catch (\FFI\Exception $ex) {
-            throw new Exception("메모리 할당 실패: " . $ex->getMessage());
-        }
-        
-        $cellIndex = 0;
+        $cells = [];
+        $offsets = [0];
+        $pos = 0;
         foreach ($dataArray as $rowData) {
             for ($c = 0; $c < $useColumns; $c++) {
                 $plainVal = isset($rowData[$c]) ? (string)$rowData[$c] : '';
-                $valLen = strlen($plainVal);
-                $size_c[$cellIndex] = $valLen;
-                if ($valLen > 0) {
-                    try {
-                        $plain_c = $this->ffi->new("uint8_t[$valLen]", false);
-                        FFI::memcpy($plain_c, $plainVal, $valLen);
-                        $table_c[$cellIndex] = $plain_c;
-                    } catch (\FFI\Exception $ex) {
-                        throw new Exception("셀 메모리 할당 실패: " . $ex->getMessage());
-                    }
-                } else {
-                    $table_c[$cellIndex] = null;
-                }
-                $cellIndex++;
+                $cells[] = $plainVal;
+                $pos += strlen($plainVal);
+                $offsets[] = $pos;
             }
         }
+        $values = implode('', $cells);
+        unset($cells);
         
-        // 암호화 실행
-        $out_len_c = $this->ffi->new("int", false);
         try {
-            $enc_ptr = $this->ffi->hcrypt_encrypt_table_mt_alloc(
-                $this->hc, $table_c, $size_c, $rowCount, $useColumns, 
-                $this->threadCount, FFI::addr($out_len_c)
+            $values_c = $this->ffi->new("uint8_t[" . max(1, $pos) . "]");
+            FFI::memcpy($values_c, $values, $pos);
+            $offsets_c = $this->ffi->new("int64_t[" . ($totalCells + 1) . "]");
+            FFI::memcpy($offsets_c, pack('q*', ...$offsets), 8 * ($totalCells + 1));
+        } catch (\FFI\Exception $ex) {
+            throw new Exception("메모리 할당 실패: " . $ex->getMessage());
+        }
+        unset($values, $offsets);
+        
+        // Base64 면 암호문을 C++ 워커에서 바로 Base64 로 받음 (셀별 base64_encode 없음)
+        if ($this->useBase64) {
+            $jobId = $this->ffi->hcrypt_submit_encrypt_table_b64(
+                $this->hc, null /* 공용 풀 */, $values_c, $pos, $offsets_c, $rowCount, $useColumns, null
             );
-            
-            if (FFI::isNull($enc_ptr)) {
-                throw new Exception("암호화 실패");
-            }
-            
-            $encSize = $out_len_c->cdata;
-            $encBin = FFI::string($enc_ptr, $encSize);
-            $this->ffi->hcrypt_free($enc_ptr);
-            
-            // 암호문 분할 및 재구성
-            $offset = 0;
+        } else {
+            $jobId = $this->ffi->hcrypt_submit_encrypt_table_values(
+                $this->hc, null /* 공용 풀 */, $values_c, $pos, $offsets_c, $rowCount, $useColumns, null
+            );
+        }
+        if ($jobId <= 0) {
+            throw new Exception("암호화 실패");
+        }
+        $this->jobs[$jobId] = true;
+        
+        return ['job' => $jobId, 'rows' => $rowCount, 'cols' => $useColumns];
+    }
+    
+    /**
+     * submitEncrypt 결과를 기다려서 암호문 2D 배열로 반환
+     */
+    public function collectEncrypt($handle) {
+        if ($handle['job'] == 0) {
+            return [];
+        }
+        $rowCount = $handle['rows'];
+        $useColumns = $handle['cols'];
+        $totalCells = $rowCount * $useColumns;
+        
+        try {
+            $out = $this->waitJob($handle['job'], "암호화 실패");
+            $encBin = FFI::string($out->data, $out->data_len);
+            $encOffsets = $this->useBase64
+                ? unpack('q*', FFI::string($out->offsets, 8 * ($totalCells + 1)))
+                : null;
+            $this->releaseJob($handle['job']);
+        } catch (\FFI\Exception $ex) {
+            $this->releaseJob($handle['job']);
+            throw new Exception("암호화 처리 중 오류: " . $ex->getMessage());
+        }
+        
+        if ($this->useBase64) {
+            // 셀 i = encBin[encOffsets[i] .. encOffsets[i+1]) (unpack 결과는 1부터 시작)
             $encryptedRows = [];
-            
+            $cellIndex = 1;
             for ($r = 0; $r < $rowCount; $r++) {
                 $encRow = [];
                 for ($c = 0; $c < $useColumns; $c++) {
-                    if ($offset + 4 > $encSize) {
-                        $encRow[] = '';
-                        continue;
-                    }
-                    $encCellLenData = substr($encBin, $offset, 4);
-                    $encCellLen = unpack("l", $encCellLenData)[1];
-                    $offset += 4;
-                    
-                    if ($offset + $encCellLen > $encSize) {
-                        $encRow[] = '';
-                        continue;
-                    }
-                    
-                    $cipherData = substr($encBin, $offset, $encCellLen);
-                    $offset += $encCellLen;
-                    $encRow[] = ($this->useBase64 && $encCellLen > 0) ? base64_encode($cipherData) : $cipherData;
+                    $start = $encOffsets[$cellIndex];
+                    $len = $encOffsets[$cellIndex + 1] - $start;
+                    $encRow[] = $len > 0 ? substr($encBin, $start, $len) : '';
+                    $cellIndex++;
                 }
                 $encryptedRows[] = $encRow;
             }
-            
             return $encryptedRows;
-        } catch (\FFI\Exception $ex) {
-            if (isset($enc_ptr) && !FFI::isNull($enc_ptr)) {
-                $this->ffi->hcrypt_free($enc_ptr);
+        }
+        
+        // 암호문 분할 및 재구성
+        $encSize = strlen($encBin);
+        $offset = 0;
+        $encryptedRows = [];
+        
+        for ($r = 0; $r < $rowCount; $r++) {
+            $encRow = [];
+            for ($c = 0; $c < $useColumns; $c++) {
+                if ($offset + 4 > $encSize) {
+                    $encRow[] = '';
+                    continue;
+                }
+                $encCellLenData = substr($encBin, $offset, 4);
+                $encCellLen = unpack("l", $encCellLenData)[1];
+                $offset += 4;
+                
+                if ($offset + $encCellLen > $encSize) {
+                    $encRow[] = '';
+                    continue;
+                }
+                
+                $cipherData = substr($encBin, $offset, $encCellLen);
+                $offset += $encCellLen;
+                $encRow[] = $cipherData;
             }
-            throw new Exception("암호화 처리 중 오류: " . $ex->getMessage());
+            $encryptedRows[] = $encRow;
         }
+        
+        return $encryptedRows;
     }
     
     /**
      * 암호화된 데이터 복호화
      */
     public function decryptData($encryptedData) {
+        return $this->collectDecrypt($this->submitDecrypt($encryptedData));
+    }
+    
+    /**
+     * 복호화를 워커 스레드 풀에 넘기고 바로 반환 (결과는 collectDecrypt)
+     *  - 그동안 다음 페이지/테이블 SELECT 를 진행
+     */
+    public function submitDecrypt($encryptedData) {
         if (empty($encryptedData)) {
-            return [];
+            return ['job' => 0, 'data' => []];
         }
         
         try {
@@ -199,110 +337,163 @@ class AesGcmEncryptor {
             
             worker_log("복호화 시작: 행=$rowCount, 열=$colCount");
             
-            // 암호화된 데이터를 한 덩어리로 수집
-            $encDataBin = '';
-            $cellCounter = 0;
+            // Base64 암호문을 그대로 한 덩어리로 수집 (디코딩은 C++ 워커에서)
+            $cells = [];
+            $b64Offsets = [0];
+            $b64Len = 0;
             
             // 모든 행과 열을 순회하며 데이터 수집
             foreach ($encryptedData as $row) {
                 foreach ($headerKeys as $key) {
-                    $cellData = isset($row[$key]) ? $row[$key] : '';
-                    
-                    // Base64 복호화 
-                    $bin = @base64_decode($cellData, true);
-                    if ($bin === false) {
-                        worker_log("경고: 유효하지 않은 Base64 인코딩 데이터 발견, 빈 값으로 대체");
-                        $bin = '';
-                    }                    
-                    // 데이터 추가
-                    $encDataBin .= $bin;
-                    $cellCounter++;
+                    $cellData = isset($row[$key]) ? (string)$row[$key] : '';
+                    $cells[] = $cellData;
+                    $b64Len += strlen($cellData);
+                    $b64Offsets[] = $b64Len;
                 }
             }
+            $cellCounter = count($cells);
             
             // 데이터가 없으면 원본 반환
-            if (empty($encDataBin)) {
-                return $encryptedData;
+            if ($b64Len === 0) {
+                return ['job' => 0, 'data' => $encryptedData];
             }
             
-            worker_log("총 셀 데이터: $cellCounter, 크기: " . strlen($encDataBin) . "바이트");
+            worker_log("총 셀 데이터: $cellCounter, 크기: " . $b64Len . "바이트");
             
-            // 암호화된 데이터를 C 배열로 변환
-            $enc_data = $this->ffi->new("uint8_t[" . strlen($encDataBin) . "]");
-            FFI::memcpy($enc_data, $encDataBin, strlen($encDataBin));
+            // Base64 암호문 + 오프셋을 C 배열로 변환
+            $totalCells = $rowCount * $colCount;
+            $b64_c = $this->ffi->new("uint8_t[$b64Len]");
+            FFI::memcpy($b64_c, implode('', $cells), $b64Len);
+            unset($cells);
+            $b64_offsets_c = $this->ffi->new("int64_t[" . ($totalCells + 1) . "]");
+            FFI::memcpy($b64_offsets_c, pack('q*', ...$b64Offsets), 8 * ($totalCells + 1));
+            unset($b64Offsets);
             
-            // 출력 길이 변수
-            $out_len = $this->ffi->new("int");
+            // 셀별 상태: 위조/손상 셀이 있어도 나머지는 복호화 (해당 셀만 null)
+            //  - 비동기 작업은 상태 배열을 라이브러리가 가짐 (cell_status 는 사용 표시)
+            $status_c = $this->ffi->new("uint8_t[1]");
+            $opts = $this->ffi->new("hcrypt_table_opts");
+            $opts->cell_status = $this->ffi->cast("uint8_t*", FFI::addr($status_c));
             
-            // 복호화 함수 호출
-            worker_log("hcrypt_decrypt_table_mt_alloc 호출: 스레드=$this->threadCount");
-            $out_ptr = $this->ffi->hcrypt_decrypt_table_mt_alloc(
+            // 복호화 작업 제출 (Base64 디코딩 + 복호화 → 평문 values 버퍼 + offsets)
+            worker_log("hcrypt_submit_decrypt_table_b64 호출: 스레드=$this->threadCount");
+            $jobId = $this->ffi->hcrypt_submit_decrypt_table_b64(
                 $this->hc,
-                $enc_data,
-                strlen($encDataBin),
+                null, // 공용 풀
+                $b64_c,
+                $b64Len,
+                $b64_offsets_c,
                 $rowCount,
                 $colCount,
-                $this->threadCount,
-                FFI::addr($out_len)
+                FFI::addr($opts)
             );
             
-            if (FFI::isNull($out_ptr)) {
-                throw new Exception("테이블 복호화 실패: NULL 결과");
+            if ($jobId <= 0) {
+                throw new Exception("테이블 복호화 실패: 작업 제출 실패");
             }
+            $this->jobs[$jobId] = true;
             
-            // 결과 복사
-            $out_size = $out_len->cdata;
-            worker_log("복호화 완료: 결과 크기=$out_size 바이트");
-            $decrypted_bin = FFI::string($out_ptr, $out_size);
+            return ['job' => $jobId, 'rows' => $rowCount, 'keys' => $headerKeys];
             
-            // 메모리 해제
-            $this->ffi->hcrypt_free($out_ptr);
-            
-            // 결과 파싱: [길이 4바이트][데이터] 형식
-            $decryptedData = [];
-            $offset = 0;
+        } catch (\FFI\Exception $ex) {
+            throw new Exception("복호화 처리 중 오류: " . $ex->getMessage());
+        }
+    }
+    
+    /**
+     * submitDecrypt 결과를 기다려서 평문 행 배열로 반환
+     */
+    public function collectDecrypt($handle) {
+        if ($handle['job'] == 0) {
+            return $handle['data'];
+        }
+        $rowCount = $handle['rows'];
+        $headerKeys = $handle['keys'];
+        $colCount = count($headerKeys);
+        $totalCells = $rowCount * $colCount;
+        
+        try {
+            $out = $this->waitJob($handle['job'], "테이블 복호화 실패");
             
-            for ($i = 0; $i < $rowCount; $i++) {
-                $decRow = [];
-                for ($j = 0; $j < $colCount; $j++) {
-                    // 길이 정보가 없으면 빈 값
-                    if ($offset + 4 > $out_size) {
-                        $decRow[$headerKeys[$j]] = '';
-                        continue;
-                    }
-                    
-                    // 길이 읽기 (4바이트 정수)
-                    $plainLen = unpack('V', substr($decrypted_bin, $offset, 4))[1];
-                    $offset += 4;
-                    
-                    // 실제 데이터 읽기
-                    if ($plainLen > 0 && $offset + $plainLen <= $out_size) {
-                        $cellData = substr($decrypted_bin, $offset, $plainLen);
-                        $offset += $plainLen;
-                        $decRow[$headerKeys[$j]] = $cellData;
-                    } else {
-                        $decRow[$headerKeys[$j]] = '';
-                        if ($plainLen > 0) {
-                            // 사이즈가 있지만 범위를 벗어나면 안전하게 건너뛰기
-                            $offset += min($plainLen, $out_size - $offset);
-                        }
-                    }
-                }
-                $decryptedData[] = $decRow;
-            }
+            // 결과 복사
+            $out_size = $out->data_len;
+            worker_log("복호화 완료: 결과 크기=$out_size 바이트");
+            $values = FFI::string($out->data, $out_size);
             
-            worker_log("데이터 파싱 완료: " . count($decryptedData) . "행");
-            return $decryptedData;
+            // 결과 슬라이스: 셀 i = values[offsets[i] .. offsets[i+1]) (unpack 결과는 1부터 시작)
+            $offsets = unpack('q*', FFI::string($out->offsets, 8 * ($totalCells + 1)));
+            $failedCount = $out->failed_cells;
+            $status = $failedCount > 0 ? FFI::string($out->cell_status, $totalCells) : null;
             
+            // 메모리 해제
+            $this->releaseJob($handle['job']);
         } catch (\FFI\Exception $ex) {
+            $this->releaseJob($handle['job']);
             throw new Exception("복호화 처리 중 오류: " . $ex->getMessage());
         }
+        
+        if ($failedCount > 0) {
+            worker_log("복호화 실패 셀: $failedCount 개 (해당 셀은 null)");
+        }
+        $decryptedData = [];
+        $cellIndex = 1;
+        
+        for ($i = 0; $i < $rowCount; $i++) {
+            $decRow = [];
+            for ($j = 0; $j < $colCount; $j++) {
+                $start = $offsets[$cellIndex];
+                $len = $offsets[$cellIndex + 1] - $start;
+                if ($status !== null && ord($status[$cellIndex - 1]) !== 0) {
+                    $decRow[$headerKeys[$j]] = null;
+                } else {
+                    $decRow[$headerKeys[$j]] = $len > 0 ? substr($values, $start, $len) : '';
+                }
+                $cellIndex++;
+            }
+            $decryptedData[] = $decRow;
+        }
+        
+        worker_log("데이터 파싱 완료: " . count($decryptedData) . "행");
+        return $decryptedData;
+    }
+    
+    /**
+     * 제출한 작업이 끝났는지 확인 (기다리지 않음)
+     */
+    public function isDone($handle) {
+        return $handle['job'] == 0 || $this->ffi->hcrypt_job_poll($handle['job']) !== 0;
+    }
+    
+    /**
+     * 작업이 끝날 때까지 기다린 뒤 결과 구조체 반환 (포인터는 releaseJob 전까지 유효)
+     */
+    private function waitJob($jobId, $errorMessage) {
+        $out = $this->ffi->new("hcrypt_job_output");
+        if ($this->ffi->hcrypt_job_wait($jobId, -1) !== 1
+            || $this->ffi->hcrypt_job_result($jobId, FFI::addr($out)) !== 0) {
+            $this->releaseJob($jobId);
+            throw new Exception($errorMessage);
+        }
+        return $out;
+    }
+    
+    private function releaseJob($jobId) {
+        if (isset($this->jobs[$jobId])) {
+            $this->ffi->hcrypt_job_release($jobId);
+            unset($this->jobs[$jobId]);
+        }
     }
     
     /**
      * 인스턴스 소멸 시 자원 해제
      */
     public function __destruct() {
+        // 수거하지 않은 작업은 끝난 뒤 해제 (컨텍스트보다 먼저)
+        foreach (array_keys($this->jobs) as $jobId) {
+            $this->ffi->hcrypt_job_wait($jobId, -1);
+            $this->ffi->hcrypt_job_release($jobId);
+        }
+        $this->jobs = [];
         if (isset($this->hc) && !FFI::isNull($this->hc)) {
             $this->ffi->hcrypt_delete($this->hc);
         }
@@ -13,43 +13,105 @@
 #include <cstring>
 #include <mutex>
 #include <thread>
+#include <atomic>
+#include <memory>
+#include <exception>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstdio>
+#include <set>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
 #include <iostream>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <cerrno>
+#include <chrono>
+#include <pthread.h>
 
 /*******************************************************
- * 전역 상태 (OpenSSL init/cleanup)
+ * 전역 상태 (OpenSSL 초기화 / 미리 가져온 알고리즘 객체)
+ *  - call_once 로 프로세스당 한 번 → 이후 객체 생성/소멸은 잠금 없음
+ *  - OpenSSL 3 의 EVP_aes_*_gcm()/EVP_sha256() 은 Init 때마다 암묵적 fetch
+ *    (이름 조회 + 참조 카운트) → 명시적으로 fetch 한 객체를 계속 사용
+ *  - 정리(EVP_cleanup 등)는 하지 않음: OpenSSL 1.1+ 은 종료 시 자체 정리하고,
+ *    객체마다 전역 상태를 내리면 다른 스레드가 쓰는 컨텍스트가 깨질 수 있음
  *******************************************************/
-static std::mutex g_openssl_mutex;
-bool hcrypt_gcm_kdf::opensslInitialized = false;
+namespace {
 
-void hcrypt_gcm_kdf::opensslInit() {
-    std::lock_guard<std::mutex> lock(g_openssl_mutex);
-    if (!opensslInitialized) {
-        OpenSSL_add_all_algorithms();
-        ERR_load_crypto_strings();
-        opensslInitialized = true;
+struct HcryptLibrary {
+    const EVP_CIPHER* gcm128;
+    const EVP_CIPHER* gcm192;
+    const EVP_CIPHER* gcm256;
+    const EVP_MD* sha256;
+    bool ok;
+};
+
+HcryptLibrary g_library = {};
+std::once_flag g_library_once;
+
+void libraryInitOnce() {
+    OPENSSL_init_crypto(OPENSSL_INIT_LOAD_CRYPTO_STRINGS | OPENSSL_INIT_ADD_ALL_CIPHERS |
+                        OPENSSL_INIT_ADD_ALL_DIGESTS, nullptr);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    // 프로세스 끝까지 쓰므로 EVP_CIPHER_free/EVP_MD_free 하지 않음
+    g_library.gcm128 = EVP_CIPHER_fetch(nullptr, "AES-128-GCM", nullptr);
+    g_library.gcm192 = EVP_CIPHER_fetch(nullptr, "AES-192-GCM", nullptr);
+    g_library.gcm256 = EVP_CIPHER_fetch(nullptr, "AES-256-GCM", nullptr);
+    g_library.sha256 = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+#else
+    g_library.gcm128 = EVP_aes_128_gcm();
+    g_library.gcm192 = EVP_aes_192_gcm();
+    g_library.gcm256 = EVP_aes_256_gcm();
+    g_library.sha256 = EVP_sha256();
+#endif
+    g_library.ok = g_library.gcm128 && g_library.gcm192 && g_library.gcm256 && g_library.sha256;
+    if (!g_library.ok) {
+        std::cerr << "[hcrypt_library_init] OpenSSL 알고리즘을 가져오지 못했습니다." << std::endl;
     }
 }
 
-void hcrypt_gcm_kdf::opensslCleanup() {
-    std::lock_guard<std::mutex> lock(g_openssl_mutex);
-    if (opensslInitialized) {
-        EVP_cleanup();
-        ERR_free_strings();
-        opensslInitialized = false;
+const HcryptLibrary& library() {
+    std::call_once(g_library_once, libraryInitOnce);
+    return g_library;
+}
+
+const EVP_MD* sha256Md() {
+    const EVP_MD* md = library().sha256;
+    if (!md) {
+        throw std::runtime_error("SHA-256 을 가져오지 못했습니다.");
     }
+    return md;
+}
+
+// 작은 셀 엔진용 키 (8-3 참고, 엔진을 쓸 수 없는 CPU 면 NULL)
+void* newSmallGcmKey(const std::vector<uint8_t>& key);
+void freeSmallGcmKey(void* smallKey);
+
+// 스레드별 컨텍스트 캐시에 살아 있는 키 알림 (3-1 참고)
+void registerKeyId(uint64_t keyId);
+void retireKeyId(uint64_t keyId);
 }
 
 /*******************************************************
  * 1) 클래스 생성/소멸
  *******************************************************/
 hcrypt_gcm_kdf::hcrypt_gcm_kdf()
-  : evpCipher(nullptr)
+  : evpCipher(nullptr), keyCtx(nullptr), smallKey(nullptr), keyId(0), keyFingerprint(0)
 {
-    opensslInit();
+    library();
 }
 
 hcrypt_gcm_kdf::~hcrypt_gcm_kdf() {
-    opensslCleanup();
+    if (keyId) retireKeyId(keyId);
+    EVP_CIPHER_CTX_free(static_cast<EVP_CIPHER_CTX*>(keyCtx));
+    freeSmallGcmKey(smallKey);
+    OPENSSL_cleanse(key.data(), key.size());
 }
 
 /*******************************************************
@@ -67,7 +129,7 @@ void hcrypt_gcm_kdf::deriveKeyFromPassword(const std::string& password,
 
     if (!PKCS5_PBKDF2_HMAC(password.c_str(), (int)password.size(),
                            salt.data(), (int)salt.size(),
-                           iterationCount, EVP_sha256(),
+                           iterationCount, sha256Md(),
                            keyLen, derived.data()))
     {
         unsigned long errc = ERR_get_error();
@@ -83,320 +145,4341 @@ void hcrypt_gcm_kdf::deriveKeyFromPassword(const std::string& password,
 /*******************************************************
  * 3) 키 직접 설정 / 키 가져오기
  *******************************************************/
+namespace {
+// setKey 마다 증가 (스레드별 컨텍스트 캐시가 옛 키를 구분하는 데 사용)
+std::atomic<uint64_t> g_next_key_id(1);
+}
+
 void hcrypt_gcm_kdf::setKey(const std::vector<uint8_t>& keyData) {
+    const HcryptLibrary& lib = library();
+    const EVP_CIPHER* cipher = nullptr;
     switch (keyData.size()) {
     case 16:
-        evpCipher = EVP_aes_128_gcm();
+        cipher = lib.gcm128;
         break;
     case 24:
-        evpCipher = EVP_aes_192_gcm();
+        cipher = lib.gcm192;
         break;
     case 32:
-        evpCipher = EVP_aes_256_gcm();
+        cipher = lib.gcm256;
         break;
     default:
         throw std::invalid_argument("[setKey] 지원하지 않는 키 길이 (16/24/32).");
     }
-    key = keyData;
+    if (!cipher) {
+        throw std::runtime_error("[setKey] AES-GCM 을 가져오지 못했습니다.");
+    }
+
+    // 키 확장은 여기서 한 번만 → 셀마다 이 컨텍스트의 복사본에 IV만 설정
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    if (!ctx) {
+        throw std::runtime_error("[setKey] EVP_CIPHER_CTX_new 실패");
+    }
+    if (1 != EVP_EncryptInit_ex(ctx, cipher, nullptr, keyData.data(), nullptr)) {
+        EVP_CIPHER_CTX_free(ctx);
+        throw std::runtime_error("[setKey] EncryptInit_ex 실패(키 확장)");
+    }
+    void* small = nullptr;
+    try {
+        small = newSmallGcmKey(keyData);
+    } catch (...) {
+        EVP_CIPHER_CTX_free(ctx);
+        throw;
+    }
+
+    EVP_CIPHER_CTX_free(static_cast<EVP_CIPHER_CTX*>(keyCtx));
+    freeSmallGcmKey(smallKey);
+    OPENSSL_cleanse(key.data(), key.size());
+    keyCtx    = ctx;
+    smallKey  = small;
+    evpCipher = cipher;
+    key       = keyData;
+    if (keyId) retireKeyId(keyId);
+    keyId     = g_next_key_id.fetch_add(1);
+    registerKeyId(keyId);
+
+    // 공유 복호화 캐시용 키 지문 (키 자체는 캐시에 남기지 않음)
+    static const char kFpLabel[] = "hcrypt-shm-cell-cache";
+    uint8_t mac[32];
+    unsigned int macLen = 0;
+    if (!HMAC(sha256Md(), key.data(), (int)key.size(),
+              reinterpret_cast<const uint8_t*>(kFpLabel), sizeof(kFpLabel) - 1, mac, &macLen)) {
+        throw std::runtime_error("[setKey] HMAC 실패(키 지문)");
+    }
+    std::memcpy(&keyFingerprint, mac, sizeof(keyFingerprint));
+    OPENSSL_cleanse(mac, sizeof(mac));
 }
 
 std::vector<uint8_t> hcrypt_gcm_kdf::getKey() const {
     return key; // 복사본 반환
 }
 
+int hcrypt_gcm_kdf::getKeyLength() const {
+    return (int)key.size();
+}
+
 /*******************************************************
- * 4) 무작위 12바이트 IV 생성
+ * 3-1) 스레드별 컨텍스트 캐시
+ *  - 스레드마다 최근에 쓴 키 몇 개의 컨텍스트를 보관
+ *  - 키 확장된 원본(keyCtx)을 복사해 만들고, 이후에는 IV만 다시 설정
+ *  - 객체 삭제/재설정(setKey)으로 옛 키가 되면 세대 번호를 올림
+ *    → 각 스레드는 다음에 캐시를 쓸 때 세대가 바뀌었으면 살아 있지 않은 키의 컨텍스트를 해제
+ *      (공용 풀 워커처럼 오래 사는 스레드에 삭제된 객체의 라운드 키가 남지 않도록)
  *******************************************************/
-std::vector<uint8_t> hcrypt_gcm_kdf::generateRandomIV() {
-    std::vector<uint8_t> ivBuf(12);
-    if (1 != RAND_bytes(ivBuf.data(), (int)ivBuf.size())) {
-        unsigned long errc = ERR_get_error();
-        throw std::runtime_error("[generateRandomIV] RAND_bytes 실패: " +
-                                 std::string(ERR_reason_error_string(errc)));
+namespace {
+
+// 살아 있는 keyId 목록 (세대가 바뀐 스레드가 정리할 때만 잠금)
+//  - 프로세스 종료 중 소멸 순서 문제를 피하려고 일부러 해제하지 않음
+std::mutex g_live_keys_mutex;
+std::unordered_set<uint64_t>* g_live_keys = new std::unordered_set<uint64_t>();
+std::atomic<uint64_t> g_key_generation(0);
+
+void registerKeyId(uint64_t keyId) {
+    std::lock_guard<std::mutex> lock(g_live_keys_mutex);
+    g_live_keys->insert(keyId);
+}
+
+void retireKeyId(uint64_t keyId) {
+    {
+        std::lock_guard<std::mutex> lock(g_live_keys_mutex);
+        g_live_keys->erase(keyId);
     }
-    return ivBuf;
+    g_key_generation.fetch_add(1, std::memory_order_release);
+}
+
+struct ThreadCtxCache {
+    static const int kSlots = 4;
+
+    struct Entry {
+        uint64_t keyId;
+        EVP_CIPHER_CTX* ctx;
+        uint64_t lastUse;
+    };
+    Entry entries[kSlots];
+    uint64_t tick;
+    uint64_t generation;
+
+    ThreadCtxCache() : tick(0), generation(0) {
+        for (int i = 0; i < kSlots; i++) {
+            entries[i].keyId = 0;
+            entries[i].ctx = nullptr;
+            entries[i].lastUse = 0;
+        }
+    }
+    ~ThreadCtxCache() {
+        for (int i = 0; i < kSlots; i++) {
+            EVP_CIPHER_CTX_free(entries[i].ctx);
+        }
+    }
+
+    // 옛 키 컨텍스트 해제 (EVP_CIPHER_CTX_free 가 라운드 키를 지움)
+    void dropRetired() {
+        std::lock_guard<std::mutex> lock(g_live_keys_mutex);
+        for (int i = 0; i < kSlots; i++) {
+            if (entries[i].ctx && !g_live_keys->count(entries[i].keyId)) {
+                EVP_CIPHER_CTX_free(entries[i].ctx);
+                entries[i].ctx = nullptr;
+                entries[i].keyId = 0;
+                entries[i].lastUse = 0;
+            }
+        }
+    }
+
+    EVP_CIPHER_CTX* get(uint64_t keyId, const EVP_CIPHER_CTX* source) {
+        uint64_t gen = g_key_generation.load(std::memory_order_acquire);
+        if (gen != generation) {
+            generation = gen;
+            dropRetired();
+        }
+        tick++;
+        int victim = 0;
+        for (int i = 0; i < kSlots; i++) {
+            if (entries[i].ctx && entries[i].keyId == keyId) {
+                entries[i].lastUse = tick;
+                return entries[i].ctx;
+            }
+            if (entries[i].lastUse < entries[victim].lastUse) victim = i;
+        }
+
+        EVP_CIPHER_CTX* ctx = entries[victim].ctx;
+        if (!ctx) {
+            ctx = EVP_CIPHER_CTX_new();
+            if (!ctx) {
+                throw std::runtime_error("[threadCtx] EVP_CIPHER_CTX_new 실패");
+            }
+            entries[victim].ctx = ctx;
+        }
+        entries[victim].keyId = 0;
+        if (1 != EVP_CIPHER_CTX_copy(ctx, source)) {
+            throw std::runtime_error("[threadCtx] EVP_CIPHER_CTX_copy 실패");
+        }
+        entries[victim].keyId = keyId;
+        entries[victim].lastUse = tick;
+        return ctx;
+    }
+};
+
+} // namespace
+
+void* hcrypt_gcm_kdf::threadCtx() const {
+    thread_local ThreadCtxCache cache;
+    return cache.get(keyId, static_cast<const EVP_CIPHER_CTX*>(keyCtx));
 }
 
 /*******************************************************
- * 5) AES-GCM 암/복호화 (단일 청크)
+ * 3-2) 성능 카운터 (hcrypt_stats_*)
+ *  - 스레드마다 카운터 슬롯 하나 (처음 기록할 때 등록, 스레드 종료 시 합계로 접어 둠)
+ *    → 쓰는 쪽은 자기 슬롯에 relaxed load + store 만 (잠금/원자 RMW 없음)
+ *  - 꺼져 있으면 기록 지점마다 relaxed bool 하나 읽고 끝 (시계도 안 읽음)
+ *  - 켜기: 환경 변수 HCRYPT_STATS=1 또는 hcrypt_stats_enable(1)
+ *  - reset 은 그 시점 합계를 기준값으로 저장 (다른 스레드 슬롯을 건드리지 않음)
+ *  - 시간(ns)은 스레드별 합계 → 여러 스레드가 일하면 벽시계 시간보다 클 수 있음
  *******************************************************/
-// --- [빈 문자열 예외처리] 추가 ---
-std::vector<uint8_t> hcrypt_gcm_kdf::encrypt(const std::vector<uint8_t>& plaintext) {
-    if (!evpCipher) {
-        throw std::runtime_error("[encrypt] 키가 설정되지 않았습니다.");
+namespace {
+
+enum StatId {
+    kStatCalls,
+    kStatCells,
+    kStatPlainBytes,
+    kStatCipherBytes,
+    kStatTagFailures,
+    kStatNsNonce,
+    kStatNsAesGcm,
+    kStatNsOutput,
+    kStatNsAlloc,
+    kStatCount
+};
+
+bool statsEnabledFromEnv() {
+    const char* v = std::getenv("HCRYPT_STATS");
+    return v && *v && std::strcmp(v, "0") != 0;
+}
+
+std::atomic<bool> g_stats_enabled(statsEnabledFromEnv());
+
+struct StatSlot {
+    std::atomic<uint64_t> v[kStatCount];
+
+    StatSlot() {
+        for (auto &c : v) c.store(0, std::memory_order_relaxed);
     }
+};
 
-    // 빈 평문이면, 빈 결과 반환
-    if (plaintext.empty()) {
-        return {}; 
+std::mutex g_stats_mutex;
+std::vector<StatSlot*> g_stats_slots;     // 살아 있는 스레드
+uint64_t g_stats_retired[kStatCount];     // 끝난 스레드 합계
+uint64_t g_stats_base[kStatCount];        // 마지막 reset 시점 합계
+
+struct StatSlotHolder {
+    StatSlot* slot = nullptr;
+
+    ~StatSlotHolder() {
+        if (!slot) return;
+        std::lock_guard<std::mutex> lock(g_stats_mutex);
+        for (int i = 0; i < kStatCount; i++) {
+            g_stats_retired[i] += slot->v[i].load(std::memory_order_relaxed);
+        }
+        g_stats_slots.erase(std::find(g_stats_slots.begin(), g_stats_slots.end(), slot));
+        delete slot;
     }
+};
 
-    return aesEncryptGcm(plaintext);
+StatSlot& threadStats() {
+    thread_local StatSlotHolder holder;
+    if (!holder.slot) {
+        StatSlot* slot = new StatSlot();
+        std::lock_guard<std::mutex> lock(g_stats_mutex);
+        g_stats_slots.push_back(slot);
+        holder.slot = slot;
+    }
+    return *holder.slot;
 }
 
-std::vector<uint8_t> hcrypt_gcm_kdf::decrypt(const std::vector<uint8_t>& ciphertext) {
-    if (!evpCipher) {
-        throw std::runtime_error("[decrypt] 키가 설정되지 않았습니다.");
-    }
+inline bool statsOn() {
+    return g_stats_enabled.load(std::memory_order_relaxed);
+}
 
-    // GCM 최소크기(IV=12, 태그=16)보다 작으면 "빈 결과" 반환
-    if (ciphertext.size() < 12 + 16) {
-        return {};
+// 자기 슬롯만 쓰므로 RMW 대신 load + store
+inline void statBump(StatSlot& slot, StatId id, uint64_t n) {
+    slot.v[id].store(slot.v[id].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline void statAdd(StatId id, uint64_t n) {
+    if (!statsOn()) return;
+    statBump(threadStats(), id, n);
+}
+
+// 셀 count 개 처리 (평문/암호문 바이트 = IV + 태그 28바이트 차이)
+inline void statCells(uint64_t count, uint64_t plainBytes) {
+    if (!statsOn()) return;
+    StatSlot& slot = threadStats();
+    statBump(slot, kStatCells, count);
+    statBump(slot, kStatPlainBytes, plainBytes);
+    statBump(slot, kStatCipherBytes, plainBytes + count * (12 + 16));
+}
+
+inline uint64_t statNowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 범위 하나의 시간을 id 에 더함 (꺼져 있으면 시계를 읽지 않음)
+class StatTimer {
+public:
+    explicit StatTimer(StatId id) : id(id), start(statsOn() ? statNowNs() : 0) {}
+    ~StatTimer() {
+        if (start) statAdd(id, statNowNs() - start);
     }
+    StatTimer(const StatTimer&) = delete;
+    StatTimer& operator=(const StatTimer&) = delete;
+
+private:
+    StatId id;
+    uint64_t start;
+};
 
-    return aesDecryptGcm(ciphertext);
+// 모든 스레드 합계 (g_stats_mutex 를 잡은 상태에서)
+void statTotals(uint64_t out[kStatCount]) {
+    for (int i = 0; i < kStatCount; i++) out[i] = g_stats_retired[i];
+    for (StatSlot* slot : g_stats_slots) {
+        for (int i = 0; i < kStatCount; i++) out[i] += slot->v[i].load(std::memory_order_relaxed);
+    }
 }
 
+} // namespace
+
 /*******************************************************
- * 6) 내부: AES-GCM 암호화
- *    결과 = [IV(12)] + [암호문] + [태그(16)]
+ * 3-3) 추적 링 버퍼 (hcrypt_trace_*)
+ *  - 테이블 호출 하나 = 호출 번호 하나, 단계(plan/alloc/chunk/validity)마다
+ *    어느 스레드가 언제 시작/끝났는지 기록 → Chrome trace-event JSON 으로 덤프
+ *  - 고정 크기 링 (가장 최근 kTraceEvents 개), 쓰는 쪽은 번호 fetch_add 하나 + seqlock
+ *    (잠금 없음, 덮어쓰는 중인 칸은 덤프에서 건너뜀)
+ *  - 꺼져 있으면 호출 입구에서 relaxed bool 하나, 단계마다 thread_local 하나 읽고 끝
+ *  - 켜기: 환경 변수 HCRYPT_TRACE=1 또는 hcrypt_trace_enable(1)
  *******************************************************/
-std::vector<uint8_t> hcrypt_gcm_kdf::aesEncryptGcm(const std::vector<uint8_t>& plain) {
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) {
-        throw std::runtime_error("[aesEncryptGcm] EVP_CIPHER_CTX_new 실패");
-    }
+namespace {
 
-    try {
-        // 1) IV 생성
-        std::vector<uint8_t> ivBuf = generateRandomIV();
+const uint64_t kTraceEvents = 1 << 16;
 
-        // 2) 암호화 초기화
-        if (1 != EVP_EncryptInit_ex(ctx, static_cast<const EVP_CIPHER*>(evpCipher),
-                                    nullptr, nullptr, nullptr)) {
-            throw std::runtime_error("[aesEncryptGcm] EncryptInit_ex 실패(1단계)");
-        }
+// 칸 하나 (seq: 0 = 비었거나 쓰는 중, 그 외 = 기록 번호 + 1)
+struct TraceEvent {
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> call;
+    std::atomic<uint64_t> startNs;
+    std::atomic<uint64_t> endNs;
+    std::atomic<int64_t> arg;
+    std::atomic<const char*> name;
+    std::atomic<const char*> argName;
+    std::atomic<uint32_t> tid;
+};
 
-        // 3) 키/IV 설정
-        if (1 != EVP_EncryptInit_ex(ctx, nullptr, nullptr, key.data(), ivBuf.data())) {
-            throw std::runtime_error("[aesEncryptGcm] EncryptInit_ex 실패(키/IV)");
-        }
+bool traceEnabledFromEnv() {
+    const char* v = std::getenv("HCRYPT_TRACE");
+    return v && *v && std::strcmp(v, "0") != 0;
+}
 
-        // 4) 암호문 공간 ([IV] + 평문크기 + [태그])
-        std::vector<uint8_t> out;
-        out.resize(ivBuf.size() + plain.size() + 16);
+std::atomic<bool> g_trace_enabled(false);
+std::atomic<TraceEvent*> g_trace_ring(nullptr);  // 한 번 만들면 해제하지 않음
+std::atomic<uint64_t> g_trace_next(0);           // 다음 기록 번호
+std::atomic<uint64_t> g_trace_base(0);           // clear 시점 번호 (이전 기록은 덤프 안 함)
+std::atomic<uint64_t> g_trace_calls(0);
+std::mutex g_trace_mutex;
 
-        // out 맨 앞 12바이트 = IV
-        std::memcpy(out.data(), ivBuf.data(), ivBuf.size());
+thread_local uint64_t t_trace_call = 0;          // 이 스레드에서 진행 중인 호출 번호
 
-        // 5) 평문 -> 암호문
-        int len = 0;
-        uint8_t* cipherPtr = out.data() + ivBuf.size();
-        if (1 != EVP_EncryptUpdate(ctx, cipherPtr, &len,
-                                   plain.data(), (int)plain.size())) {
-            throw std::runtime_error("[aesEncryptGcm] EncryptUpdate 실패");
+void traceSetEnabled(bool on) {
+    if (on && !g_trace_ring.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(g_trace_mutex);
+        if (!g_trace_ring.load(std::memory_order_relaxed)) {
+            g_trace_ring.store(new TraceEvent[kTraceEvents](), std::memory_order_release);
         }
-        int cipherLen = len;
+    }
+    g_trace_enabled.store(on, std::memory_order_relaxed);
+}
 
-        // 6) Final
-        if (1 != EVP_EncryptFinal_ex(ctx, cipherPtr + cipherLen, &len)) {
-            throw std::runtime_error("[aesEncryptGcm] EncryptFinal 실패");
-        }
-        cipherLen += len;
+struct TraceEnvInit {
+    TraceEnvInit() {
+        if (traceEnabledFromEnv()) traceSetEnabled(true);
+    }
+} g_trace_env_init;
 
-        // 7) 태그(16바이트) 추출
-        std::vector<uint8_t> tag(16);
-        if (1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG,
-                                     (int)tag.size(), tag.data())) {
-            throw std::runtime_error("[aesEncryptGcm] GET_TAG 실패");
-        }
+inline bool traceOn() {
+    return g_trace_enabled.load(std::memory_order_relaxed);
+}
 
-        // 8) out = [IV] + [암호문(cipherLen)] + [태그(16)]
-        out.resize(ivBuf.size() + cipherLen + tag.size());
-        std::memcpy(out.data() + ivBuf.size() + cipherLen, tag.data(), tag.size());
+uint32_t traceThreadId() {
+    thread_local uint32_t tid = (uint32_t)syscall(SYS_gettid);
+    return tid;
+}
 
-        EVP_CIPHER_CTX_free(ctx);
-        std::memset(ivBuf.data(), 0, ivBuf.size());
+void traceRecord(uint64_t call, const char* name, const char* argName, int64_t arg,
+                 uint64_t startNs, uint64_t endNs) {
+    TraceEvent* ring = g_trace_ring.load(std::memory_order_acquire);
+    if (!ring) return;
+    uint64_t idx = g_trace_next.fetch_add(1, std::memory_order_relaxed);
+    TraceEvent& e = ring[idx % kTraceEvents];
+    e.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e.call.store(call, std::memory_order_relaxed);
+    e.startNs.store(startNs, std::memory_order_relaxed);
+    e.endNs.store(endNs, std::memory_order_relaxed);
+    e.arg.store(arg, std::memory_order_relaxed);
+    e.name.store(name, std::memory_order_relaxed);
+    e.argName.store(argName, std::memory_order_relaxed);
+    e.tid.store(traceThreadId(), std::memory_order_relaxed);
+    e.seq.store(idx + 1, std::memory_order_release);
+}
+
+// 이 스레드에서 진행 중인 호출 번호 (없으면 0) → 워커에 넘길 때 사용
+inline uint64_t traceCall() {
+    return t_trace_call;
+}
 
-        return out;
+// 테이블 C API 호출 하나 (바깥쪽 하나만 기록, 안쪽에서 다시 만들면 무시)
+class TraceCall {
+public:
+    explicit TraceCall(const char* name) : name(name), id(0), start(0) {
+        if (!traceOn() || t_trace_call != 0) return;
+        id = g_trace_calls.fetch_add(1, std::memory_order_relaxed) + 1;
+        t_trace_call = id;
+        start = statNowNs();
     }
-    catch (...) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw;
+    ~TraceCall() {
+        if (!id) return;
+        traceRecord(id, name, nullptr, 0, start, statNowNs());
+        t_trace_call = 0;
     }
-}
+    TraceCall(const TraceCall&) = delete;
+    TraceCall& operator=(const TraceCall&) = delete;
+
+private:
+    const char* name;
+    uint64_t id;
+    uint64_t start;
+};
+
+// 호출 안의 단계 하나 (call 이 0 이면 기록하지 않음)
+class TraceSpan {
+public:
+    TraceSpan(uint64_t call, const char* name, const char* argName = nullptr, int64_t arg = 0)
+      : call(call), name(name), argName(argName), arg(arg), start(call ? statNowNs() : 0) {}
+    ~TraceSpan() {
+        if (call) traceRecord(call, name, argName, arg, start, statNowNs());
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    uint64_t call;
+    const char* name;
+    const char* argName;
+    int64_t arg;
+    uint64_t start;
+};
+
+} // namespace
 
 /*******************************************************
- * 7) 내부: AES-GCM 복호화
+ * 4) 무작위 12바이트 IV 생성
  *******************************************************/
-std::vector<uint8_t> hcrypt_gcm_kdf::aesDecryptGcm(const std::vector<uint8_t>& cipher) {
-    if (cipher.size() < 12 + 16) {
-        throw std::runtime_error("[aesDecryptGcm] 암호문이 너무 짧습니다.");
+std::vector<uint8_t> hcrypt_gcm_kdf::generateRandomIV() {
+    std::vector<uint8_t> ivBuf(12);
+    if (1 != RAND_bytes(ivBuf.data(), (int)ivBuf.size())) {
+        unsigned long errc = ERR_get_error();
+        throw std::runtime_error("[generateRandomIV] RAND_bytes 실패: " +
+                                 std::string(ERR_reason_error_string(errc)));
     }
+    return ivBuf;
+}
 
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) {
-        throw std::runtime_error("[aesDecryptGcm] EVP_CIPHER_CTX_new 실패");
-    }
+/*******************************************************
+ * 4-1) 카운터 기반 IV (NIST SP 800-38D 8.2.1)
+ *  IV = [고정 필드 32비트] + [호출 카운터 64비트, big-endian]
+ *
+ *  - 스레드마다 고정 필드 + 카운터 시작값을 RAND_bytes로 한 번만 뽑음
+ *    (이후 셀마다 카운터 +1 → DRBG 락/호출 비용 없음)
+ *  - 프로세스 안: 살아 있는 스레드의 고정 필드를 레지스트리로 관리해 중복 없이 배정
+ *    → 같은 키를 쓰는 여러 객체/스레드 사이에서도 IV가 겹치지 않음
+ *  - fork 후: 자식은 부모의 스레드 상태를 그대로 물려받으므로
+ *    pthread_atfork로 세대 번호를 올려 다음 호출 때 새로 뽑게 함
+ *  - 프로세스 사이: 고정 필드(32비트)와 카운터 시작값(64비트)이 모두 무작위이므로
+ *    두 프로세스가 겹치려면 고정 필드가 같고 카운터 구간까지 겹쳐야 함 (사실상 불가)
+ *  - 한 번 뽑은 값으로는 최대 2^32 개만 쓰고 다시 뽑음
+ *******************************************************/
+namespace {
 
-    try {
-        // 1) IV(12), Tag(16) 추출
-        size_t totalLen = cipher.size();
-        std::vector<uint8_t> ivBuf(12);
-        std::memcpy(ivBuf.data(), cipher.data(), 12);
+const uint64_t kCounterNonceBudget = 1ULL << 32;
 
-        std::vector<uint8_t> tagBuf(16);
-        std::memcpy(tagBuf.data(), cipher.data() + (totalLen - 16), 16);
+std::mutex g_nonce_mutex;
+std::set<uint32_t> g_nonce_prefixes;   // 프로세스 안에서 사용 중인 고정 필드
+std::atomic<uint64_t> g_fork_generation(0);
 
-        // 2) 암호문 부분
-        size_t actualCipherLen = totalLen - 12 - 16;
-        const uint8_t* actualCipherPtr = cipher.data() + 12;
+void nonceAtforkPrepare() { g_nonce_mutex.lock(); }
+void nonceAtforkParent()  { g_nonce_mutex.unlock(); }
+void nonceAtforkChild() {
+    // 자식: 부모 스레드들의 고정 필드는 더 이상 이 프로세스 것이 아님
+    g_nonce_prefixes.clear();
+    g_fork_generation.fetch_add(1);
+    g_nonce_mutex.unlock();
+}
 
-        // 3) 복호화 초기화
-        if (1 != EVP_DecryptInit_ex(ctx, static_cast<const EVP_CIPHER*>(evpCipher),
-                                    nullptr, nullptr, nullptr)) {
-            throw std::runtime_error("[aesDecryptGcm] DecryptInit_ex 실패(1단계)");
-        }
-        if (1 != EVP_DecryptInit_ex(ctx, nullptr, nullptr, key.data(), ivBuf.data())) {
-            throw std::runtime_error("[aesDecryptGcm] DecryptInit_ex 실패(키/IV)");
-        }
+std::once_flag g_nonce_atfork_once;
 
-        // 4) 복호화 진행
-        std::vector<uint8_t> out(actualCipherLen);
-        int len = 0;
-        if (1 != EVP_DecryptUpdate(ctx, out.data(), &len,
-                                   actualCipherPtr, (int)actualCipherLen)) {
-            throw std::runtime_error("[aesDecryptGcm] DecryptUpdate 실패");
-        }
-        int plainLen = len;
+void randomBytes(uint8_t* buf, int len, const char* where) {
+    if (1 != RAND_bytes(buf, len)) {
+        unsigned long errc = ERR_get_error();
+        throw std::runtime_error(std::string(where) + " RAND_bytes 실패: " +
+                                 std::string(ERR_reason_error_string(errc)));
+    }
+}
 
-        // 5) 태그 설정 -> final에서 검증
-        if (1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG,
-                                     16, (void*)tagBuf.data())) {
-            throw std::runtime_error("[aesDecryptGcm] 태그 설정 실패");
+struct CounterNonce {
+    uint32_t prefix;
+    uint64_t counter;
+    uint64_t remaining;
+    uint64_t generation;
+    bool hasPrefix;
+
+    CounterNonce() : prefix(0), counter(0), remaining(0), generation(0), hasPrefix(false) {}
+
+    ~CounterNonce() {
+        if (hasPrefix && generation == g_fork_generation.load()) {
+            std::lock_guard<std::mutex> lock(g_nonce_mutex);
+            g_nonce_prefixes.erase(prefix);
         }
+    }
+
+    // 새 고정 필드 + 카운터 시작값
+    void reseed() {
+        std::call_once(g_nonce_atfork_once, [] {
+            pthread_atfork(nonceAtforkPrepare, nonceAtforkParent, nonceAtforkChild);
+        });
 
-        // 6) Final (태그 검증)
-        if (1 != EVP_DecryptFinal_ex(ctx, out.data() + plainLen, &len)) {
-            throw std::runtime_error("[aesDecryptGcm] DecryptFinal 실패(태그 불일치)");
+        uint8_t seed[12];
+        std::lock_guard<std::mutex> lock(g_nonce_mutex);
+        uint64_t gen = g_fork_generation.load();
+        if (hasPrefix && generation == gen) {
+            g_nonce_prefixes.erase(prefix);
         }
-        plainLen += len;
+        hasPrefix = false;
+        do {
+            randomBytes(seed, sizeof(seed), "[CounterNonce]");
+            std::memcpy(&prefix, seed, 4);
+        } while (!g_nonce_prefixes.insert(prefix).second);
+        std::memcpy(&counter, seed + 4, 8);
+        OPENSSL_cleanse(seed, sizeof(seed));
 
-        out.resize(plainLen);
+        hasPrefix  = true;
+        generation = gen;
+        remaining  = kCounterNonceBudget;
+    }
 
-        EVP_CIPHER_CTX_free(ctx);
-        std::memset(ivBuf.data(), 0, ivBuf.size());
-        std::memset(tagBuf.data(), 0, tagBuf.size());
+    void next(uint8_t* iv) {
+        if (remaining == 0 || generation != g_fork_generation.load(std::memory_order_relaxed)) {
+            reseed();
+        }
+        remaining--;
+        uint64_t c = counter++;
 
-        return out;
+        std::memcpy(iv, &prefix, 4);
+        for (int i = 0; i < 8; i++) {
+            iv[4 + i] = (uint8_t)(c >> (56 - 8 * i));
+        }
     }
-    catch (...) {
-        EVP_CIPHER_CTX_free(ctx);
-        throw;
+};
+
+} // namespace
+
+void hcrypt_gcm_kdf::fillIV(uint8_t* iv, hcrypt_nonce_mode mode) {
+    StatTimer timer(kStatNsNonce);
+    if (mode == HCRYPT_NONCE_COUNTER) {
+        thread_local CounterNonce nonce;
+        nonce.next(iv);
+    } else {
+        randomBytes(iv, 12, "[fillIV]");
     }
 }
 
 /*******************************************************
- * 8) extern "C" (C 인터페이스)
+ * 4-2) 프로세스 간 공유 복호화 캐시 (/dev/shm)
+ *  - 같은 셀 암호문을 여러 PHP-FPM 워커가 반복해서 복호화하지 않도록
+ *    인증을 통과한 (암호문 → 평문) 쌍을 공유 메모리에 보관
+ *  - 8-way 집합 연관(open addressing 을 8칸으로 제한) 해시, 집합 번호 = GCM 태그 앞 8바이트
+ *  - 슬롯마다 seqlock: 쓰는 쪽은 seq 를 홀수로 CAS 해서 차지, 읽는 쪽은 복사 전후 seq 비교
+ *    → 락 없음, 프로세스가 쓰는 중에 죽어도 그 슬롯 하나만 못 쓰게 될 뿐
+ *  - 교체: 집합마다 CLOCK 바늘 + 슬롯 참조 비트
+ *  - 적중 조건 = 키 지문 + 암호문 전체(IV + 암호문 + 태그) 일치
+ *    태그만 비교하면 태그를 복사한 위조 암호문이 인증 없이 평문을 받아 갈 수 있음
+ *  - 짧은 셀만 보관 (슬롯 하나에 암호문 + 평문이 들어가야 함)
  *******************************************************/
-extern "C" {
+namespace {
 
-// ------------ 객체 생성/소멸 ------------
-hcrypt_gcm_kdf* hcrypt_new() {
-    try {
-        return new hcrypt_gcm_kdf();
-    } catch (const std::exception& e) {
-        std::cerr << "[hcrypt_new] 예외: " << e.what() << std::endl;
-        return nullptr;
-    }
-}
+const uint64_t kShmCacheMagic   = 0x3143434d48534348ULL;  // "HCSHMCC1"
+const int      kShmCacheWays    = 8;
+const int      kShmSlotBytes    = 512;
+const int      kShmSlotHeader   = 24;
+// 암호문(IV+암호문+태그) + 평문 ≤ 슬롯 데이터 → 암호문 최대 (488 + 28) / 2
+const size_t   kShmMaxCipherLen = (kShmSlotBytes - kShmSlotHeader + 12 + 16) / 2;
 
-void hcrypt_delete(hcrypt_gcm_kdf* hc) {
-    delete hc;
+struct ShmSlot {
+    std::atomic<uint32_t> seq;        // 짝수 = 안정, 홀수 = 쓰는 중
+    std::atomic<uint8_t>  ref;        // CLOCK 참조 비트
+    uint8_t               pad[3];
+    std::atomic<uint32_t> cipherLen;  // 0 = 빈 슬롯
+    uint32_t              pad2;
+    std::atomic<uint64_t> keyFp;
+    uint8_t               data[kShmSlotBytes - kShmSlotHeader];  // [암호문][평문]
+};
+static_assert(sizeof(ShmSlot) == kShmSlotBytes, "ShmSlot 크기");
+
+struct ShmHeader {
+    uint64_t magic;                   // 초기화가 끝난 뒤 마지막에 기록
+    uint64_t setCount;
+    uint64_t segmentBytes;
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> inserts;
+    std::atomic<uint64_t> evictions;
+    uint64_t pad;
+};
+static_assert(sizeof(ShmHeader) == 64, "ShmHeader 크기");
+
+// 세그먼트 = [ShmHeader][CLOCK 바늘 × setCount (64바이트 정렬)][ShmSlot × setCount × 8]
+inline uint64_t shmHandsBytes(uint64_t setCount) {
+    return (setCount + 63) / 64 * 64;
 }
 
-// ------------ KDF (PBKDF2) ------------
-void hcrypt_deriveKeyFromPassword(hcrypt_gcm_kdf* hc,
-                                  const char* password,
-                                  const uint8_t* salt,
-                                  int salt_len,
-                                  int key_len,
-                                  int iteration)
-{
-    if (!hc || !password || !salt) return;
-    try {
-        std::vector<uint8_t> saltVec(salt, salt + salt_len);
-        hc->deriveKeyFromPassword(password, saltVec, key_len, iteration);
-    } catch (const std::exception& e) {
-        std::cerr << "[hcrypt_deriveKeyFromPassword] 예외: " << e.what() << std::endl;
-    }
+inline uint64_t shmSegmentBytes(uint64_t setCount) {
+    return sizeof(ShmHeader) + shmHandsBytes(setCount)
+         + setCount * kShmCacheWays * (uint64_t)kShmSlotBytes;
 }
 
-// ------------ 키 직접 설정 ------------
-void hcrypt_setKey(hcrypt_gcm_kdf* hc, const uint8_t* keydata, int key_len) {
-    if (!hc || !keydata) return;
-    try {
-        std::vector<uint8_t> keyVec(keydata, keydata + key_len);
-        hc->setKey(keyVec);
-    } catch (const std::exception& e) {
-        std::cerr << "[hcrypt_setKey] 예외: " << e.what() << std::endl;
+struct ShmCellCache {
+    std::string name;         // attach 할 때 넘긴 이름/예산 (같은 값으로 다시 attach 하면 그대로 사용)
+    int64_t budget;
+    void* base;
+    size_t mapped;
+    ShmHeader* header;
+    std::atomic<uint8_t>* hands;
+    ShmSlot* slots;
+
+    ShmSlot* setOf(const uint8_t* cipher, size_t cipherLen, uint64_t* set) const {
+        uint64_t h;
+        std::memcpy(&h, cipher + cipherLen - 16, 8);
+        *set = h % header->setCount;
+        return slots + *set * kShmCacheWays;
     }
-}
 
-// ------------ 단일 청크 암/복호화 ------------
-uint8_t* hcrypt_encrypt_alloc(hcrypt_gcm_kdf* hc,
-                              const uint8_t* plain, int plain_len,
-                              int* out_len)
-{
-    if (!hc || !plain || !out_len) return nullptr;
+    bool lookup(uint64_t keyFp, const uint8_t* cipher, size_t cipherLen, uint8_t* out) const {
+        uint64_t set;
+        ShmSlot* ways = setOf(cipher, cipherLen, &set);
+        for (int w = 0; w < kShmCacheWays; w++) {
+            ShmSlot& slot = ways[w];
+            uint32_t before = slot.seq.load(std::memory_order_acquire);
+            if (before & 1) continue;
+            if (slot.cipherLen.load(std::memory_order_relaxed) != cipherLen
+                || slot.keyFp.load(std::memory_order_relaxed) != keyFp) continue;
+            if (std::memcmp(slot.data, cipher, cipherLen) != 0) continue;
 
-    // --- [빈 문자열 예외처리] ---
-    if (plain_len <= 0) {
-        *out_len = 0;
-        // 필요하다면, 빈 new[] 할당 또는 nullptr 반환
-        return nullptr;
+            std::memcpy(out, slot.data + cipherLen, cipherLen - 12 - 16);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != before) continue;
+
+            slot.ref.store(1, std::memory_order_relaxed);
+            header->hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        header->misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
     }
-    // ---------------------------
 
-    try {
-        std::vector<uint8_t> input(plain, plain + plain_len);
-        std::vector<uint8_t> enc = hc->encrypt(input);
+    void insert(uint64_t keyFp, const uint8_t* cipher, size_t cipherLen, const uint8_t* plain) {
+        uint64_t set;
+        ShmSlot* ways = setOf(cipher, cipherLen, &set);
 
-        *out_len = (int)enc.size();
-        if (*out_len == 0) {
-            // 암호화 결과가 빈 벡터 → 빈 new[] 할당
-            uint8_t* result = new uint8_t[0]; // 실제 0바이트
-            return result;
+        // CLOCK: 바늘부터 돌면서 빈 슬롯 또는 참조 비트 0 인 슬롯을 고름 (1 이면 0 으로 내리고 지나감)
+        int hand = hands[set].load(std::memory_order_relaxed) % kShmCacheWays;
+        int victim = hand;
+        for (int step = 0; step < 2 * kShmCacheWays; step++) {
+            int w = (hand + step) % kShmCacheWays;
+            ShmSlot& slot = ways[w];
+            if (slot.seq.load(std::memory_order_relaxed) & 1) continue;
+            if (slot.cipherLen.load(std::memory_order_relaxed) == 0
+                || slot.ref.exchange(0, std::memory_order_relaxed) == 0) {
+                victim = w;
+                break;
+            }
         }
+        hands[set].store((uint8_t)((victim + 1) % kShmCacheWays), std::memory_order_relaxed);
 
-        uint8_t* result = new uint8_t[*out_len];
-        std::memcpy(result, enc.data(), enc.size());
-        return result;
-    } catch (const std::exception& e) {
-        std::cerr << "[hcrypt_encrypt_alloc] 예외: " << e.what() << std::endl;
-        return nullptr;
+        // 슬롯 차지 (다른 쓰기와 겹치면 그냥 포기 - 캐시일 뿐)
+        ShmSlot& slot = ways[victim];
+        uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+        if ((seq & 1) || !slot.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) {
+            return;
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        if (slot.cipherLen.load(std::memory_order_relaxed) != 0) {
+            header->evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+        slot.keyFp.store(keyFp, std::memory_order_relaxed);
+        slot.cipherLen.store((uint32_t)cipherLen, std::memory_order_relaxed);
+        std::memcpy(slot.data, cipher, cipherLen);
+        std::memcpy(slot.data + cipherLen, plain, cipherLen - 12 - 16);
+        slot.ref.store(1, std::memory_order_relaxed);
+        slot.seq.store(seq + 2, std::memory_order_release);
+        header->inserts.fetch_add(1, std::memory_order_relaxed);
     }
+};
+
+std::atomic<ShmCellCache*> g_shm_cache(nullptr);
+std::mutex g_shm_cache_mutex;
+
+// shm 이름은 '/' 로 시작해야 함
+std::string shmName(const char* name) {
+    std::string n = name;
+    if (n.empty() || n[0] != '/') n = "/" + n;
+    return n;
 }
 
-uint8_t* hcrypt_decrypt_alloc(hcrypt_gcm_kdf* hc,
-                              const uint8_t* cipher, int cipher_len,
-                              int* out_len)
+// 공유 메모리 세그먼트 열기/만들기
+//  - 만든 쪽(*created = true): want 바이트로 ftruncate(0으로 채워짐)
+//    → 호출자가 헤더를 채우고 magic 을 마지막에 기록 (publishShmMagic)
+//  - 붙는 쪽: 만든 쪽의 ftruncate 를 잠깐 기다린 뒤 세그먼트 크기 그대로 매핑
+//    → 호출자가 waitShmMagic 으로 초기화 완료를 확인
+void* mapShmSegment(const std::string& name, size_t want, size_t minSize,
+                    size_t* mapped, bool* created)
 {
-    if (!hc || !cipher || !out_len) return nullptr;
-
-    // --- [빈 문자열 예외처리] ---
-    if (cipher_len <= 0) {
-        *out_len = 0;
-        return nullptr;
+    *created = true;
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        *created = false;
+        fd = shm_open(name.c_str(), O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        throw std::runtime_error("shm_open 실패: " + std::string(std::strerror(errno)));
     }
-    // ---------------------------
-
-    try {
-        std::vector<uint8_t> input(cipher, cipher + cipher_len);
-        std::vector<uint8_t> dec = hc->decrypt(input);
 
-        *out_len = (int)dec.size();
-        if (*out_len == 0) {
-            uint8_t* result = new uint8_t[0];
-            return result;
+    size_t size = want;
+    if (*created) {
+        if (ftruncate(fd, (off_t)want) != 0) {
+            int err = errno;
+            close(fd);
+            shm_unlink(name.c_str());
+            throw std::runtime_error("ftruncate 실패: " + std::string(std::strerror(err)));
+        }
+    } else {
+        // 만든 프로세스가 ftruncate 할 때까지 대기 (최대 약 1초)
+        struct stat st;
+        for (int i = 0; ; i++) {
+            if (fstat(fd, &st) != 0) {
+                close(fd);
+                throw std::runtime_error("fstat 실패");
+            }
+            if (st.st_size >= (off_t)minSize || i >= 1000) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        size = (size_t)st.st_size;
+        if (size < minSize) {
+            close(fd);
+            throw std::runtime_error("공유 메모리 세그먼트가 초기화되지 않았습니다.");
         }
+    }
 
-        uint8_t* result = new uint8_t[*out_len];
-        std::memcpy(result, dec.data(), dec.size());
-        return result;
-    } catch (const std::exception& e) {
-        std::cerr << "[hcrypt_decrypt_alloc] 예외: " << e.what() << std::endl;
-        return nullptr;
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error("mmap 실패: " + std::string(std::strerror(errno)));
+    }
+    *mapped = size;
+    return base;
+}
+
+inline void publishShmMagic(uint64_t* magic, uint64_t value) {
+    __atomic_store_n(magic, value, __ATOMIC_RELEASE);
+}
+
+// 만든 쪽이 초기화를 끝낼 때까지 대기 (최대 약 1초, 실패 = 형식이 다른 세그먼트)
+bool waitShmMagic(const uint64_t* magic, uint64_t value) {
+    for (int i = 0; __atomic_load_n(magic, __ATOMIC_ACQUIRE) != value; i++) {
+        if (i >= 1000) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+ShmCellCache* openShmCellCache(const std::string& name, int64_t budgetBytes) {
+    uint64_t setCount = std::max<uint64_t>(1, (uint64_t)budgetBytes / (kShmCacheWays * kShmSlotBytes));
+    uint64_t want = shmSegmentBytes(setCount);
+
+    size_t size = 0;
+    bool created = false;
+    void* base = mapShmSegment(name, (size_t)want, sizeof(ShmHeader), &size, &created);
+
+    ShmHeader* header = static_cast<ShmHeader*>(base);
+    if (created) {
+        header->setCount = setCount;
+        header->segmentBytes = want;
+        publishShmMagic(&header->magic, kShmCacheMagic);
+    } else {
+        if (!waitShmMagic(&header->magic, kShmCacheMagic)) {
+            munmap(base, size);
+            throw std::runtime_error("공유 캐시 세그먼트 형식이 다릅니다.");
+        }
+        if (header->setCount == 0 || header->segmentBytes != size
+            || shmSegmentBytes(header->setCount) != size) {
+            munmap(base, size);
+            throw std::runtime_error("공유 캐시 세그먼트 크기가 맞지 않습니다.");
+        }
+    }
+
+    ShmCellCache* cache = new ShmCellCache();
+    cache->base = base;
+    cache->mapped = size;
+    cache->header = header;
+    cache->hands = reinterpret_cast<std::atomic<uint8_t>*>(static_cast<uint8_t*>(base) + sizeof(ShmHeader));
+    cache->slots = reinterpret_cast<ShmSlot*>(static_cast<uint8_t*>(base) + sizeof(ShmHeader)
+                                              + shmHandsBytes(header->setCount));
+    return cache;
+}
+
+inline bool shmCacheable(size_t cipherLen) {
+    return cipherLen > 12 + 16 && cipherLen <= kShmMaxCipherLen;
+}
+
+} // namespace
+
+/*******************************************************
+ * 4-3) 파생 키 캐시 (PBKDF2 결과 재사용)
+ *  - 요청마다 10000회 PBKDF2 를 다시 돌리지 않도록 파생된 키를 보관
+ *  - 검색 키 = HMAC-SHA256(테이블 비밀값, [비밀번호][salt][반복 횟수][키 길이])
+ *    (길이를 앞에 붙여 경계가 겹치지 않게 함, 비밀번호/salt 자체는 저장하지 않음)
+ *  - 프로세스 테이블: 익명 매핑 1페이지 (항상 사용)
+ *  - 공유 테이블   : /dev/shm 1페이지 (attach 했을 때만) → 다른 프로세스가 파생한 키를 그대로 씀
+ *  - 둘 다 mlock(스왑 금지) + MADV_DONTDUMP(코어 덤프 제외)
+ *  - 쓰기 중 프로세스가 죽어도 반쪽 키가 보이지 않도록 used=0 → 기록 → used=1 순서
+ *******************************************************/
+namespace {
+
+const uint64_t kKeyTableMagic = 0x3159454b54434848ULL;  // "HHCTKEY1"
+const int      kKeyTableSlots = 40;
+const size_t   kKeyTableBytes = 4096;
+
+struct KeySlot {
+    uint32_t used;
+    uint32_t keyLen;
+    uint8_t tag[32];
+    uint8_t key[32];
+    uint8_t pad[8];
+};
+
+struct KeyTable {
+    uint64_t magic;
+    uint32_t nextVictim;
+    uint32_t pad;
+    uint8_t secret[32];
+    pthread_mutex_t mutex;      // 공유 테이블은 PROCESS_SHARED + ROBUST
+    KeySlot slots[kKeyTableSlots];
+};
+static_assert(sizeof(KeyTable) <= kKeyTableBytes, "KeyTable 크기");
+
+// 테이블 잠금 (잠근 프로세스가 죽었으면 이어받음 - used 순서 덕분에 항목은 일관됨)
+class KeyTableLock {
+public:
+    explicit KeyTableLock(KeyTable* t) : table(t) {
+        int rc = pthread_mutex_lock(&table->mutex);
+        if (rc == EOWNERDEAD) {
+            pthread_mutex_consistent(&table->mutex);
+        } else if (rc != 0) {
+            throw std::runtime_error("키 캐시 잠금 실패");
+        }
+    }
+    ~KeyTableLock() { pthread_mutex_unlock(&table->mutex); }
+
+private:
+    KeyTable* table;
+};
+
+void initKeyTable(KeyTable* t, bool shared) {
+    if (1 != RAND_bytes(t->secret, sizeof(t->secret))) {
+        throw std::runtime_error("RAND_bytes 실패(키 캐시 비밀값)");
+    }
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    if (shared) {
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    }
+    pthread_mutex_init(&t->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+// 스왑/코어 덤프에서 제외 (mlock 한도 초과 등 실패는 경고만)
+void protectKeyPages(void* base, size_t size) {
+    if (mlock(base, size) != 0) {
+        std::cerr << "[keycache] mlock 실패: " << std::strerror(errno) << std::endl;
+    }
+#ifdef MADV_DONTDUMP
+    madvise(base, size, MADV_DONTDUMP);
+#endif
+}
+
+void keyTableTag(const KeyTable* t, const char* password, const uint8_t* salt, int saltLen,
+                 int iteration, int keyLen, uint8_t tag[32])
+{
+    uint32_t pwLen = (uint32_t)std::strlen(password);
+    uint32_t fields[4] = { pwLen, (uint32_t)saltLen, (uint32_t)iteration, (uint32_t)keyLen };
+
+    // [길이/반복/키 길이 16바이트][비밀번호][salt]
+    std::vector<uint8_t> msg(sizeof(fields) + pwLen + (size_t)saltLen);
+    std::memcpy(msg.data(), fields, sizeof(fields));
+    std::memcpy(msg.data() + sizeof(fields), password, pwLen);
+    if (saltLen > 0) {
+        std::memcpy(msg.data() + sizeof(fields) + pwLen, salt, (size_t)saltLen);
+    }
+    unsigned int outLen = 0;
+    bool ok = HMAC(sha256Md(), t->secret, sizeof(t->secret), msg.data(), msg.size(), tag, &outLen) != nullptr;
+    OPENSSL_cleanse(msg.data(), msg.size());
+    if (!ok) {
+        throw std::runtime_error("HMAC 실패(키 캐시 검색 키)");
+    }
+}
+
+bool keyTableFind(KeyTable* t, const uint8_t tag[32], int keyLen, uint8_t* key) {
+    KeyTableLock lock(t);
+    for (auto &slot : t->slots) {
+        if (slot.used && (int)slot.keyLen == keyLen && CRYPTO_memcmp(slot.tag, tag, 32) == 0) {
+            std::memcpy(key, slot.key, (size_t)keyLen);
+            return true;
+        }
+    }
+    return false;
+}
+
+void keyTableStore(KeyTable* t, const uint8_t tag[32], const uint8_t* key, int keyLen) {
+    KeyTableLock lock(t);
+    KeySlot* target = nullptr;
+    for (auto &slot : t->slots) {
+        if (slot.used && CRYPTO_memcmp(slot.tag, tag, 32) == 0) {
+            target = &slot;
+            break;
+        }
+        if (!target && !slot.used) target = &slot;
+    }
+    if (!target) {
+        target = &t->slots[t->nextVictim++ % kKeyTableSlots];
+    }
+    __atomic_store_n(&target->used, 0u, __ATOMIC_RELEASE);
+    OPENSSL_cleanse(target->key, sizeof(target->key));
+    std::memcpy(target->tag, tag, 32);
+    std::memcpy(target->key, key, (size_t)keyLen);
+    target->keyLen = (uint32_t)keyLen;
+    __atomic_store_n(&target->used, 1u, __ATOMIC_RELEASE);
+}
+
+// 반환: 지운 항목 수
+int keyTableErase(KeyTable* t, const uint8_t* tag) {
+    KeyTableLock lock(t);
+    int erased = 0;
+    for (auto &slot : t->slots) {
+        if (!slot.used) continue;
+        if (tag && CRYPTO_memcmp(slot.tag, tag, 32) != 0) continue;
+        __atomic_store_n(&slot.used, 0u, __ATOMIC_RELEASE);
+        OPENSSL_cleanse(slot.key, sizeof(slot.key));
+        OPENSSL_cleanse(slot.tag, sizeof(slot.tag));
+        erased++;
+    }
+    return erased;
+}
+
+// 프로세스 테이블 (처음 쓸 때 한 번 만듦, 프로세스 종료까지 유지)
+KeyTable* processKeyTable() {
+    static KeyTable* table = nullptr;
+    static std::once_flag once;
+    std::call_once(once, [] {
+        void* base = mmap(nullptr, kKeyTableBytes, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            throw std::runtime_error("mmap 실패(키 캐시)");
+        }
+        protectKeyPages(base, kKeyTableBytes);
+        KeyTable* t = static_cast<KeyTable*>(base);
+        initKeyTable(t, false);
+        t->magic = kKeyTableMagic;
+        table = t;
+    });
+    return table;
+}
+
+// 공유 테이블 (attach 했을 때만)
+std::atomic<KeyTable*> g_shared_keys(nullptr);
+std::mutex g_shared_keys_mutex;
+
+KeyTable* openSharedKeyTable(const std::string& name) {
+    size_t size = 0;
+    bool created = false;
+    void* base = mapShmSegment(name, kKeyTableBytes, kKeyTableBytes, &size, &created);
+    KeyTable* t = static_cast<KeyTable*>(base);
+    try {
+        if (created) {
+            initKeyTable(t, true);
+            publishShmMagic(&t->magic, kKeyTableMagic);
+        } else if (size != kKeyTableBytes || !waitShmMagic(&t->magic, kKeyTableMagic)) {
+            throw std::runtime_error("키 캐시 세그먼트 형식이 다릅니다.");
+        }
+    } catch (...) {
+        munmap(base, size);
+        throw;
+    }
+    protectKeyPages(base, size);
+    return t;
+}
+
+void attachSharedKeyTable(const char* name) {
+    std::lock_guard<std::mutex> lock(g_shared_keys_mutex);
+    if (g_shared_keys.load()) {
+        throw std::runtime_error("이미 키 캐시에 붙어 있습니다.");
+    }
+    g_shared_keys.store(openSharedKeyTable(shmName(name)), std::memory_order_release);
+}
+
+// HCRYPT_KEY_CACHE 환경 변수가 있으면 처음 파생할 때 그 이름으로 자동 attach
+void attachKeyTableFromEnv() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        const char* name = std::getenv("HCRYPT_KEY_CACHE");
+        if (!name || !*name || g_shared_keys.load()) return;
+        try {
+            attachSharedKeyTable(name);
+        } catch (const std::exception& e) {
+            std::cerr << "[keycache] HCRYPT_KEY_CACHE attach 실패: " << e.what() << std::endl;
+        }
+    });
+}
+
+} // namespace
+
+/*******************************************************
+ * 5) AES-GCM 암/복호화 (단일 청크)
+ *******************************************************/
+// --- [빈 문자열 예외처리] 추가 ---
+std::vector<uint8_t> hcrypt_gcm_kdf::encrypt(const std::vector<uint8_t>& plaintext) const {
+    if (!evpCipher) {
+        throw std::runtime_error("[encrypt] 키가 설정되지 않았습니다.");
+    }
+
+    // 빈 평문이면, 빈 결과 반환
+    if (plaintext.empty()) {
+        return {}; 
+    }
+
+    std::vector<uint8_t> out(plaintext.size() + 12 + 16);
+    fillIV(out.data(), HCRYPT_NONCE_RANDOM);
+    aesEncryptGcm(plaintext.data(), plaintext.size(), out.data());
+    return out;
+}
+
+std::vector<uint8_t> hcrypt_gcm_kdf::decrypt(const std::vector<uint8_t>& ciphertext) const {
+    if (!evpCipher) {
+        throw std::runtime_error("[decrypt] 키가 설정되지 않았습니다.");
+    }
+
+    // GCM 최소크기(IV=12, 태그=16)보다 작으면 "빈 결과" 반환
+    if (ciphertext.size() < 12 + 16) {
+        return {};
+    }
+
+    std::vector<uint8_t> out(ciphertext.size() - 12 - 16);
+    aesDecryptGcm(ciphertext.data(), ciphertext.size(), out.data());
+    return out;
+}
+
+void hcrypt_gcm_kdf::encryptInto(const uint8_t* plain, size_t plainLen, uint8_t* out,
+                                 hcrypt_nonce_mode nonceMode) const {
+    if (!evpCipher) {
+        throw std::runtime_error("[encryptInto] 키가 설정되지 않았습니다.");
+    }
+    fillIV(out, nonceMode);
+    aesEncryptGcm(plain, plainLen, out);
+}
+
+void hcrypt_gcm_kdf::decryptInto(const uint8_t* cipher, size_t cipherLen, uint8_t* out) const {
+    if (!evpCipher) {
+        throw std::runtime_error("[decryptInto] 키가 설정되지 않았습니다.");
+    }
+    aesDecryptGcm(cipher, cipherLen, out);
+}
+
+bool hcrypt_gcm_kdf::tryDecryptInto(const uint8_t* cipher, size_t cipherLen, uint8_t* out) const {
+    if (!evpCipher) {
+        throw std::runtime_error("[tryDecryptInto] 키가 설정되지 않았습니다.");
+    }
+    return aesDecryptGcm(cipher, cipherLen, out, false);
+}
+
+/*******************************************************
+ * 6) 내부: AES-GCM 암호화
+ *    out = [IV(12)] + [암호문(plainLen)] + [태그(16)]
+ *    - IV는 호출자가 out 앞 12바이트에 미리 기록 (fillIV)
+ *    - 스레드별 컨텍스트에 IV만 다시 설정 (키 확장 없음)
+ *    - 태그도 out 에 바로 기록 (임시 버퍼 없음)
+ *******************************************************/
+void hcrypt_gcm_kdf::aesEncryptGcm(const uint8_t* plain, size_t plainLen, uint8_t* out) const {
+    if (plainLen > (size_t)INT_MAX) {
+        throw std::runtime_error("[aesEncryptGcm] 평문이 너무 깁니다.");
+    }
+    StatTimer timer(kStatNsAesGcm);
+
+    EVP_CIPHER_CTX* ctx = static_cast<EVP_CIPHER_CTX*>(threadCtx());
+
+    // 1~2) IV 설정 (out 앞 12바이트, 키는 컨텍스트에 이미 확장되어 있음)
+    if (1 != EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr, out)) {
+        throw std::runtime_error("[aesEncryptGcm] EncryptInit_ex 실패(IV)");
+    }
+
+    // 3) 평문 -> 암호문
+    int len = 0;
+    uint8_t* cipherPtr = out + 12;
+    if (1 != EVP_EncryptUpdate(ctx, cipherPtr, &len, plain, (int)plainLen)) {
+        throw std::runtime_error("[aesEncryptGcm] EncryptUpdate 실패");
+    }
+    int cipherLen = len;
+
+    // 4) Final (GCM은 추가 출력 없음)
+    if (1 != EVP_EncryptFinal_ex(ctx, cipherPtr + cipherLen, &len)) {
+        throw std::runtime_error("[aesEncryptGcm] EncryptFinal 실패");
+    }
+    cipherLen += len;
+
+    // 5) 태그(16바이트)를 암호문 바로 뒤에 기록
+    if (1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG,
+                                 16, cipherPtr + cipherLen)) {
+        throw std::runtime_error("[aesEncryptGcm] GET_TAG 실패");
+    }
+    statCells(1, plainLen);
+}
+
+/*******************************************************
+ * 7) 내부: AES-GCM 복호화
+ *    out 에 cipherLen - 28 바이트 평문 기록
+ *******************************************************/
+bool hcrypt_gcm_kdf::aesDecryptGcm(const uint8_t* cipher, size_t cipherLen, uint8_t* out,
+                                   bool throwOnTag) const {
+    if (cipherLen < 12 + 16) {
+        throw std::runtime_error("[aesDecryptGcm] 암호문이 너무 짧습니다.");
+    }
+    if (cipherLen - 12 - 16 > (size_t)INT_MAX) {
+        throw std::runtime_error("[aesDecryptGcm] 암호문이 너무 깁니다.");
+    }
+    StatTimer timer(kStatNsAesGcm);
+
+    // 0) 공유 캐시 (붙어 있을 때만)
+    ShmCellCache* shared = g_shm_cache.load(std::memory_order_acquire);
+    if (shared && shmCacheable(cipherLen)) {
+        if (shared->lookup(keyFingerprint, cipher, cipherLen, out)) {
+            statCells(1, cipherLen - 12 - 16);
+            return true;
+        }
+    } else {
+        shared = nullptr;
+    }
+
+    EVP_CIPHER_CTX* ctx = static_cast<EVP_CIPHER_CTX*>(threadCtx());
+
+    // 1) IV(12), Tag(16) 위치
+    const uint8_t* ivPtr = cipher;
+
+    uint8_t tagBuf[16];
+    std::memcpy(tagBuf, cipher + (cipherLen - 16), 16);
+
+    // 2) 암호문 부분
+    size_t actualCipherLen = cipherLen - 12 - 16;
+    const uint8_t* actualCipherPtr = cipher + 12;
+
+    // 3) IV 설정 (복호화 방향)
+    if (1 != EVP_DecryptInit_ex(ctx, nullptr, nullptr, nullptr, ivPtr)) {
+        throw std::runtime_error("[aesDecryptGcm] DecryptInit_ex 실패(IV)");
+    }
+
+    // 4) 복호화 진행
+    int len = 0;
+    if (1 != EVP_DecryptUpdate(ctx, out, &len,
+                               actualCipherPtr, (int)actualCipherLen)) {
+        throw std::runtime_error("[aesDecryptGcm] DecryptUpdate 실패");
+    }
+    int plainLen = len;
+
+    // 5) 태그 설정 -> final에서 검증
+    if (1 != EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, 16, tagBuf)) {
+        throw std::runtime_error("[aesDecryptGcm] 태그 설정 실패");
+    }
+
+    // 6) Final (태그 검증)
+    if (1 != EVP_DecryptFinal_ex(ctx, out + plainLen, &len)) {
+        OPENSSL_cleanse(out, actualCipherLen);
+        statAdd(kStatTagFailures, 1);
+        if (!throwOnTag) return false;
+        throw std::runtime_error("[aesDecryptGcm] DecryptFinal 실패(태그 불일치)");
+    }
+    std::memset(tagBuf, 0, sizeof(tagBuf));
+    statCells(1, actualCipherLen);
+
+    // 7) 인증을 통과한 결과만 공유 캐시에 넣음
+    if (shared) {
+        shared->insert(keyFingerprint, cipher, cipherLen, out);
+    }
+    return true;
+}
+
+/*******************************************************
+ * 8) 워커 스레드 풀 (hcrypt_pool)
+ *******************************************************/
+hcrypt_pool::hcrypt_pool(int threadCount)
+  : stopping(false)
+{
+    if (threadCount < 0) {
+        throw std::invalid_argument("[hcrypt_pool] threadCount는 0 이상이어야 합니다.");
+    }
+    workers.reserve(threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        workers.emplace_back(&hcrypt_pool::workerLoop, this);
+    }
+}
+
+hcrypt_pool::~hcrypt_pool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto &th : workers) {
+        if (th.joinable()) th.join();
+    }
+}
+
+int hcrypt_pool::size() const {
+    return (int)workers.size();
+}
+
+void hcrypt_pool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        tasks.push_back(std::move(task));
+    }
+    cv.notify_one();
+}
+
+void hcrypt_pool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+namespace {
+
+// parallelFor 한 번의 상태
+//  - 워커 큐에 남아 있는 도우미가 호출 종료 후에 실행될 수도 있으므로 shared_ptr로 유지
+struct ParallelBatch {
+    std::function<void(int)> fn;
+    int taskCount;
+    std::atomic<int> next;
+    std::atomic<int> done;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::exception_ptr error;
+
+    ParallelBatch(const std::function<void(int)>& f, int n)
+      : fn(f), taskCount(n), next(0), done(0) {}
+
+    // 남은 작업 인덱스를 하나씩 가져가며 실행
+    void run() {
+        int finished = 0;
+        for (;;) {
+            int i = next.fetch_add(1);
+            if (i >= taskCount) break;
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (!error) error = std::current_exception();
+            }
+            finished++;
+        }
+        if (finished > 0 && done.fetch_add(finished) + finished == taskCount) {
+            std::lock_guard<std::mutex> lock(mtx);
+            cv.notify_all();
+        }
+    }
+};
+
+} // namespace
+
+void hcrypt_pool::parallelFor(int taskCount, const std::function<void(int)>& fn) {
+    if (taskCount <= 0) return;
+
+    std::shared_ptr<ParallelBatch> batch = std::make_shared<ParallelBatch>(fn, taskCount);
+
+    // 호출 스레드가 한 몫을 맡으므로 도우미는 최대 (taskCount - 1)개
+    int helpers = std::min(taskCount - 1, (int)workers.size());
+    if (helpers > 0) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (int i = 0; i < helpers; i++) {
+                tasks.push_back([batch] { batch->run(); });
+            }
+        }
+        if (helpers == 1) cv.notify_one();
+        else cv.notify_all();
+    }
+
+    batch->run();
+
+    std::unique_lock<std::mutex> lock(batch->mtx);
+    batch->cv.wait(lock, [&] { return batch->done.load() == taskCount; });
+    if (batch->error) {
+        std::rethrow_exception(batch->error);
+    }
+}
+
+/*******************************************************
+ * 8-1) CPU 기능 감지 / 커널 단계 (HCRYPT_FORCE_ISA)
+ *  - 모든 SIMD 커널은 같은 .so 안에 target 속성으로 컴파일해 두고
+ *    처음 쓸 때 cpuid(__builtin_cpu_supports)로 기능 비트를 한 번 읽어 단계를 정함
+ *  - HCRYPT_FORCE_ISA 가 있으면 그 단계까지만 허용 (경로별 테스트용, 올리는 것은 불가)
+ *  - Base64 / 작은 셀 AES-GCM / 다중 PBKDF2 는 cpuIsa().usable() 로 함수 포인터 표를 고름
+ *    (ifunc 리졸버는 재배치 전에 돌아서 getenv 를 안전하게 부를 수 없으므로 쓰지 않음)
+ *******************************************************/
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define HCRYPT_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const int kIsaLevelCount = HCRYPT_ISA_AVX512 + 1;
+
+const char* const kIsaLevelNames[kIsaLevelCount] = { "scalar", "sse4.1", "avx2", "avx512" };
+
+// 단계별로 쓸 수 있는 기능 (아래 단계 포함)
+const uint32_t kIsaSse41Features = HCRYPT_CPU_SSSE3 | HCRYPT_CPU_SSE41 | HCRYPT_CPU_AESNI |
+                                   HCRYPT_CPU_PCLMUL | HCRYPT_CPU_SHA;
+const uint32_t kIsaAvx2Features = kIsaSse41Features | HCRYPT_CPU_AVX2 | HCRYPT_CPU_VAES;
+const uint32_t kIsaLevelFeatures[kIsaLevelCount] = {
+    0, kIsaSse41Features, kIsaAvx2Features, kIsaAvx2Features | HCRYPT_CPU_AVX512F
+};
+
+struct CpuIsa {
+    uint32_t features;   // CPU 가 지원하는 기능
+    int detected;        // CPU 가 지원하는 최고 단계
+    int level;           // 실제로 쓰는 단계
+
+    // need 의 기능을 현재 단계에서 모두 쓸 수 있는지
+    bool usable(uint32_t need) const {
+        return (features & kIsaLevelFeatures[level] & need) == need;
+    }
+};
+
+CpuIsa detectCpuIsa() {
+    CpuIsa isa = { 0, HCRYPT_ISA_SCALAR, HCRYPT_ISA_SCALAR };
+#ifdef HCRYPT_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3"))   isa.features |= HCRYPT_CPU_SSSE3;
+    if (__builtin_cpu_supports("sse4.1"))  isa.features |= HCRYPT_CPU_SSE41;
+    if (__builtin_cpu_supports("aes"))     isa.features |= HCRYPT_CPU_AESNI;
+    if (__builtin_cpu_supports("pclmul"))  isa.features |= HCRYPT_CPU_PCLMUL;
+    if (__builtin_cpu_supports("sha"))     isa.features |= HCRYPT_CPU_SHA;
+    if (__builtin_cpu_supports("avx2"))    isa.features |= HCRYPT_CPU_AVX2;
+    if (__builtin_cpu_supports("vaes"))    isa.features |= HCRYPT_CPU_VAES;
+    if (__builtin_cpu_supports("avx512f")) isa.features |= HCRYPT_CPU_AVX512F;
+
+    // 단계는 대표 기능으로 판단 (AES-NI/SHA/VAES 는 커널마다 따로 확인)
+    if ((isa.features & (HCRYPT_CPU_SSSE3 | HCRYPT_CPU_SSE41)) == (HCRYPT_CPU_SSSE3 | HCRYPT_CPU_SSE41)) {
+        isa.detected = HCRYPT_ISA_SSE41;
+        if (isa.features & HCRYPT_CPU_AVX2) {
+            isa.detected = HCRYPT_ISA_AVX2;
+            if (isa.features & HCRYPT_CPU_AVX512F) isa.detected = HCRYPT_ISA_AVX512;
+        }
+    }
+#endif
+    isa.level = isa.detected;
+
+    const char* forced = std::getenv("HCRYPT_FORCE_ISA");
+    if (forced && *forced) {
+        int want = -1;
+        for (int l = 0; l < kIsaLevelCount; l++) {
+            if (std::strcmp(forced, kIsaLevelNames[l]) == 0) want = l;
+        }
+        if (want < 0) {
+            std::cerr << "[HCRYPT_FORCE_ISA] 알 수 없는 값 (scalar/sse4.1/avx2/avx512): "
+                      << forced << std::endl;
+        } else if (want > isa.detected) {
+            std::cerr << "[HCRYPT_FORCE_ISA] CPU 가 지원하지 않는 단계: " << forced
+                      << " → " << kIsaLevelNames[isa.detected] << std::endl;
+        } else {
+            isa.level = want;
+        }
+    }
+    return isa;
+}
+
+const CpuIsa& cpuIsa() {
+    static const CpuIsa isa = detectCpuIsa();
+    return isa;
+}
+
+} // namespace
+
+/*******************************************************
+ * 8-2) Base64 코덱 (AVX2 / SSSE3 / 스칼라)
+ *  - 표준 알파벳, '=' 패딩 (PHP base64_encode/base64_decode(strict) 와 동일)
+ *  - SIMD 블록은 패딩이 없는 앞부분만 처리하고, 나머지(마지막 4글자 포함)는 스칼라로 처리
+ *  - 디코드 SIMD 블록은 출력 12/24바이트를 쓰면서 16/32바이트를 저장하므로
+ *    dst 뒤에 kB64DecodeSlack 바이트 여유가 있어야 함
+ *******************************************************/
+namespace {
+
+const size_t kB64DecodeSlack = 32;
+
+// 이보다 짧은 입력은 AVX2 함수 안에서도 128비트 블록만 사용
+const size_t kB64WideMin = 256;
+
+const char kB64Alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+inline size_t b64EncodedLen(size_t len) {
+    return (len + 2) / 3 * 4;
+}
+
+// 글자 → 6비트 값 (0xFF = 알파벳 아님)
+struct B64DecodeTable {
+    uint8_t v[256];
+    B64DecodeTable() {
+        std::memset(v, 0xFF, sizeof(v));
+        for (int i = 0; i < 64; i++) {
+            v[(uint8_t)kB64Alphabet[i]] = (uint8_t)i;
+        }
+    }
+};
+
+const B64DecodeTable& b64DecodeTable() {
+    static const B64DecodeTable table;
+    return table;
+}
+
+size_t b64EncodeScalar(const uint8_t* src, size_t len, char* dst) {
+    char* out = dst;
+    size_t i = 0;
+    for (; i + 3 <= len; i += 3) {
+        uint32_t v = ((uint32_t)src[i] << 16) | ((uint32_t)src[i + 1] << 8) | src[i + 2];
+        *out++ = kB64Alphabet[(v >> 18) & 63];
+        *out++ = kB64Alphabet[(v >> 12) & 63];
+        *out++ = kB64Alphabet[(v >> 6) & 63];
+        *out++ = kB64Alphabet[v & 63];
+    }
+    if (i < len) {
+        uint32_t v = (uint32_t)src[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)src[i + 1] << 8;
+        *out++ = kB64Alphabet[(v >> 18) & 63];
+        *out++ = kB64Alphabet[(v >> 12) & 63];
+        *out++ = (i + 1 < len) ? kB64Alphabet[(v >> 6) & 63] : '=';
+        *out++ = '=';
+    }
+    return (size_t)(out - dst);
+}
+
+// len 은 4의 배수여야 하고, '=' 는 끝에서 최대 2개만 허용
+bool b64DecodeScalar(const char* src, size_t len, uint8_t* dst, size_t* outLen) {
+    if (len % 4 != 0) return false;
+    const uint8_t* table = b64DecodeTable().v;
+    uint8_t* out = dst;
+    for (size_t i = 0; i < len; i += 4) {
+        uint8_t a = table[(uint8_t)src[i]];
+        uint8_t b = table[(uint8_t)src[i + 1]];
+        uint8_t c = table[(uint8_t)src[i + 2]];
+        uint8_t d = table[(uint8_t)src[i + 3]];
+        bool last = (i + 4 == len);
+        if (last && src[i + 3] == '=') {
+            if (a == 0xFF || b == 0xFF) return false;
+            *out++ = (uint8_t)((a << 2) | (b >> 4));
+            if (src[i + 2] != '=') {
+                if (c == 0xFF) return false;
+                *out++ = (uint8_t)((b << 4) | (c >> 2));
+            }
+            break;
+        }
+        if ((a | b | c | d) & 0xC0) {
+            return false;
+        }
+        uint32_t v = ((uint32_t)a << 18) | ((uint32_t)b << 12) | ((uint32_t)c << 6) | d;
+        *out++ = (uint8_t)(v >> 16);
+        *out++ = (uint8_t)(v >> 8);
+        *out++ = (uint8_t)v;
+    }
+    *outLen = (size_t)(out - dst);
+    return true;
+}
+
+#ifdef HCRYPT_X86_SIMD
+// 블록 함수는 호출하는 쪽에 인라인됨 → AVX2 함수 안에서는 VEX 인코딩으로 만들어져
+// AVX↔SSE 전환 비용 없이 128비트 꼬리 처리에 그대로 사용 가능
+
+// 12바이트 → 16글자 (Muła 방식: 6비트 분리 후 pshufb 로 글자 오프셋 조회)
+__attribute__((target("ssse3"), always_inline)) inline
+__m128i b64EncodeBlock128(__m128i in) {
+    const __m128i split = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m128i shift = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                        '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                        '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    in = _mm_shuffle_epi8(in, split);
+    __m128i idx = _mm_or_si128(
+        _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040)),
+        _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010)));
+    __m128i reduced = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+    __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), idx);
+    reduced = _mm_or_si128(reduced, _mm_and_si128(less, _mm_set1_epi8(13)));
+    return _mm_add_epi8(idx, _mm_shuffle_epi8(shift, reduced));
+}
+
+// 16글자 → 12바이트 (Klomp/Muła 방식: 니블 LUT 로 검증 + 오프셋 조회)
+//  - 알파벳이 아닌 글자가 있으면 false (해당 블록은 스칼라가 다시 처리하며 오류 판정)
+__attribute__((target("ssse3"), always_inline)) inline
+bool b64DecodeBlock128(__m128i str, __m128i* out) {
+    const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                         0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                         0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                           0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask_2F = _mm_set1_epi8(0x2F);
+    const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2F);
+    __m128i lo_nibbles = _mm_and_si128(str, mask_2F);
+    __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+    __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0) {
+        return false;
+    }
+    __m128i eq_2F = _mm_cmpeq_epi8(str, mask_2F);
+    __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2F, hi_nibbles));
+    str = _mm_add_epi8(str, roll);
+    str = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+    str = _mm_madd_epi16(str, _mm_set1_epi32(0x00011000));
+    *out = _mm_shuffle_epi8(str, pack);
+    return true;
+}
+
+// 16바이트를 읽고 12바이트만 사용하므로 len 끝을 넘어 읽지 않도록 i + 16 <= len
+__attribute__((target("ssse3")))
+size_t b64EncodeSsse3(const uint8_t* src, size_t len, char* dst) {
+    size_t i = 0, o = 0;
+    for (; i + 16 <= len; i += 12, o += 16) {
+        __m128i v = b64EncodeBlock128(_mm_loadu_si128((const __m128i*)(src + i)));
+        _mm_storeu_si128((__m128i*)(dst + o), v);
+    }
+    return o + b64EncodeScalar(src + i, len - i, dst + o);
+}
+
+__attribute__((target("avx2")))
+size_t b64EncodeAvx2(const uint8_t* src, size_t len, char* dst) {
+    const __m256i split = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                           1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i shift = _mm256_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    size_t i = 0, o = 0;
+    // 레인마다 16바이트를 읽고 12바이트씩 사용 (위 레인이 i+12 ~ i+28 을 읽음)
+    //  - 짧은 셀은 256비트 루프가 오히려 느려서 (AES 호출 사이사이 잠깐씩만 실행됨) 128비트로만 처리
+    for (; len >= kB64WideMin && i + 28 <= len; i += 24, o += 32) {
+        __m256i in = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(src + i))),
+            _mm_loadu_si128((const __m128i*)(src + i + 12)), 1);
+        in = _mm256_shuffle_epi8(in, split);
+        __m256i idx = _mm256_or_si256(
+            _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)),
+                               _mm256_set1_epi32(0x04000040)),
+            _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)),
+                               _mm256_set1_epi32(0x01000010)));
+        __m256i reduced = _mm256_subs_epu8(idx, _mm256_set1_epi8(51));
+        __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), idx);
+        reduced = _mm256_or_si256(reduced, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+        __m256i v = _mm256_add_epi8(idx, _mm256_shuffle_epi8(shift, reduced));
+        _mm256_storeu_si256((__m256i*)(dst + o), v);
+    }
+    for (; i + 16 <= len; i += 12, o += 16) {
+        __m128i v = b64EncodeBlock128(_mm_loadu_si128((const __m128i*)(src + i)));
+        _mm_storeu_si128((__m128i*)(dst + o), v);
+    }
+    return o + b64EncodeScalar(src + i, len - i, dst + o);
+}
+
+// 디코드 블록 루프: 처리한 글자 수 반환 (나머지는 b64Decode 가 스칼라로 처리)
+//  - 마지막 4글자(패딩 가능)는 항상 스칼라 몫으로 남김
+__attribute__((target("ssse3")))
+size_t b64DecodeBlocksSsse3(const char* src, size_t len, uint8_t* dst) {
+    size_t i = 0, o = 0;
+    for (; i + 16 + 4 <= len; i += 16, o += 12) {
+        __m128i v;
+        if (!b64DecodeBlock128(_mm_loadu_si128((const __m128i*)(src + i)), &v)) break;
+        _mm_storeu_si128((__m128i*)(dst + o), v);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+size_t b64DecodeBlocksAvx2(const char* src, size_t len, uint8_t* dst) {
+    const __m256i lut_lo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lut_hi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask_2F = _mm256_set1_epi8(0x2F);
+    const __m256i pack = _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+
+    size_t i = 0, o = 0;
+    for (; len >= kB64WideMin && i + 32 + 4 <= len; i += 32, o += 24) {
+        __m256i str = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask_2F);
+        __m256i lo_nibbles = _mm256_and_si256(str, mask_2F);
+        __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+        __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+        if (!_mm256_testz_si256(lo, hi)) {
+            return i;
+        }
+        __m256i eq_2F = _mm256_cmpeq_epi8(str, mask_2F);
+        __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2F, hi_nibbles));
+        str = _mm256_add_epi8(str, roll);
+        str = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+        str = _mm256_madd_epi16(str, _mm256_set1_epi32(0x00011000));
+        str = _mm256_shuffle_epi8(str, pack);
+        _mm256_storeu_si256((__m256i*)(dst + o), _mm256_permutevar8x32_epi32(str, lanes));
+    }
+    for (; i + 16 + 4 <= len; i += 16, o += 12) {
+        __m128i v;
+        if (!b64DecodeBlock128(_mm_loadu_si128((const __m128i*)(src + i)), &v)) break;
+        _mm_storeu_si128((__m128i*)(dst + o), v);
+    }
+    return i;
+}
+#endif // HCRYPT_X86_SIMD
+
+// CPU 에 맞는 구현을 한 번만 골라 둠
+struct B64Codec {
+    const char* name;
+    size_t (*encode)(const uint8_t* src, size_t len, char* dst);
+    size_t (*decodeBlocks)(const char* src, size_t len, uint8_t* dst);
+};
+
+size_t b64DecodeBlocksNone(const char*, size_t, uint8_t*) {
+    return 0;
+}
+
+B64Codec selectB64Codec() {
+    B64Codec codec = { "scalar", b64EncodeScalar, b64DecodeBlocksNone };
+#ifdef HCRYPT_X86_SIMD
+    const CpuIsa& isa = cpuIsa();
+    if (isa.usable(HCRYPT_CPU_AVX2)) {
+        codec = { "avx2", b64EncodeAvx2, b64DecodeBlocksAvx2 };
+    } else if (isa.usable(HCRYPT_CPU_SSSE3)) {
+        codec = { "ssse3", b64EncodeSsse3, b64DecodeBlocksSsse3 };
+    }
+#endif
+    return codec;
+}
+
+const B64Codec& b64Codec() {
+    static const B64Codec codec = selectB64Codec();
+    return codec;
+}
+
+// dst 에 b64EncodedLen(len) 글자 기록
+inline size_t b64Encode(const uint8_t* src, size_t len, char* dst) {
+    return b64Codec().encode(src, len, dst);
+}
+
+// dst 는 (디코드 길이 + kB64DecodeSlack) 바이트 이상이어야 함
+inline bool b64Decode(const char* src, size_t len, uint8_t* dst, size_t* outLen) {
+    if (len % 4 != 0) return false;
+    size_t done = b64Codec().decodeBlocks(src, len, dst);
+    size_t tail = 0;
+    if (!b64DecodeScalar(src + done, len - done, dst + done / 4 * 3, &tail)) {
+        return false;
+    }
+    *outLen = done / 4 * 3 + tail;
+    return true;
+}
+
+// Base64 글자 수 → 디코드 길이 (글자 검사 없이 길이/패딩만 확인)
+inline int64_t b64DecodedLen(const uint8_t* src, int64_t len) {
+    if (len % 4 != 0) {
+        throw std::runtime_error("Base64 길이가 4의 배수가 아닙니다.");
+    }
+    if (len == 0) return 0;
+    int pad = (src[len - 1] == '=') + (len >= 2 && src[len - 1] == '=' && src[len - 2] == '=');
+    return len / 4 * 3 - pad;
+}
+
+} // namespace
+
+/*******************************************************
+ * 8-3) 작은 셀 멀티 버퍼 AES-GCM (AES-NI / VAES + PCLMUL)
+ *  - 전화번호/코드/날짜 같은 5~30바이트 셀은 EVP 호출(IV 설정, Final, 태그)이 AES 보다 비쌈
+ *  - 평문 kSmallCellMax 바이트 이하 셀을 kSmallCellBatch 개까지 모아
+ *    셀마다 J0 + 카운터 블록을 한 배열에 펼친 뒤 AES 라운드를 섞어서 돌림
+ *    (AES-NI 8블록 / VAES 256·512비트 16블록 단위 - 서로 다른 셀의 블록이 파이프라인을 채움)
+ *  - GHASH: 셀당 블록이 (kSmallMaxBlocks + 1)개 이하이므로 H 거듭제곱을 미리 구해 두고
+ *    블록별 곱을 모아서 리덕션은 셀마다 한 번
+ *  - 라운드 키/H 거듭제곱은 setKey 에서 한 번 (엔진을 쓸 수 없는 CPU 면 NULL → EVP 경로)
+ *  - 키 길이(라운드 수)와 태그 길이는 템플릿 인자 → (ISA, 키 길이) 조합마다 smallGcmRun 을
+ *    따로 만들고 setKey 에서 하나를 골라 SmallGcmKey::run 에 넣어 둠 (셀 루프 안에 분기 없음)
+ *  - AAD 없음, IV 12바이트 고정 (J0 = IV || 1), 태그 16바이트 (aesEncryptGcm 과 같은 결과)
+ *******************************************************/
+namespace {
+
+const int kSmallCellMax = 64;
+const int kSmallCellBatch = 8;
+const int kSmallMaxBlocks = kSmallCellMax / 16;
+// VAES 는 16블록 단위로 읽으므로 뒤를 0 블록으로 채울 여유 포함
+const int kSmallBlockCapacity = (kSmallCellBatch * (kSmallMaxBlocks + 1) + 15) / 16 * 16;
+
+const int kSmallTagLen = 16;
+
+struct SmallGcmKey;
+
+// 셀 count 개 (<= kSmallCellBatch, 길이 1..kSmallCellMax)
+//  - ivs[i]: 12바이트 IV (뒤로 4바이트 더 읽어도 되는 위치 - 셀 버퍼 안)
+//  - encrypt: ins = 평문 → outs = 암호문, tags 에 태그 기록
+//  - decrypt: ins = 암호문 → outs = 평문, tags 와 비교해서 틀린 셀은 출력을 지움
+//  - 반환: 태그가 틀린 셀 비트마스크 (encrypt 는 항상 0)
+typedef uint32_t (*SmallGcmRunFn)(const SmallGcmKey& k, int count,
+                                  const uint8_t* const* ivs, const uint8_t* const* ins,
+                                  const int* lens, uint8_t* const* outs, uint8_t* const* tags,
+                                  bool decrypt);
+
+struct SmallGcmKey {
+    uint8_t roundKeys[15][16];
+    uint8_t hPow[kSmallMaxBlocks + 1][16];   // hPow[j] = H^(j+1) (바이트 역순)
+    SmallGcmRunFn run;                       // setKey 에서 고른 특수화
+};
+
+template <int KeyBits>
+struct AesParams {
+    static_assert(KeyBits == 128 || KeyBits == 192 || KeyBits == 256, "AES-128/192/256 만 지원");
+    static constexpr int kNk = KeyBits / 32;       // 키 워드 수
+    static constexpr int kRounds = kNk + 6;
+};
+
+#ifdef HCRYPT_X86_SIMD
+
+typedef void (*SmallAesFn)(const SmallGcmKey& k, __m128i* blocks, int count);
+
+enum SmallGcmIsa { kSmallGcmNone, kSmallGcmAesNi, kSmallGcmVaes256, kSmallGcmVaes512 };
+
+struct SmallGcmEngine {
+    const char* name;
+    SmallGcmIsa isa;
+};
+
+__attribute__((target("aes,sse4.1")))
+uint32_t aesSubWord(uint32_t w) {
+    __m128i v = _mm_insert_epi32(_mm_setzero_si128(), (int)w, 1);
+    return (uint32_t)_mm_cvtsi128_si32(_mm_aeskeygenassist_si128(v, 0));
+}
+
+// FIPS-197 키 확장 (워드는 리틀 엔디언으로 읽은 값, SubWord 는 AESKEYGENASSIST)
+template <int KeyBits>
+void expandAesKey(const uint8_t* key, SmallGcmKey& k) {
+    constexpr int kNk = AesParams<KeyBits>::kNk;
+    constexpr int kWords = 4 * (AesParams<KeyBits>::kRounds + 1);
+    uint32_t w[kWords];
+    std::memcpy(w, key, 4 * kNk);
+    uint32_t rcon = 1;
+    for (int i = kNk; i < kWords; i++) {
+        uint32_t t = w[i - 1];
+        if (i % kNk == 0) {
+            t = aesSubWord(t);
+            t = ((t >> 8) | (t << 24)) ^ rcon;
+            rcon = (rcon << 1) ^ ((rcon & 0x80) ? 0x11b : 0);
+        } else if constexpr (kNk > 6) {
+            if (i % kNk == 4) t = aesSubWord(t);   // AES-256 만
+        }
+        w[i] = w[i - kNk] ^ t;
+    }
+    std::memcpy(k.roundKeys, w, sizeof(w));
+    OPENSSL_cleanse(w, sizeof(w));
+}
+
+template <int Rounds>
+__attribute__((target("aes,sse2")))
+void smallAesBlocksNi(const SmallGcmKey& k, __m128i* blocks, int count) {
+    for (int base = 0; base < count; base += 8) {
+        __m128i rk = _mm_loadu_si128((const __m128i*)k.roundKeys[0]);
+        __m128i b[8];
+        for (int j = 0; j < 8; j++) b[j] = _mm_xor_si128(blocks[base + j], rk);
+        for (int r = 1; r < Rounds; r++) {
+            rk = _mm_loadu_si128((const __m128i*)k.roundKeys[r]);
+            for (int j = 0; j < 8; j++) b[j] = _mm_aesenc_si128(b[j], rk);
+        }
+        rk = _mm_loadu_si128((const __m128i*)k.roundKeys[Rounds]);
+        for (int j = 0; j < 8; j++) blocks[base + j] = _mm_aesenclast_si128(b[j], rk);
+    }
+}
+
+// 라운드 키 하나를 zmm 네 칸에 (maskz 형태: GCC 12 의 _mm512_broadcast_i32x4 는 -Wmaybe-uninitialized 경고)
+__attribute__((target("avx512f")))
+inline __m512i broadcastRoundKey(const uint8_t* rk) {
+    return _mm512_maskz_broadcast_i32x4((__mmask16)0xFFFF, _mm_loadu_si128((const __m128i*)rk));
+}
+
+// AVX2 단계 (AVX-512 없는 VAES CPU): ymm 8개 = 16블록
+template <int Rounds>
+__attribute__((target("avx2,vaes")))
+void smallAesBlocksVaes256(const SmallGcmKey& k, __m128i* blocks, int count) {
+    for (int base = 0; base < count; base += 16) {
+        __m256i rk = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)k.roundKeys[0]));
+        __m256i b[8];
+        for (int j = 0; j < 8; j++) {
+            b[j] = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(blocks + base + 2 * j)), rk);
+        }
+        for (int r = 1; r < Rounds; r++) {
+            rk = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)k.roundKeys[r]));
+            for (int j = 0; j < 8; j++) b[j] = _mm256_aesenc_epi128(b[j], rk);
+        }
+        rk = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)k.roundKeys[Rounds]));
+        for (int j = 0; j < 8; j++) {
+            _mm256_storeu_si256((__m256i*)(blocks + base + 2 * j), _mm256_aesenclast_epi128(b[j], rk));
+        }
+    }
+}
+
+template <int Rounds>
+__attribute__((target("avx512f,vaes")))
+void smallAesBlocksVaes512(const SmallGcmKey& k, __m128i* blocks, int count) {
+    for (int base = 0; base < count; base += 16) {
+        __m512i rk = broadcastRoundKey(k.roundKeys[0]);
+        __m512i b[4];
+        for (int j = 0; j < 4; j++) {
+            b[j] = _mm512_xor_si512(_mm512_loadu_si512(blocks + base + 4 * j), rk);
+        }
+        for (int r = 1; r < Rounds; r++) {
+            rk = broadcastRoundKey(k.roundKeys[r]);
+            for (int j = 0; j < 4; j++) b[j] = _mm512_aesenc_epi128(b[j], rk);
+        }
+        rk = broadcastRoundKey(k.roundKeys[Rounds]);
+        for (int j = 0; j < 4; j++) {
+            _mm512_storeu_si512(blocks + base + 4 * j, _mm512_aesenclast_epi128(b[j], rk));
+        }
+    }
+}
+
+SmallGcmEngine selectSmallGcmEngine() {
+    SmallGcmEngine engine = { "evp", kSmallGcmNone };
+    const CpuIsa& isa = cpuIsa();
+    if (isa.usable(HCRYPT_CPU_AESNI | HCRYPT_CPU_PCLMUL | HCRYPT_CPU_SSSE3 | HCRYPT_CPU_SSE41)) {
+        engine = { "aesni", kSmallGcmAesNi };
+        if (isa.usable(HCRYPT_CPU_AVX512F | HCRYPT_CPU_VAES)) {
+            engine = { "vaes512", kSmallGcmVaes512 };
+        } else if (isa.usable(HCRYPT_CPU_AVX2 | HCRYPT_CPU_VAES)) {
+            engine = { "vaes256", kSmallGcmVaes256 };
+        }
+    }
+    return engine;
+}
+
+const SmallGcmEngine& smallGcmEngine() {
+    static const SmallGcmEngine engine = selectSmallGcmEngine();
+    return engine;
+}
+
+// ---- GHASH (바이트 역순 표현, Intel CLMUL 백서의 shift-left-1 + 리덕션) ----
+__attribute__((target("pclmul,sse2")))
+inline void clmulAcc(__m128i a, __m128i b, __m128i& lo, __m128i& hi) {
+    __m128i mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+    lo = _mm_xor_si128(lo, _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x00), _mm_slli_si128(mid, 8)));
+    hi = _mm_xor_si128(hi, _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x11), _mm_srli_si128(mid, 8)));
+}
+
+__attribute__((target("sse2")))
+inline __m128i gfReduce(__m128i lo, __m128i hi) {
+    // 256비트 곱을 왼쪽으로 1비트 (비트 역순 표현 보정)
+    __m128i carryLo = _mm_srli_epi32(lo, 31);
+    __m128i carryHi = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    __m128i cross = _mm_srli_si128(carryLo, 12);
+    carryHi = _mm_slli_si128(carryHi, 4);
+    carryLo = _mm_slli_si128(carryLo, 4);
+    lo = _mm_or_si128(lo, carryLo);
+    hi = _mm_or_si128(_mm_or_si128(hi, carryHi), cross);
+
+    // x^128 + x^7 + x^2 + x + 1 로 리덕션
+    __m128i a = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)),
+                              _mm_slli_epi32(lo, 25));
+    __m128i aHi = _mm_srli_si128(a, 4);
+    lo = _mm_xor_si128(lo, _mm_slli_si128(a, 12));
+    __m128i b = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)),
+                              _mm_xor_si128(_mm_srli_epi32(lo, 7), aHi));
+    return _mm_xor_si128(hi, _mm_xor_si128(lo, b));
+}
+
+__attribute__((target("pclmul,sse2")))
+inline __m128i gfMul(__m128i a, __m128i b) {
+    __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+    clmulAcc(a, b, lo, hi);
+    return gfReduce(lo, hi);
+}
+
+__attribute__((target("ssse3")))
+inline __m128i byteReverse(__m128i v) {
+    return _mm_shuffle_epi8(v, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+// 앞 n 바이트만 (나머지 0)
+const uint8_t kPartialMask[32] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+__attribute__((target("sse2")))
+inline __m128i loadPartial(const uint8_t* p, int n) {
+    if (n == 16) return _mm_loadu_si128((const __m128i*)p);
+    alignas(16) uint8_t buf[16] = {0};
+    std::memcpy(buf, p, (size_t)n);
+    __m128i v = _mm_load_si128((const __m128i*)buf);
+    OPENSSL_cleanse(buf, sizeof(buf));
+    return v;
+}
+
+__attribute__((target("sse2")))
+inline void storePartial(uint8_t* p, __m128i v, int n) {
+    if (n == 16) {
+        _mm_storeu_si128((__m128i*)p, v);
+        return;
+    }
+    alignas(16) uint8_t buf[16];
+    _mm_store_si128((__m128i*)buf, v);
+    std::memcpy(p, buf, (size_t)n);
+    OPENSSL_cleanse(buf, sizeof(buf));
+}
+
+// SmallGcmRunFn 구현 (KeyBits 는 AesBlocks 의 라운드 수와 짝이 맞아야 함)
+template <int KeyBits, int TagLen, SmallAesFn AesBlocks>
+__attribute__((target("aes,pclmul,ssse3,sse4.1")))
+uint32_t smallGcmRun(const SmallGcmKey& k, int count,
+                     const uint8_t* const* ivs, const uint8_t* const* ins, const int* lens,
+                     uint8_t* const* outs, uint8_t* const* tags, bool decrypt)
+{
+    static_assert(TagLen >= 12 && TagLen <= 16, "GCM 태그는 12~16바이트");
+
+    __m128i blocks[kSmallBlockCapacity];
+    int first[kSmallCellBatch + 1];
+
+    // (1) 셀마다 J0(카운터 1) + 데이터 블록(카운터 2..) 펼치기
+    int total = 0;
+    for (int i = 0; i < count; i++) {
+        first[i] = total;
+        __m128i iv = _mm_loadu_si128((const __m128i*)ivs[i]);
+        int nb = (lens[i] + 15) / 16;
+        for (int b = 0; b <= nb; b++) {
+            blocks[total++] = _mm_insert_epi32(iv, (int)__builtin_bswap32((uint32_t)(b + 1)), 3);
+        }
+    }
+    first[count] = total;
+    for (int i = total; i < kSmallBlockCapacity; i++) blocks[i] = _mm_setzero_si128();
+
+    // (2) 모든 셀의 블록을 한꺼번에 암호화 → 키스트림
+    AesBlocks(k, blocks, total);
+
+    // (3) 셀마다 XOR + GHASH (리덕션 한 번) + 태그
+    uint32_t failed = 0;
+    for (int i = 0; i < count; i++) {
+        int len = lens[i];
+        int nb = (len + 15) / 16;
+        __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+        for (int b = 0; b < nb; b++) {
+            int n = std::min(16, len - 16 * b);
+            __m128i data = loadPartial(ins[i] + 16 * b, n);
+            __m128i res = _mm_xor_si128(data, blocks[first[i] + 1 + b]);
+            storePartial(outs[i] + 16 * b, res, n);
+            __m128i c = decrypt ? data
+                                : _mm_and_si128(res, _mm_loadu_si128((const __m128i*)(kPartialMask + 16 - n)));
+            clmulAcc(byteReverse(c), _mm_loadu_si128((const __m128i*)k.hPow[nb - b]), lo, hi);
+        }
+        // 길이 블록 [len(A) = 0][len(C) 비트] (바이트 역순이므로 아래 64비트에 그대로)
+        clmulAcc(_mm_set_epi64x(0, (long long)len * 8), _mm_loadu_si128((const __m128i*)k.hPow[0]), lo, hi);
+        __m128i tag = _mm_xor_si128(byteReverse(gfReduce(lo, hi)), blocks[first[i]]);
+
+        if (!decrypt) {
+            if constexpr (TagLen == 16) {
+                _mm_storeu_si128((__m128i*)tags[i], tag);
+            } else {
+                storePartial(tags[i], tag, TagLen);
+            }
+        } else {
+            __m128i diff;
+            if constexpr (TagLen == 16) {
+                diff = _mm_xor_si128(tag, _mm_loadu_si128((const __m128i*)tags[i]));
+            } else {
+                diff = _mm_and_si128(_mm_xor_si128(tag, loadPartial(tags[i], TagLen)),
+                                     _mm_loadu_si128((const __m128i*)(kPartialMask + 16 - TagLen)));
+            }
+            if (!_mm_testz_si128(diff, diff)) {
+                OPENSSL_cleanse(outs[i], (size_t)len);
+                failed |= 1u << i;
+            }
+        }
+    }
+    OPENSSL_cleanse(blocks, sizeof(blocks));
+    return failed;
+}
+
+template <int KeyBits, SmallAesFn AesBlocks>
+__attribute__((target("aes,pclmul,ssse3,sse4.1")))
+void initSmallGcmKey(SmallGcmKey& k, const uint8_t* key) {
+    expandAesKey<KeyBits>(key, k);
+    k.run = smallGcmRun<KeyBits, kSmallTagLen, AesBlocks>;
+
+    // H = E_K(0^128), hPow[j] = H^(j+1)
+    __m128i blocks[kSmallBlockCapacity];
+    for (int i = 0; i < kSmallBlockCapacity; i++) blocks[i] = _mm_setzero_si128();
+    AesBlocks(k, blocks, 1);
+    __m128i h = byteReverse(blocks[0]);
+    __m128i p = h;
+    for (int j = 0; j <= kSmallMaxBlocks; j++) {
+        _mm_storeu_si128((__m128i*)k.hPow[j], p);
+        p = gfMul(p, h);
+    }
+    OPENSSL_cleanse(blocks, sizeof(blocks));
+}
+
+// (ISA, 키 길이) → 특수화 하나
+template <int KeyBits>
+void initSmallGcmKeyFor(SmallGcmKey& k, const uint8_t* key, SmallGcmIsa isa) {
+    constexpr int kRounds = AesParams<KeyBits>::kRounds;
+    if (isa == kSmallGcmVaes512) {
+        initSmallGcmKey<KeyBits, smallAesBlocksVaes512<kRounds>>(k, key);
+    } else if (isa == kSmallGcmVaes256) {
+        initSmallGcmKey<KeyBits, smallAesBlocksVaes256<kRounds>>(k, key);
+    } else {
+        initSmallGcmKey<KeyBits, smallAesBlocksNi<kRounds>>(k, key);
+    }
+}
+
+#endif // HCRYPT_X86_SIMD
+
+// hcrypt_get_capabilities 용
+const char* smallGcmEngineName() {
+#ifdef HCRYPT_X86_SIMD
+    return smallGcmEngine().name;
+#else
+    return "evp";
+#endif
+}
+
+void* newSmallGcmKey(const std::vector<uint8_t>& key) {
+#ifdef HCRYPT_X86_SIMD
+    SmallGcmIsa isa = smallGcmEngine().isa;
+    if (isa == kSmallGcmNone) return nullptr;
+    SmallGcmKey* k = new SmallGcmKey();
+    switch (key.size()) {
+    case 16: initSmallGcmKeyFor<128>(*k, key.data(), isa); break;
+    case 24: initSmallGcmKeyFor<192>(*k, key.data(), isa); break;
+    default: initSmallGcmKeyFor<256>(*k, key.data(), isa); break;
+    }
+    return k;
+#else
+    (void)key;
+    return nullptr;
+#endif
+}
+
+void freeSmallGcmKey(void* smallKey) {
+    if (!smallKey) return;
+    SmallGcmKey* k = static_cast<SmallGcmKey*>(smallKey);
+    OPENSSL_cleanse(k, sizeof(*k));
+    delete k;
+}
+
+} // namespace
+
+void hcrypt_gcm_kdf::encryptSmallCells(int count, const uint8_t* const* plains,
+                                       const int* plainLens, uint8_t* const* outs,
+                                       hcrypt_nonce_mode nonceMode) const
+{
+    if (!evpCipher) {
+        throw std::runtime_error("[encryptSmallCells] 키가 설정되지 않았습니다.");
+    }
+
+    for (int base = 0; base < count; base += kSmallCellBatch) {
+        int n = std::min(kSmallCellBatch, count - base);
+
+        // 무작위 IV 는 묶음마다 RAND_bytes 한 번
+        if (nonceMode == HCRYPT_NONCE_RANDOM) {
+            StatTimer timer(kStatNsNonce);
+            uint8_t ivs[12 * kSmallCellBatch];
+            randomBytes(ivs, 12 * n, "[encryptSmallCells]");
+            for (int i = 0; i < n; i++) std::memcpy(outs[base + i], ivs + 12 * i, 12);
+        } else {
+            for (int i = 0; i < n; i++) fillIV(outs[base + i], nonceMode);
+        }
+
+#ifdef HCRYPT_X86_SIMD
+        if (smallKey) {
+            const uint8_t* ivs[kSmallCellBatch];
+            const uint8_t* ins[kSmallCellBatch];
+            int lens[kSmallCellBatch];
+            uint8_t* cts[kSmallCellBatch];
+            uint8_t* tags[kSmallCellBatch];
+            int m = 0;
+            uint64_t plainBytes = 0;
+            for (int i = base; i < base + n; i++) {
+                int len = plainLens[i];
+                if (len < 1 || len > kSmallCellMax) {
+                    aesEncryptGcm(plains[i], (size_t)std::max(len, 0), outs[i]);
+                    continue;
+                }
+                plainBytes += (uint64_t)len;
+                ivs[m] = outs[i];
+                ins[m] = plains[i];
+                lens[m] = len;
+                cts[m] = outs[i] + 12;
+                tags[m] = outs[i] + 12 + len;
+                m++;
+            }
+            if (m > 0) {
+                StatTimer timer(kStatNsAesGcm);
+                const SmallGcmKey& k = *static_cast<const SmallGcmKey*>(smallKey);
+                k.run(k, m, ivs, ins, lens, cts, tags, false);
+                statCells((uint64_t)m, plainBytes);
+            }
+            continue;
+        }
+#endif
+        for (int i = base; i < base + n; i++) {
+            aesEncryptGcm(plains[i], (size_t)std::max(plainLens[i], 0), outs[i]);
+        }
+    }
+}
+
+void hcrypt_gcm_kdf::decryptSmallCells(int count, const uint8_t* const* cells,
+                                       const int* plainLens, uint8_t* const* outs,
+                                       uint8_t* failed) const
+{
+    if (!evpCipher) {
+        throw std::runtime_error("[decryptSmallCells] 키가 설정되지 않았습니다.");
+    }
+
+#ifdef HCRYPT_X86_SIMD
+    if (smallKey) {
+        // 공유 캐시 (붙어 있을 때만): 묶기 전에 셀마다 조회, 인증을 통과한 셀만 넣음
+        ShmCellCache* shared = g_shm_cache.load(std::memory_order_acquire);
+        for (int base = 0; base < count; base += kSmallCellBatch) {
+            int n = std::min(kSmallCellBatch, count - base);
+            const uint8_t* ivs[kSmallCellBatch];
+            const uint8_t* ins[kSmallCellBatch];
+            int lens[kSmallCellBatch];
+            uint8_t* pts[kSmallCellBatch];
+            uint8_t* tags[kSmallCellBatch];
+            int idx[kSmallCellBatch];
+            int m = 0;
+            uint64_t plainBytes = 0;
+            for (int i = base; i < base + n; i++) {
+                int len = plainLens[i];
+                if (len < 1 || len > kSmallCellMax) {
+                    bool ok = aesDecryptGcm(cells[i], (size_t)std::max(len, 0) + 12 + 16, outs[i],
+                                            failed == nullptr);
+                    if (failed) failed[i] = ok ? 0 : 1;
+                    continue;
+                }
+                if (shared && shared->lookup(keyFingerprint, cells[i], (size_t)len + 12 + 16, outs[i])) {
+                    statCells(1, (uint64_t)len);
+                    if (failed) failed[i] = 0;
+                    continue;
+                }
+                plainBytes += (uint64_t)len;
+                idx[m] = i;
+                ivs[m] = cells[i];
+                ins[m] = cells[i] + 12;
+                lens[m] = len;
+                pts[m] = outs[i];
+                tags[m] = const_cast<uint8_t*>(cells[i] + 12 + len);
+                m++;
+            }
+            if (m == 0) continue;
+            StatTimer timer(kStatNsAesGcm);
+            const SmallGcmKey& k = *static_cast<const SmallGcmKey*>(smallKey);
+            uint32_t bad = k.run(k, m, ivs, ins, lens, pts, tags, true);
+            if (bad != 0) {
+                statAdd(kStatTagFailures, (uint64_t)__builtin_popcount(bad));
+                if (!failed) throw std::runtime_error("[decryptSmallCells] 태그 불일치");
+                for (int j = 0; j < m; j++) {
+                    if ((bad >> j) & 1) plainBytes -= (uint64_t)lens[j];
+                }
+            }
+            if (failed) {
+                for (int j = 0; j < m; j++) failed[idx[j]] = (bad >> j) & 1;
+            }
+            if (shared) {
+                for (int j = 0; j < m; j++) {
+                    if (!((bad >> j) & 1)) {
+                        shared->insert(keyFingerprint, cells[idx[j]], (size_t)lens[j] + 12 + 16, pts[j]);
+                    }
+                }
+            }
+            statCells((uint64_t)(m - __builtin_popcount(bad)), plainBytes);
+        }
+        return;
+    }
+#endif
+    for (int i = 0; i < count; i++) {
+        bool ok = aesDecryptGcm(cells[i], (size_t)std::max(plainLens[i], 0) + 12 + 16, outs[i],
+                                failed == nullptr);
+        if (failed) failed[i] = ok ? 0 : 1;
+    }
+}
+
+/*******************************************************
+ * 9) 내부: 테이블 암/복호화 커널 (스레드 풀 공용)
+ *******************************************************/
+namespace {
+
+// *_mt_alloc 이 쓰는 라이브러리 공용 풀
+//  - 처음 호출될 때 한 번 만들고 계속 재사용
+//  - 워커 수 = 하드웨어 스레드 수 - 1 (호출 스레드도 참여, 최소 1)
+//    호출자의 threadCount 와 무관하게 정해지고, threadCount 는 그 호출이 쓸 워커 수만 제한
+//  - fork된 자식(PHP-FPM 등)에는 부모의 워커 스레드가 없으므로 pid가 바뀌면 새로 생성
+//  - 프로세스 종료 시 join 순서 문제를 피하려고 일부러 해제하지 않음
+std::mutex g_shared_pool_mutex;
+hcrypt_pool* g_shared_pool = nullptr;
+pid_t g_shared_pool_pid = 0;
+
+hcrypt_pool* sharedPool() {
+    std::lock_guard<std::mutex> lock(g_shared_pool_mutex);
+    pid_t pid = getpid();
+    if (!g_shared_pool || g_shared_pool_pid != pid) {
+        int hw = (int)std::thread::hardware_concurrency();
+        g_shared_pool = new hcrypt_pool(std::max(hw, 2) - 1);
+        g_shared_pool_pid = pid;
+    }
+    return g_shared_pool;
+}
+
+// 공용 풀에서 threadCount 만큼만 참여 (풀 워커 + 호출 스레드를 넘지 않음)
+inline int sharedParticipants(hcrypt_pool* pool, int threadCount) {
+    return std::min(threadCount, pool->size() + 1);
+}
+
+// 구간 분할 결과
+//  - bounds  : 구간 시작 셀 인덱스 (마지막 = totalCells)
+//  - inStart : 구간별 입력 시작 위치 (복호화만)
+//  - outStart: 구간별 출력 시작 위치 (prefix-sum)
+struct ChunkPlan {
+    std::vector<int> bounds;
+    std::vector<int64_t> inStart;
+    std::vector<int64_t> outStart;
+
+    int chunks() const { return (int)bounds.size() - 1; }
+    int64_t outputSize() const { return outStart.back(); }
+};
+
+// 셀 하나를 처리하는 고정 비용을 바이트로 환산한 값
+//  - 셀 수가 아니라 "바이트 + 셀당 고정 비용" 기준으로 구간을 나눠
+//    긴 텍스트 셀이 몰린 구간과 짧은 코드 셀만 있는 구간의 작업량을 맞춤
+const int64_t kCellCostBytes    = 512;
+// 참여 스레드 1개당 구간 수 (작을수록 훔치기 단위가 큼)
+const int     kChunksPerWorker  = 8;
+// 구간 하나의 최소 작업량 (너무 잘게 나누면 스케줄링 비용이 커짐)
+const int64_t kMinChunkCost     = 64 * 1024;
+
+// 셀을 순서대로 받아 작업량이 target 에 이를 때마다 구간을 끊음
+class ChunkCutter {
+public:
+    ChunkCutter(ChunkPlan& p, int64_t totalCost, int participants)
+      : plan(p), acc(0), open(false)
+    {
+        int64_t parts = (int64_t)std::max(1, participants) * kChunksPerWorker;
+        target = std::max(kMinChunkCost, totalCost / parts);
+    }
+
+    // 셀 i 를 추가 (inOff/outOff: 이 셀의 입력/출력 시작 위치)
+    void add(int i, int64_t cost, int64_t inOff, int64_t outOff) {
+        if (!open) {
+            plan.bounds.push_back(i);
+            plan.inStart.push_back(inOff);
+            plan.outStart.push_back(outOff);
+            open = true;
+        }
+        acc += cost;
+        if (acc >= target) {
+            acc = 0;
+            open = false;
+        }
+    }
+
+    void finish(int totalCells, int64_t inEnd, int64_t outEnd) {
+        plan.bounds.push_back(totalCells);
+        plan.inStart.push_back(inEnd);
+        plan.outStart.push_back(outEnd);
+    }
+
+private:
+    ChunkPlan& plan;
+    int64_t target;
+    int64_t acc;
+    bool open;
+};
+
+// (front, back) 구간을 64비트 하나에 담아 CAS로 갱신
+inline uint64_t packRange(uint32_t front, uint32_t back) {
+    return ((uint64_t)front << 32) | back;
+}
+
+// 주인: 앞에서 하나 꺼냄
+bool popFront(std::atomic<uint64_t>& range, int& chunk) {
+    uint64_t cur = range.load();
+    for (;;) {
+        uint32_t front = (uint32_t)(cur >> 32), back = (uint32_t)cur;
+        if (front >= back) return false;
+        if (range.compare_exchange_weak(cur, packRange(front + 1, back))) {
+            chunk = (int)front;
+            return true;
+        }
+    }
+}
+
+// 도둑: 뒤에서 하나 훔침
+bool stealBack(std::atomic<uint64_t>& range, int& chunk) {
+    uint64_t cur = range.load();
+    for (;;) {
+        uint32_t front = (uint32_t)(cur >> 32), back = (uint32_t)cur;
+        if (front >= back) return false;
+        if (range.compare_exchange_weak(cur, packRange(front, back - 1))) {
+            chunk = (int)(back - 1);
+            return true;
+        }
+    }
+}
+
+// 구간 chunkCount 개를 work-stealing 으로 실행
+//  - 참여자마다 연속된 구간 묶음을 배정 (캐시/메모리 지역성 유지)
+//  - 자기 몫을 앞에서부터 처리하고, 끝나면 남은 일이 가장 많은 참여자의 몫을 뒤에서 훔침
+//  - pool 이 없으면 호출 스레드에서 순서대로
+//  - 추적 중이면 구간마다 실제로 처리한 스레드 기준으로 "chunk" 단계 기록
+void runStealing(hcrypt_pool* pool, int participants, int chunkCount,
+                 const std::function<void(int)>& fn)
+{
+    uint64_t call = traceCall();
+    auto run = [&](int chunk) {
+        TraceSpan span(call, "chunk", "chunk", chunk);
+        fn(chunk);
+    };
+
+    if (!pool || participants <= 1 || chunkCount <= 1) {
+        for (int c = 0; c < chunkCount; c++) run(c);
+        return;
+    }
+    participants = std::min(participants, chunkCount);
+
+    std::unique_ptr<std::atomic<uint64_t>[]> ranges(new std::atomic<uint64_t>[participants]);
+    for (int w = 0; w < participants; w++) {
+        uint32_t lo = (uint32_t)((int64_t)chunkCount * w / participants);
+        uint32_t hi = (uint32_t)((int64_t)chunkCount * (w + 1) / participants);
+        ranges[w].store(packRange(lo, hi));
+    }
+
+    pool->parallelFor(participants, [&](int self) {
+        int chunk;
+        while (popFront(ranges[self], chunk)) {
+            run(chunk);
+        }
+        for (;;) {
+            int victim = -1;
+            uint32_t most = 0;
+            for (int w = 0; w < participants; w++) {
+                uint64_t cur = ranges[w].load(std::memory_order_relaxed);
+                uint32_t front = (uint32_t)(cur >> 32), back = (uint32_t)cur;
+                if (back > front && back - front > most) {
+                    most = back - front;
+                    victim = w;
+                }
+            }
+            if (victim < 0) break;
+            if (stealBack(ranges[victim], chunk)) {
+                run(chunk);
+            }
+        }
+    });
+}
+
+// 셀 하나의 암호화 결과 크기 ([4바이트 encSize] 포함)
+inline int64_t encryptedCellSize(int cellLen) {
+    return cellLen > 0 ? 4 + 12 + (int64_t)cellLen + 16 : 4;
+}
+
+// 셀 출력 형식
+//  - kCellFramed: [4바이트 encSize][IV + 암호문 + 태그]
+//  - kCellBase64: Base64(IV + 암호문 + 태그), 빈 셀은 0글자 (위치는 별도 offsets 배열)
+enum CellFormat { kCellFramed, kCellBase64 };
+
+inline int64_t cellOutputSize(int cellLen, CellFormat format) {
+    if (format == kCellFramed) return encryptedCellSize(cellLen);
+    return cellLen > 0 ? (int64_t)b64EncodedLen((size_t)cellLen + 12 + 16) : 0;
+}
+
+// 워커 스레드별 임시 버퍼 (Base64 변환 전후의 암호문만 담김 - 평문은 들어가지 않음)
+uint8_t* threadScratch(size_t size) {
+    thread_local std::vector<uint8_t> buf;
+    if (buf.size() < size) buf.resize(size);
+    return buf.data();
+}
+
+inline void writeLen32(uint8_t* dst, int value) {
+    std::memcpy(dst, &value, 4);
+}
+
+// 작은 셀(평문 kSmallCellMax 이하)을 모았다가 kSmallCellBatch 개씩 멀티 버퍼 엔진(8-3)으로
+//  - 셀마다 출력 위치가 미리 정해져 있으므로 처리를 미뤄도 결과는 같음
+//  - 구간이 끝나면 flush() 로 남은 셀 처리
+struct SmallEncryptBatch {
+    const hcrypt_gcm_kdf* hc;
+    hcrypt_nonce_mode nonceMode;
+    int count;
+    const uint8_t* plains[kSmallCellBatch];
+    int lens[kSmallCellBatch];
+    uint8_t* outs[kSmallCellBatch];
+    char* b64[kSmallCellBatch];                                  // Base64 출력 위치 (framed 면 NULL)
+    uint8_t scratch[kSmallCellBatch][kSmallCellMax + 12 + 16];   // Base64 변환 전 암호문
+
+    SmallEncryptBatch(const hcrypt_gcm_kdf* h, hcrypt_nonce_mode mode)
+      : hc(h), nonceMode(mode), count(0) {}
+
+    void add(const uint8_t* plain, int len, uint8_t* out, char* b64Out = nullptr) {
+        plains[count] = plain;
+        lens[count] = len;
+        outs[count] = b64Out ? scratch[count] : out;
+        b64[count] = b64Out;
+        if (++count == kSmallCellBatch) flush();
+    }
+
+    void flush() {
+        if (count == 0) return;
+        hc->encryptSmallCells(count, plains, lens, outs, nonceMode);
+        for (int i = 0; i < count; i++) {
+            if (b64[i]) b64Encode(outs[i], (size_t)lens[i] + 12 + 16, b64[i]);
+        }
+        count = 0;
+    }
+};
+
+// 셀별 복호화 상태 (opts->cell_status)
+//  - codes 가 NULL 이면 예전처럼 셀 하나라도 실패하면 예외 → 테이블 전체 실패
+//  - 셀 i 는 그 셀을 맡은 워커만 쓰므로 codes 는 잠금 없이 기록, 실패 수만 원자 카운터
+struct CellStatus {
+    uint8_t* codes;
+    int64_t* failedOut;
+    std::atomic<int64_t> failed;
+
+    explicit CellStatus(const hcrypt_table_opts* opts)
+      : codes(opts ? opts->cell_status : nullptr),
+        failedOut(opts ? opts->failed_cells : nullptr),
+        failed(0) {}
+
+    bool on() const { return codes != nullptr; }
+    void set(int i, hcrypt_cell_status code) { codes[i] = (uint8_t)code; }
+    void fail(int i, hcrypt_cell_status code) {
+        codes[i] = (uint8_t)code;
+        failed.fetch_add(1, std::memory_order_relaxed);
+    }
+    bool ok(int i) const { return !codes || codes[i] == HCRYPT_CELL_OK; }
+
+    // 커널이 끝난 뒤 실패 수 기록
+    void publish() {
+        if (on() && failedOut) *failedOut = failed.load();
+    }
+};
+
+// 셀 헤더만 보고 정하는 상태 (복호화 전)
+inline hcrypt_cell_status cellStatusOf(bool picked, int encSize) {
+    if (!picked) return HCRYPT_CELL_SKIPPED;
+    if (encSize > 0 && encSize < 12 + 16) return HCRYPT_CELL_BAD_LENGTH;
+    return HCRYPT_CELL_OK;
+}
+
+// 큰 셀 하나 복호화 (status 가 켜져 있으면 태그 불일치를 예외 대신 기록)
+inline void decryptCell(const hcrypt_gcm_kdf* hc, const uint8_t* cell, size_t encLen,
+                        uint8_t* out, CellStatus* status, int i) {
+    if (status && status->on()) {
+        if (!hc->tryDecryptInto(cell, encLen, out)) status->fail(i, HCRYPT_CELL_TAG_MISMATCH);
+        return;
+    }
+    hc->decryptInto(cell, encLen, out);
+}
+
+struct SmallDecryptBatch {
+    const hcrypt_gcm_kdf* hc;
+    CellStatus* status;
+    int count;
+    const uint8_t* cells[kSmallCellBatch];
+    int lens[kSmallCellBatch];
+    uint8_t* outs[kSmallCellBatch];
+    int index[kSmallCellBatch];
+    // Base64 디코드 결과 (3바이트 단위로 올림 + SIMD 디코더 여유)
+    uint8_t scratch[kSmallCellBatch][(kSmallCellMax + 12 + 16 + 2) / 3 * 3 + kB64DecodeSlack];
+
+    explicit SmallDecryptBatch(const hcrypt_gcm_kdf* h, CellStatus* st = nullptr)
+      : hc(h), status(st && st->on() ? st : nullptr), count(0) {}
+
+    // 다음 add 에 쓸 Base64 디코드 버퍼
+    uint8_t* nextScratch() { return scratch[count]; }
+
+    // cell = [IV][암호문][태그] (plainLen + 28 바이트), i = 상태를 기록할 셀 번호
+    void add(const uint8_t* cell, int plainLen, uint8_t* out, int i) {
+        cells[count] = cell;
+        lens[count] = plainLen;
+        outs[count] = out;
+        index[count] = i;
+        if (++count == kSmallCellBatch) flush();
+    }
+
+    void flush() {
+        if (count == 0) return;
+        if (!status) {
+            hc->decryptSmallCells(count, cells, lens, outs);
+        } else {
+            uint8_t failed[kSmallCellBatch];
+            hc->decryptSmallCells(count, cells, lens, outs, failed);
+            for (int j = 0; j < count; j++) {
+                if (failed[j]) status->fail(index[j], HCRYPT_CELL_TAG_MISMATCH);
+            }
+        }
+        count = 0;
+    }
+};
+
+// 셀 평문 최대 길이 ([4바이트 encSize]에 평문 + 28 이 들어가야 함)
+const int64_t kMaxCellLen = INT_MAX - 12 - 16;
+
+// 평문 셀 입력
+//  - 포인터 배열  : table[i] 에서 cell_sizes[i] 바이트
+//  - Arrow 레이아웃: values[offsets[i] .. offsets[i+1]) (복사 없이 그대로 참조)
+struct CellSource {
+    const uint8_t** table;
+    const int* sizes;
+    const uint8_t* values;
+    const int64_t* offsets;
+
+    static CellSource fromTable(const uint8_t** table, const int* sizes) {
+        CellSource src = { table, sizes, nullptr, nullptr };
+        return src;
+    }
+    static CellSource fromValues(const uint8_t* values, const int64_t* offsets) {
+        CellSource src = { nullptr, nullptr, values, offsets };
+        return src;
+    }
+
+    int len(int i) const {
+        return offsets ? (int)(offsets[i + 1] - offsets[i]) : sizes[i];
+    }
+    const uint8_t* data(int i) const {
+        return offsets ? values + offsets[i] : table[i];
+    }
+
+    // 범위 검사 (Arrow 레이아웃은 offsets 가 values_len 안에서 단조 증가해야 함)
+    void validate(int totalCells, int64_t valuesLen) const {
+        if (offsets) {
+            if (offsets[0] < 0 || offsets[totalCells] > valuesLen) {
+                throw std::invalid_argument("offsets가 values 범위를 벗어납니다.");
+            }
+            for (int i = 0; i < totalCells; i++) {
+                int64_t n = offsets[i + 1] - offsets[i];
+                if (n < 0 || n > kMaxCellLen) {
+                    throw std::invalid_argument("offsets가 잘못되었습니다 (감소 또는 셀 길이 초과).");
+                }
+            }
+        } else {
+            for (int i = 0; i < totalCells; i++) {
+                if (sizes[i] > kMaxCellLen) {
+                    throw std::invalid_argument("셀 길이가 너무 깁니다.");
+                }
+            }
+        }
+    }
+};
+
+int64_t encryptedTableSize(const CellSource& src, int totalCells,
+                           CellFormat format = kCellFramed) {
+    int64_t total = 0;
+    for (int i = 0; i < totalCells; i++) {
+        total += cellOutputSize(src.len(i), format);
+    }
+    return total;
+}
+
+// 암호화 구간 분할 (바이트 기준) + 구간별 출력 시작 위치
+ChunkPlan planEncrypt(const CellSource& src, int totalCells, int participants,
+                      CellFormat format) {
+    StatTimer timer(kStatNsOutput);
+    TraceSpan span(traceCall(), "plan", "cells", totalCells);
+    int64_t totalCost = 0;
+    for (int i = 0; i < totalCells; i++) {
+        totalCost += cellOutputSize(src.len(i), format) + kCellCostBytes;
+    }
+
+    ChunkPlan plan;
+    ChunkCutter cutter(plan, totalCost, participants);
+    int64_t outOffset = 0;
+    for (int i = 0; i < totalCells; i++) {
+        int64_t cellOut = cellOutputSize(src.len(i), format);
+        cutter.add(i, cellOut + kCellCostBytes, 0, outOffset);
+        outOffset += cellOut;
+    }
+    cutter.finish(totalCells, 0, outOffset);
+    return plan;
+}
+
+// N×M 테이블 암호화 → out 에 [4바이트 encSize][enc] × totalCells 직접 기록
+//  - 구간별 시작 위치를 prefix-sum 으로 미리 구해 두고, 스레드는 자기 구간만 기록
+//  - participants: 동시에 일할 스레드 수 (구간 크기 결정용)
+//  - kCellBase64: 셀마다 Base64 글자를 이어 붙이고 outOffsets(totalCells+1개)에 위치 기록
+//    (암호화 → 스레드 임시 버퍼 → Base64 인코딩을 같은 워커가 한 번에 처리)
+int64_t encryptTableInto(
+    const hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const CellSource& src,
+    int totalCells,
+    int participants,
+    hcrypt_nonce_mode nonceMode,
+    uint8_t* out,
+    int64_t capacity,
+    CellFormat format = kCellFramed,
+    int64_t* outOffsets = nullptr
+) {
+    // (1) 키 확인 (hc 하나를 모든 워커가 공유)
+    if (hc->getKeyLength() == 0) {
+        throw std::runtime_error("[encryptTableInto] 키가 설정되지 않음");
+    }
+    statAdd(kStatCalls, 1);
+
+    // (2) 바이트 기준 구간 분할 + 구간별 출력 시작 위치
+    ChunkPlan plan = planEncrypt(src, totalCells, participants, format);
+    int64_t total = plan.outputSize();
+    if (total > capacity) {
+        throw std::runtime_error("[encryptTableInto] 출력 버퍼 용량 부족");
+    }
+
+    // (3-a) Base64 출력
+    if (format == kCellBase64) {
+        runStealing(pool, participants, plan.chunks(), [&](int c) {
+            SmallEncryptBatch small(hc, nonceMode);
+            uint8_t* dst = out + plan.outStart[c];
+            for (int i = plan.bounds[c]; i < plan.bounds[c + 1]; i++) {
+                int cellLen = src.len(i);
+                outOffsets[i] = dst - out;
+                if (cellLen <= 0) continue;
+
+                size_t encLen = (size_t)cellLen + 12 + 16;
+                if (cellLen <= kSmallCellMax) {
+                    small.add(src.data(i), cellLen, nullptr, reinterpret_cast<char*>(dst));
+                    dst += b64EncodedLen(encLen);
+                    continue;
+                }
+                uint8_t* enc = threadScratch(encLen);
+                hc->encryptInto(src.data(i), (size_t)cellLen, enc, nonceMode);
+                dst += b64Encode(enc, encLen, reinterpret_cast<char*>(dst));
+            }
+            small.flush();
+        });
+        outOffsets[totalCells] = total;
+        return total;
+    }
+
+    // (3-b) 구간별 작업 - [4바이트 encSize] + [IV + 암호문 + 태그] 바로 기록
+    runStealing(pool, participants, plan.chunks(), [&](int c) {
+        SmallEncryptBatch small(hc, nonceMode);
+        uint8_t* dst = out + plan.outStart[c];
+        for (int i = plan.bounds[c]; i < plan.bounds[c + 1]; i++) {
+            int cellLen = src.len(i);
+
+            // 빈 셀 → [4바이트 encSize=0]만
+            if (cellLen <= 0) {
+                writeLen32(dst, 0);
+                dst += 4;
+                continue;
+            }
+
+            writeLen32(dst, cellLen + 12 + 16);
+            if (cellLen <= kSmallCellMax) {
+                small.add(src.data(i), cellLen, dst + 4);
+            } else {
+                hc->encryptInto(src.data(i), (size_t)cellLen, dst + 4, nonceMode);
+            }
+            dst += encryptedCellSize(cellLen);
+        }
+        small.flush();
+    });
+    return total;
+}
+
+// 셀 암호문 길이 → 평문 길이 (28바이트 미만은 빈 결과)
+inline int plainLenOf(int encSize) {
+    return encSize >= 12 + 16 ? encSize - 12 - 16 : 0;
+}
+
+// 건너뛰는 셀 하나의 비용 (헤더만 보고 넘어감)
+const int64_t kSkipCellCost = 16;
+
+// 복호화 열 선택 (opts->col_mask)
+//  - bits: LSB-first 비트맵, 비트 1 = 복호화할 열 / NULL = 모든 열
+//  - 선택하지 않은 열은 인증/복호화 없이 빈 셀로 돌려줌
+struct ColumnMask {
+    const uint8_t* bits;
+    int colCount;
+
+    bool all() const { return bits == nullptr; }
+    bool selected(int cell) const {
+        if (!bits) return true;
+        int c = cell % colCount;
+        return (bits[c >> 3] >> (c & 7)) & 1;
+    }
+
+    // 구간 분할용 작업량 추정: 선택한 열 비율만큼만 바이트를 셈
+    int64_t estimateCost(int64_t bytes, int totalCells) const {
+        int64_t full = bytes + (int64_t)totalCells * kCellCostBytes;
+        if (!bits || colCount <= 0) return full;
+        int picked = 0;
+        for (int c = 0; c < colCount; c++) {
+            picked += (bits[c >> 3] >> (c & 7)) & 1;
+        }
+        return full / colCount * picked + (int64_t)totalCells * kSkipCellCost;
+    }
+};
+
+inline ColumnMask columnMaskOf(const hcrypt_table_opts* opts, int colCount) {
+    ColumnMask mask = { opts ? opts->col_mask : nullptr, colCount };
+    return mask;
+}
+
+const ColumnMask kAllColumns = { nullptr, 0 };
+
+// enc_data 헤더만 훑어서 범위 검사 + 바이트 기준 구간 분할
+//  - 전체 작업량은 enc_data_len 으로 미리 알 수 있으므로 스캔하면서 바로 구간을 끊음
+//  - mask 로 뺀 열은 출력 크기 0, 작업량은 헤더 하나 건너뛰는 만큼만 셈
+ChunkPlan planDecrypt(const uint8_t* enc_data, int64_t enc_data_len,
+                      int totalCells, int participants,
+                      const ColumnMask& mask = kAllColumns)
+{
+    StatTimer timer(kStatNsOutput);
+    TraceSpan span(traceCall(), "plan", "cells", totalCells);
+    ChunkPlan plan;
+    ChunkCutter cutter(plan, mask.estimateCost(enc_data_len, totalCells), participants);
+
+    int64_t offset = 0, outOffset = 0;
+    for (int i = 0; i < totalCells; i++) {
+        if (offset + 4 > enc_data_len) {
+            throw std::runtime_error("복호화: enc_data 범위 초과(헤더4바이트)");
+        }
+        int encSize = 0;
+        std::memcpy(&encSize, enc_data + offset, 4);
+        offset += 4;
+
+        if (encSize < 0 || offset + encSize > enc_data_len) {
+            throw std::runtime_error("복호화: enc_data 범위 초과(encSize)");
+        }
+        if (mask.selected(i)) {
+            cutter.add(i, 4 + encSize + kCellCostBytes, offset - 4, outOffset);
+            outOffset += 4 + plainLenOf(encSize);
+        } else {
+            cutter.add(i, kSkipCellCost, offset - 4, outOffset);
+            outOffset += 4;
+        }
+        offset += encSize;
+    }
+    cutter.finish(totalCells, offset, outOffset);
+    return plan;
+}
+
+// [4바이트 encSize][enc] × totalCells → out 에 [4바이트 plainLen][plain] × totalCells 직접 기록
+//  - plan: planDecrypt() 로 미리 훑어 둔 구간별 입력/출력 위치 (같은 mask 로 만든 것)
+int64_t decryptTableInto(
+    const hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    int participants,
+    const uint8_t* enc_data,
+    const ChunkPlan& plan,
+    uint8_t* out,
+    int64_t capacity,
+    const ColumnMask& mask = kAllColumns,
+    CellStatus* status = nullptr
+) {
+    if (hc->getKeyLength() == 0) {
+        throw std::runtime_error("[decryptTableInto] 키가 설정되지 않음");
+    }
+    statAdd(kStatCalls, 1);
+
+    // (1) 출력 크기 확인
+    int64_t total = plan.outputSize();
+    if (total > capacity) {
+        throw std::runtime_error("[decryptTableInto] 출력 버퍼 용량 부족");
+    }
+
+    // (2) 구간별 작업 - [4바이트 plainLen] + [plainData] 바로 기록
+    bool perCell = status && status->on();
+    runStealing(pool, participants, plan.chunks(), [&](int c) {
+        SmallDecryptBatch small(hc, status);
+        const uint8_t* src = enc_data + plan.inStart[c];
+        uint8_t* dst = out + plan.outStart[c];
+        for (int i = plan.bounds[c]; i < plan.bounds[c + 1]; i++) {
+            int encSize = 0;
+            std::memcpy(&encSize, src, 4);
+            src += 4;
+
+            bool picked = mask.selected(i);
+            int plainLen = picked ? plainLenOf(encSize) : 0;
+            // 셀 상태를 쓰지 않으면 IV + 태그보다 짧은 셀은 예전처럼 빈 셀
+            if (perCell) {
+                hcrypt_cell_status code = cellStatusOf(picked, encSize);
+                if (code == HCRYPT_CELL_BAD_LENGTH) status->fail(i, code);
+                else status->set(i, code);
+            }
+            writeLen32(dst, plainLen);
+            dst += 4;
+            if (plainLen > 0) {
+                if (plainLen <= kSmallCellMax) {
+                    small.add(src, plainLen, dst, i);
+                } else {
+                    decryptCell(hc, src, (size_t)encSize, dst, status, i);
+                }
+                dst += plainLen;
+            }
+            src += encSize;
+        }
+        small.flush();
+    });
+    if (status) status->publish();
+    return total;
+}
+
+// 셀마다 [4바이트 plainLen] 헤더가 하나씩 붙으므로
+// values 버퍼 위치 = (인터리브 출력 위치) - 4 * (셀 인덱스)
+inline int64_t valuesOffsetOf(const ChunkPlan& plan, int c) {
+    return plan.outStart[c] - 4 * (int64_t)plan.bounds[c];
+}
+
+inline int64_t valuesSizeOf(const ChunkPlan& plan, int totalCells) {
+    return plan.outputSize() - 4 * (int64_t)totalCells;
+}
+
+// validity(선택): LSB-first 비트맵, 비트 1 = 값 있음 / 0 = 빈 셀(NULL) 또는 실패한 셀
+//  - 청크 경계가 바이트 단위가 아니므로 병렬 패스가 끝난 뒤 offsets 로 한 번에 채움
+void fillValidity(const int64_t* offsets, int totalCells, uint8_t* validity,
+                  const CellStatus* status = nullptr) {
+    if (!validity) return;
+    TraceSpan span(traceCall(), "validity", "cells", totalCells);
+    std::memset(validity, 0, ((size_t)totalCells + 7) / 8);
+    for (int i = 0; i < totalCells; i++) {
+        if (offsets[i + 1] > offsets[i] && (!status || status->ok(i))) {
+            validity[i >> 3] |= (uint8_t)(1u << (i & 7));
+        }
+    }
+}
+
+// [4바이트 encSize][enc] × totalCells → 평문만 이어 붙인 values + int64 offsets(totalCells+1개)
+//  - 셀 i 평문 = values[offsets[i] .. offsets[i+1])
+int64_t decryptTableValuesInto(
+    const hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    int participants,
+    const uint8_t* enc_data,
+    const ChunkPlan& plan,
+    int totalCells,
+    uint8_t* values,
+    int64_t capacity,
+    int64_t* offsets,
+    uint8_t* validity,
+    const ColumnMask& mask = kAllColumns,
+    CellStatus* status = nullptr
+) {
+    if (hc->getKeyLength() == 0) {
+        throw std::runtime_error("[decryptTableValuesInto] 키가 설정되지 않음");
+    }
+    statAdd(kStatCalls, 1);
+
+    int64_t total = valuesSizeOf(plan, totalCells);
+    if (total > capacity) {
+        throw std::runtime_error("[decryptTableValuesInto] 출력 버퍼 용량 부족");
+    }
+
+    bool perCell = status && status->on();
+    runStealing(pool, participants, plan.chunks(), [&](int c) {
+        SmallDecryptBatch small(hc, status);
+        const uint8_t* src = enc_data + plan.inStart[c];
+        int64_t pos = valuesOffsetOf(plan, c);
+        for (int i = plan.bounds[c]; i < plan.bounds[c + 1]; i++) {
+            int encSize = 0;
+            std::memcpy(&encSize, src, 4);
+            src += 4;
+
+            offsets[i] = pos;
+            bool picked = mask.selected(i);
+            int plainLen = picked ? plainLenOf(encSize) : 0;
+            // 셀 상태를 쓰지 않으면 IV + 태그보다 짧은 셀은 예전처럼 빈 셀
+            if (perCell) {
+                hcrypt_cell_status code = cellStatusOf(picked, encSize);
+                if (code == HCRYPT_CELL_BAD_LENGTH) status->fail(i, code);
+                else status->set(i, code);
+            }
+            if (plainLen > 0) {
+                if (plainLen <= kSmallCellMax) {
+                    small.add(src, plainLen, values + pos, i);
+                } else {
+                    decryptCell(hc, src, (size_t)encSize, values + pos, status, i);
+                }
+                pos += plainLen;
+            }
+            src += encSize;
+        }
+        small.flush();
+    });
+    offsets[totalCells] = total;
+    fillValidity(offsets, totalCells, validity, status);
+    if (status) status->publish();
+    return total;
+}
+
+// Base64 셀 암호문(values + offsets) 훑어서 바이트 기준 구간 분할
+//  - 글자 검사는 디코딩할 때 워커가 함 (여기서는 길이/패딩만 확인)
+//  - outStart 는 평문 values 위치 (헤더 없음)
+//  - perCell: 길이가 4의 배수가 아닌 셀을 예외 대신 0 바이트로 잡음
+//             (워커가 HCRYPT_CELL_BAD_BASE64 로 기록)
+ChunkPlan planDecryptB64(const CellSource& src, int totalCells, int participants,
+                         const ColumnMask& mask = kAllColumns, bool perCell = false) {
+    StatTimer timer(kStatNsOutput);
+    TraceSpan span(traceCall(), "plan", "cells", totalCells);
+    int64_t totalCost = 0;
+    for (int i = 0; i < totalCells; i++) {
+        totalCost += mask.selected(i) ? src.len(i) + kCellCostBytes : kSkipCellCost;
+    }
+
+    ChunkPlan plan;
+    ChunkCutter cutter(plan, totalCost, participants);
+    int64_t outOffset = 0;
+    for (int i = 0; i < totalCells; i++) {
+        if (!mask.selected(i)) {
+            cutter.add(i, kSkipCellCost, 0, outOffset);
+            continue;
+        }
+        cutter.add(i, src.len(i) + kCellCostBytes, 0, outOffset);
+        if (perCell && src.len(i) % 4 != 0) continue;
+        int64_t encLen = b64DecodedLen(src.data(i), src.len(i));
+        outOffset += plainLenOf((int)encLen);
+    }
+    cutter.finish(totalCells, 0, outOffset);
+    return plan;
+}
+
+// Base64 셀 암호문 → 평문 values + offsets (+ validity)
+//  - 디코딩 → 스레드 임시 버퍼 → 복호화를 같은 워커가 한 번에 처리
+int64_t decryptTableB64Into(
+    const hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    int participants,
+    const CellSource& src,
+    const ChunkPlan& plan,
+    int totalCells,
+    uint8_t* values,
+    int64_t capacity,
+    int64_t* offsets,
+    uint8_t* validity,
+    const ColumnMask& mask = kAllColumns,
+    CellStatus* status = nullptr
+) {
+    if (hc->getKeyLength() == 0) {
+        throw std::runtime_error("[decryptTableB64Into] 키가 설정되지 않음");
+    }
+    statAdd(kStatCalls, 1);
+
+    int64_t total = plan.outputSize();
+    if (total > capacity) {
+        throw std::runtime_error("[decryptTableB64Into] 출력 버퍼 용량 부족");
+    }
+
+    bool perCell = status && status->on();
+    runStealing(pool, participants, plan.chunks(), [&](int c) {
+        SmallDecryptBatch small(hc, status);
+        int64_t pos = plan.outStart[c];
+        for (int i = plan.bounds[c]; i < plan.bounds[c + 1]; i++) {
+            offsets[i] = pos;
+            int b64Len = src.len(i);
+            bool picked = mask.selected(i);
+            if (perCell) status->set(i, picked ? HCRYPT_CELL_OK : HCRYPT_CELL_SKIPPED);
+            if (b64Len == 0 || !picked) continue;
+
+            // 작은 셀은 묶음 버퍼에 디코딩 (묶음이 찰 때까지 남아 있어야 하므로)
+            bool isSmall = b64Len <= (int)b64EncodedLen(kSmallCellMax + 12 + 16);
+            uint8_t* enc = isSmall ? small.nextScratch()
+                                   : threadScratch((size_t)b64Len / 4 * 3 + kB64DecodeSlack);
+            size_t encLen = 0;
+            if (!b64Decode(reinterpret_cast<const char*>(src.data(i)), (size_t)b64Len, enc, &encLen)) {
+                if (!perCell) throw std::runtime_error("[decryptTableB64Into] Base64 디코딩 실패");
+                // plan 이 길이/패딩만 보고 잡아 둔 자리는 0 으로 채우고 넘어감 (길이가 틀리면 0)
+                int planned = b64Len % 4 != 0 ? 0 : plainLenOf((int)b64DecodedLen(src.data(i), b64Len));
+                std::memset(values + pos, 0, (size_t)planned);
+                pos += planned;
+                status->fail(i, HCRYPT_CELL_BAD_BASE64);
+                continue;
+            }
+            int plainLen = plainLenOf((int)encLen);
+            if (perCell && encLen < 12 + 16) status->fail(i, HCRYPT_CELL_BAD_LENGTH);
+            if (plainLen > 0) {
+                if (isSmall) {
+                    small.add(enc, plainLen, values + pos, i);
+                } else {
+                    decryptCell(hc, enc, encLen, values + pos, status, i);
+                }
+                pos += plainLen;
+            }
+        }
+        small.flush();
+    });
+    offsets[totalCells] = total;
+    fillValidity(offsets, totalCells, validity, status);
+    if (status) status->publish();
+    return total;
+}
+
+// 테이블 크기 검사 (rowCount*colCount 오버플로 포함)
+int checkedCellCount(int rowCount, int colCount) {
+    if (rowCount < 0 || colCount < 0) {
+        throw std::invalid_argument("rowCount/colCount는 0 이상이어야 합니다.");
+    }
+    int64_t total = (int64_t)rowCount * colCount;
+    if (total > INT_MAX) {
+        throw std::invalid_argument("셀 개수가 너무 많습니다.");
+    }
+    return (int)total;
+}
+
+// *_alloc 용: 정확한 크기로 한 번만 할당 (int 범위 검사 포함)
+uint8_t* allocResult(int64_t size, const char* where) {
+    if (size > INT_MAX) {
+        throw std::runtime_error(std::string(where) + " 결과가 2GB를 넘습니다. *_into 함수를 사용하세요.");
+    }
+    StatTimer timer(kStatNsAlloc);
+    TraceSpan span(traceCall(), "alloc", "bytes", size);
+    return new uint8_t[size > 0 ? size : 1];
+}
+
+// 옵션 → nonce 방식 (NULL이면 기본값)
+hcrypt_nonce_mode nonceModeOf(const hcrypt_table_opts* opts) {
+    if (!opts) return HCRYPT_NONCE_RANDOM;
+    switch (opts->nonce_mode) {
+    case HCRYPT_NONCE_RANDOM:  return HCRYPT_NONCE_RANDOM;
+    case HCRYPT_NONCE_COUNTER: return HCRYPT_NONCE_COUNTER;
+    default:
+        throw std::invalid_argument("지원하지 않는 nonce_mode");
+    }
+}
+
+// 암호화 *_alloc 공용 구현
+//  - src 는 호출 전에 validate() 를 거친 것이어야 함
+uint8_t* encryptTableAlloc(hcrypt_gcm_kdf* hc, hcrypt_pool* pool,
+                           const CellSource& src, int totalCells, int participants,
+                           const hcrypt_table_opts* opts,
+                           int* out_len, const char* where)
+{
+    hcrypt_nonce_mode nonceMode = nonceModeOf(opts);
+    int64_t size = encryptedTableSize(src, totalCells);
+    uint8_t* result = allocResult(size, where);
+    try {
+        encryptTableInto(hc, pool, src, totalCells, participants, nonceMode,
+                         result, size);
+    } catch (...) {
+        delete[] result;
+        throw;
+    }
+    *out_len = (int)size;
+    return result;
+}
+
+// 복호화 *_alloc 공용 구현
+uint8_t* decryptTableAlloc(hcrypt_gcm_kdf* hc, hcrypt_pool* pool,
+                           const uint8_t* enc_data, int64_t enc_data_len,
+                           int rowCount, int colCount, int participants,
+                           const hcrypt_table_opts* opts,
+                           int* out_len, const char* where)
+{
+    int totalCells = checkedCellCount(rowCount, colCount);
+    ColumnMask mask = columnMaskOf(opts, colCount);
+    ChunkPlan plan = planDecrypt(enc_data, enc_data_len, totalCells, participants, mask);
+    int64_t size = plan.outputSize();
+    uint8_t* result = allocResult(size, where);
+    try {
+        CellStatus status(opts);
+        decryptTableInto(hc, pool, participants, enc_data, plan, result, size, mask, &status);
+    } catch (...) {
+        OPENSSL_cleanse(result, size);
+        delete[] result;
+        throw;
+    }
+    *out_len = (int)size;
+    return result;
+}
+
+} // namespace
+
+/*******************************************************
+ * 9-1) 스트리밍 세션 (hcrypt_stream)
+ *  - push 한 행 묶음(batch)을 복사해 두고 풀에 넘겨 비동기로 암호화
+ *  - pull 은 push 순서대로 완료된 묶음을 하나씩 돌려줌
+ *  - 아직 pull 하지 않은 묶음의 입력+출력 바이트가 window 를 넘으면 push 가 0 을 반환
+ *    → 호출자가 pull 해서 결과를 넘겨야(예: DB INSERT) 다음 push 가능 = 메모리 상한
+ *******************************************************/
+namespace {
+
+struct StreamBatch {
+    int64_t firstRow;
+    int rowCount;
+    int64_t bytes;                       // window 계산용 (입력 + 출력)
+
+    std::vector<uint8_t> values;         // 입력 복사본 (암호화 후 지움)
+    std::vector<int64_t> offsets;        // 0 기준으로 옮긴 오프셋
+    std::unique_ptr<uint8_t[]> out;
+    int64_t outLen;
+    std::vector<int64_t> outOffsets;     // Base64 형식일 때만
+
+    bool done;
+    std::string error;
+
+    StreamBatch() : firstRow(0), rowCount(0), bytes(0), outLen(0), done(false) {}
+};
+
+} // namespace
+
+struct hcrypt_stream {
+    hcrypt_gcm_kdf* hc;
+    hcrypt_pool* pool;
+    int colCount;
+    CellFormat format;
+    hcrypt_nonce_mode nonceMode;
+    int64_t windowBytes;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<std::shared_ptr<StreamBatch>> pending;  // push 순서, 아직 pull 안 됨
+    std::shared_ptr<StreamBatch> current;              // 마지막으로 pull 한 묶음 (다음 pull 까지 유효)
+    int64_t inflightBytes;
+    int64_t nextRow;
+    int running;                                       // 풀에서 아직 실행 중인 묶음 수
+    bool failed;
+
+    hcrypt_stream()
+      : hc(nullptr), pool(nullptr), colCount(0), format(kCellFramed),
+        nonceMode(HCRYPT_NONCE_RANDOM), windowBytes(0),
+        inflightBytes(0), nextRow(0), running(0), failed(false) {}
+};
+
+namespace {
+
+// 묶음 하나 암호화 (풀 워커 또는 호출 스레드에서 실행)
+void runStreamBatch(hcrypt_stream* s, StreamBatch& batch) {
+    try {
+        int totalCells = batch.rowCount * s->colCount;
+        CellSource src = CellSource::fromValues(batch.values.data(), batch.offsets.data());
+        int64_t size = encryptedTableSize(src, totalCells, s->format);
+        batch.out.reset(new uint8_t[size > 0 ? size : 1]);
+        if (s->format == kCellBase64) {
+            batch.outOffsets.resize((size_t)totalCells + 1);
+        }
+        int participants = s->pool ? s->pool->size() + 1 : 1;
+        batch.outLen = encryptTableInto(s->hc, s->pool, src, totalCells, participants,
+                                        s->nonceMode, batch.out.get(), size, s->format,
+                                        batch.outOffsets.empty() ? nullptr : batch.outOffsets.data());
+    } catch (const std::exception& e) {
+        batch.error = e.what();
+    }
+
+    // 평문 복사본은 바로 지움
+    if (!batch.values.empty()) {
+        OPENSSL_cleanse(batch.values.data(), batch.values.size());
+    }
+    std::vector<uint8_t>().swap(batch.values);
+    std::vector<int64_t>().swap(batch.offsets);
+}
+
+// 묶음 메모리 해제 (window 에서 빠짐)
+void releaseStreamBatch(hcrypt_stream* s, std::shared_ptr<StreamBatch>& batch) {
+    if (!batch) return;
+    s->inflightBytes -= batch->bytes;
+    batch.reset();
+}
+
+} // namespace
+
+/*******************************************************
+ * 9-2) 행 오프셋 인덱스 컨테이너 (페이지 단위 복호화)
+ *  [본문    ] [4바이트 encSize][enc] × rowCount*colCount   (기존 테이블 형식 그대로)
+ *  [인덱스  ] int64 rowStart × (rowCount+1)               (본문 기준 행 시작 위치, 마지막 = 본문 길이)
+ *  [트레일러] 32바이트 "HCTROWX1" | int64 bodyLen | int32 rowCount | int32 colCount | int64 indexLen
+ *  - 트레일러가 맨 끝 고정 크기라서 임의 행 범위의 위치를 O(1)로 찾음
+ *  - 인덱스는 인증되지 않음: 잘못된 인덱스는 범위 검사/헤더 스캔/GCM 태그에서 걸러짐
+ *******************************************************/
+namespace {
+
+const char kIndexMagic[8] = { 'H', 'C', 'T', 'R', 'O', 'W', 'X', '1' };
+const int64_t kIndexTrailerSize = 32;
+
+// 예전 형식 blob 인덱스를 만들 때 스레드 하나가 맡는 최소 구간
+const int64_t kIndexSegmentBytes = 1 << 20;
+// 구간 시작점 추정: 이 범위 안에서 헤더가 연속 kIndexProbeCells 개 그럴듯한 첫 위치를 고름
+const int64_t kIndexProbeBytes = 64 * 1024;
+const int kIndexProbeCells = 8;
+
+inline int64_t containerIndexSize(int rowCount) {
+    return 8 * ((int64_t)rowCount + 1) + kIndexTrailerSize;
+}
+
+inline int64_t readI64(const uint8_t* p) {
+    int64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+inline int32_t readI32(const uint8_t* p) {
+    int32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+// rowStart(rowCount+1개) → out 에 인덱스 + 트레일러 기록
+void writeContainerIndex(const std::vector<int64_t>& rowStart, int64_t bodyLen,
+                         int rowCount, int colCount, uint8_t* out)
+{
+    int64_t indexLen = 8 * ((int64_t)rowCount + 1);
+    std::memcpy(out, rowStart.data(), (size_t)indexLen);
+    uint8_t* t = out + indexLen;
+    int32_t rows = rowCount, cols = colCount;
+    std::memcpy(t, kIndexMagic, 8);
+    std::memcpy(t + 8, &bodyLen, 8);
+    std::memcpy(t + 16, &rows, 4);
+    std::memcpy(t + 20, &cols, 4);
+    std::memcpy(t + 24, &indexLen, 8);
+}
+
+struct ContainerView {
+    const uint8_t* body;
+    int64_t bodyLen;
+    int rowCount;
+    int colCount;
+    const uint8_t* index;
+
+    int64_t rowStart(int r) const { return readI64(index + 8 * (int64_t)r); }
+};
+
+// 트레일러만 읽고 크기 검사 (O(1))
+ContainerView openContainer(const uint8_t* blob, int64_t blobLen) {
+    if (blobLen < kIndexTrailerSize) {
+        throw std::runtime_error("컨테이너가 너무 짧습니다.");
+    }
+    const uint8_t* t = blob + blobLen - kIndexTrailerSize;
+    if (std::memcmp(t, kIndexMagic, 8) != 0) {
+        throw std::runtime_error("행 인덱스가 없는 blob 입니다.");
+    }
+    ContainerView c;
+    c.body = blob;
+    c.bodyLen = readI64(t + 8);
+    c.rowCount = readI32(t + 16);
+    c.colCount = readI32(t + 20);
+    int64_t indexLen = readI64(t + 24);
+    checkedCellCount(c.rowCount, c.colCount);
+    if (c.bodyLen < 0 || indexLen != 8 * ((int64_t)c.rowCount + 1)
+        || c.bodyLen != blobLen - kIndexTrailerSize - indexLen) {
+        throw std::runtime_error("행 인덱스 트레일러가 잘못되었습니다.");
+    }
+    c.index = blob + c.bodyLen;
+    return c;
+}
+
+// [firstRow, firstRow+rowCount) 행만 훑어서 복호화 구간 분할
+//  - sub: 해당 행 범위의 본문 시작 위치
+ChunkPlan planRows(const ContainerView& c, int firstRow, int rowCount, int participants,
+                   const uint8_t** sub, const ColumnMask& mask = kAllColumns)
+{
+    if (firstRow < 0 || rowCount < 0 || (int64_t)firstRow + rowCount > c.rowCount) {
+        throw std::out_of_range("행 범위가 테이블을 벗어납니다.");
+    }
+    int64_t begin = c.rowStart(firstRow);
+    int64_t end = c.rowStart(firstRow + rowCount);
+    if (begin < 0 || begin > end || end > c.bodyLen) {
+        throw std::runtime_error("행 인덱스가 잘못되었습니다.");
+    }
+    int totalCells = checkedCellCount(rowCount, c.colCount);
+    ChunkPlan plan = planDecrypt(c.body + begin, end - begin, totalCells, participants, mask);
+    if (plan.inStart.back() != end - begin) {
+        throw std::runtime_error("행 인덱스와 본문이 맞지 않습니다.");
+    }
+    *sub = c.body + begin;
+    return plan;
+}
+
+// 헤더 하나 건너뛰기 (-1 = 범위 초과)
+inline int64_t skipCell(const uint8_t* body, int64_t len, int64_t off) {
+    if (off + 4 > len) return -1;
+    int32_t encSize = readI32(body + off);
+    if (encSize < 0 || off + 4 + encSize > len) return -1;
+    return off + 4 + encSize;
+}
+
+// 구간 시작점 후보: 이 위치부터 헤더가 kIndexProbeCells 개 연속으로 그럴듯한지
+//  - 이 라이브러리가 만드는 encSize 는 0 또는 28 이상
+bool plausibleCellChain(const uint8_t* body, int64_t len, int64_t off) {
+    for (int k = 0; k < kIndexProbeCells; k++) {
+        if (off == len) return true;
+        if (off + 4 > len) return false;
+        int32_t encSize = readI32(body + off);
+        if (encSize != 0 && (encSize < 12 + 16 || off + 4 + encSize > len)) return false;
+        off += 4 + encSize;
+    }
+    return true;
+}
+
+// 구간 하나의 헤더 체인
+struct IndexSegment {
+    int64_t begin, end;      // 담당 바이트 구간 [begin, end)
+    int64_t start;           // 체인 시작 (구간 안의 첫 셀 위치)
+    int64_t next;            // 체인이 구간을 벗어난 첫 셀 위치
+    int64_t cells;           // 구간 안에서 시작하는 셀 수
+    int64_t base;            // 첫 셀의 전체 셀 번호 (이어 붙인 뒤 채움)
+    bool ok;
+};
+
+// start 부터 헤더를 따라가며 seg.end 이상이 될 때까지 셀 수를 셈
+void chaseSegment(const uint8_t* body, int64_t len, IndexSegment& seg, int64_t start) {
+    seg.start = start;
+    seg.cells = 0;
+    seg.ok = true;
+    int64_t off = start;
+    while (off < seg.end && off < len) {
+        off = skipCell(body, len, off);
+        if (off < 0) {
+            seg.ok = false;
+            return;
+        }
+        seg.cells++;
+    }
+    seg.next = off;
+}
+
+// 예전 형식 본문([4바이트 encSize][enc] × 셀)에서 행 시작 위치를 병렬로 찾음
+//  1) 구간마다 시작점을 추정해서 체인을 따라가며 셀 수를 셈 (병렬, 추측)
+//  2) 앞 구간 체인이 끝난 위치 == 추정 시작점인지 차례로 확인 (직렬, 구간 수만큼)
+//     다르면 그 구간만 실제 위치에서 다시 따라감
+//  3) 구간별 첫 셀 번호가 정해졌으니 행 시작 위치를 병렬로 기록
+std::vector<int64_t> buildRowIndex(hcrypt_pool* pool, int participants,
+                                   const uint8_t* body, int64_t len,
+                                   int rowCount, int colCount)
+{
+    int totalCells = checkedCellCount(rowCount, colCount);
+    if (colCount <= 0 && rowCount > 0) {
+        throw std::invalid_argument("colCount는 1 이상이어야 합니다.");
+    }
+
+    int64_t segCount = std::max<int64_t>(1, std::min<int64_t>(
+        (int64_t)std::max(1, participants) * 2, len / kIndexSegmentBytes));
+    std::vector<IndexSegment> segs((size_t)segCount);
+    for (int64_t t = 0; t < segCount; t++) {
+        segs[t].begin = len * t / segCount;
+        segs[t].end = len * (t + 1) / segCount;
+        segs[t].base = 0;
+    }
+
+    // (1) 추측 체인
+    runStealing(pool, participants, (int)segCount, [&](int t) {
+        IndexSegment& seg = segs[t];
+        int64_t start = -1;
+        if (t == 0) {
+            start = 0;
+        } else {
+            int64_t limit = std::min(seg.end, seg.begin + kIndexProbeBytes);
+            for (int64_t o = seg.begin; o < limit; o++) {
+                if (plausibleCellChain(body, len, o)) {
+                    start = o;
+                    break;
+                }
+            }
+        }
+        if (start < 0) {
+            seg.ok = false;
+            seg.start = -1;
+            return;
+        }
+        chaseSegment(body, len, seg, start);
+    });
+
+    // (2) 이어 붙이기 + 검증
+    int64_t cur = 0, base = 0;
+    for (auto &seg : segs) {
+        if (cur >= seg.end) {
+            // 앞 셀이 이 구간을 통째로 덮음
+            seg.start = cur;
+            seg.cells = 0;
+            seg.next = cur;
+        } else if (!seg.ok || seg.start != cur) {
+            chaseSegment(body, len, seg, cur);
+            if (!seg.ok) {
+                throw std::runtime_error("인덱스 생성: enc_data 범위 초과");
+            }
+        }
+        seg.base = base;
+        base += seg.cells;
+        cur = seg.next;
+    }
+    if (base != totalCells || cur != len) {
+        throw std::runtime_error("인덱스 생성: 셀 개수/길이가 rowCount*colCount 와 맞지 않습니다.");
+    }
+
+    // (3) 행 시작 위치 기록 (행마다 정확히 한 구간이 씀)
+    std::vector<int64_t> rowStart((size_t)rowCount + 1);
+    rowStart[rowCount] = len;
+    runStealing(pool, participants, (int)segCount, [&](int t) {
+        const IndexSegment& seg = segs[t];
+        int64_t off = seg.start;
+        for (int64_t i = seg.base; i < seg.base + seg.cells; i++) {
+            if (i % colCount == 0) {
+                rowStart[i / colCount] = off;
+            }
+            off = skipCell(body, len, off);
+        }
+    });
+    return rowStart;
+}
+
+// 평문 셀 길이로 바로 계산한 행 시작 위치 (새로 암호화할 때)
+std::vector<int64_t> rowIndexFromSource(const CellSource& src, int rowCount, int colCount) {
+    std::vector<int64_t> rowStart((size_t)rowCount + 1);
+    int64_t off = 0;
+    for (int r = 0; r < rowCount; r++) {
+        rowStart[r] = off;
+        for (int c = 0; c < colCount; c++) {
+            off += encryptedCellSize(src.len(r * colCount + c));
+        }
+    }
+    rowStart[rowCount] = off;
+    return rowStart;
+}
+
+} // namespace
+
+/*******************************************************
+ * 9-3) 지연 복호화 테이블 핸들 (hcrypt_table)
+ *  - open: 셀 헤더만 훑어서 셀 위치 인덱스를 만듦 (복호화 없음, blob 은 복사하지 않음)
+ *  - get_cell: 처음 읽을 때 그 셀만 복호화해서 평문 LRU 에 보관
+ *  - LRU 는 평문 바이트 합계(cache_bytes) 기준, 밀려나는 평문은 지운 뒤 해제
+ *******************************************************/
+namespace {
+
+// 캐시 항목 하나의 고정 비용 (list/map 노드)
+const int64_t kLazyEntryOverhead = 64;
+
+struct LazyCell {
+    int cell;
+    std::vector<uint8_t> plain;
+
+    int64_t bytes() const { return (int64_t)plain.size() + kLazyEntryOverhead; }
+};
+
+inline void wipeLazyCell(LazyCell& e) {
+    if (!e.plain.empty()) {
+        OPENSSL_cleanse(e.plain.data(), e.plain.size());
+    }
+}
+
+} // namespace
+
+struct hcrypt_table {
+    const hcrypt_gcm_kdf* hc;
+    const uint8_t* body;
+    int rowCount;
+    int colCount;
+    std::vector<int64_t> cellStart;      // 셀 i 의 [4바이트 encSize] 위치
+
+    int64_t budget;
+    int64_t cachedBytes;
+    std::list<LazyCell> lru;             // 앞 = 최근에 읽은 셀
+    std::unordered_map<int, std::list<LazyCell>::iterator> lookup;
+
+    hcrypt_table()
+      : hc(nullptr), body(nullptr), rowCount(0), colCount(0),
+        budget(0), cachedBytes(0) {}
+
+    ~hcrypt_table() {
+        for (auto &e : lru) wipeLazyCell(e);
+    }
+
+    // 예산을 넘으면 오래된 셀부터 지움 (방금 넣은 맨 앞 셀은 남김)
+    void evict() {
+        while (cachedBytes > budget && lru.size() > 1) {
+            LazyCell& victim = lru.back();
+            cachedBytes -= victim.bytes();
+            wipeLazyCell(victim);
+            lookup.erase(victim.cell);
+            lru.pop_back();
+        }
+    }
+};
+
+extern "C" {
+
+hcrypt_table* hcrypt_table_open(
+    hcrypt_gcm_kdf* hc,
+    const uint8_t* blob,
+    int64_t blob_len,
+    int rowCount,
+    int colCount,
+    int64_t cache_bytes
+) {
+    if (!hc || (!blob && blob_len > 0) || blob_len < 0 || cache_bytes < 0) return nullptr;
+
+    try {
+        std::unique_ptr<hcrypt_table> t(new hcrypt_table());
+        t->hc = hc;
+        t->body = blob;
+        t->budget = cache_bytes;
+
+        // rowCount < 0 → 행 인덱스 컨테이너 트레일러에서 크기를 읽음
+        int64_t bodyLen = blob_len;
+        if (rowCount < 0) {
+            ContainerView c = openContainer(blob, blob_len);
+            bodyLen = c.bodyLen;
+            rowCount = c.rowCount;
+            colCount = c.colCount;
+        }
+        int totalCells = checkedCellCount(rowCount, colCount);
+        t->rowCount = rowCount;
+        t->colCount = colCount;
+
+        // 헤더만 훑어서 셀 위치 기록 (planDecrypt 와 같은 범위 검사)
+        t->cellStart.resize((size_t)totalCells);
+        int64_t offset = 0;
+        for (int i = 0; i < totalCells; i++) {
+            if (offset + 4 > bodyLen) {
+                throw std::runtime_error("enc_data 범위 초과(헤더4바이트)");
+            }
+            int encSize = readI32(blob + offset);
+            if (encSize < 0 || offset + 4 + encSize > bodyLen) {
+                throw std::runtime_error("enc_data 범위 초과(encSize)");
+            }
+            t->cellStart[i] = offset;
+            offset += 4 + encSize;
+        }
+        return t.release();
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_table_open] 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+int hcrypt_table_dims(const hcrypt_table* t, int* rowCount, int* colCount) {
+    if (!t || !rowCount || !colCount) return -1;
+    *rowCount = t->rowCount;
+    *colCount = t->colCount;
+    return 0;
+}
+
+int hcrypt_table_get_cell(
+    hcrypt_table* t,
+    int row,
+    int col,
+    const uint8_t** data,
+    int* len
+) {
+    if (!t || !data || !len) return -1;
+
+    try {
+        if (row < 0 || row >= t->rowCount || col < 0 || col >= t->colCount) {
+            throw std::out_of_range("셀 위치가 테이블을 벗어납니다.");
+        }
+        int cell = row * t->colCount + col;
+
+        // (1) 캐시에 있으면 맨 앞으로
+        auto it = t->lookup.find(cell);
+        if (it != t->lookup.end()) {
+            t->lru.splice(t->lru.begin(), t->lru, it->second);
+            *data = it->second->plain.data();
+            *len = (int)it->second->plain.size();
+            return 0;
+        }
+
+        // (2) 빈 셀(encSize 0)은 캐시하지 않음, IV + 태그보다 짧은 셀은 손상
+        const uint8_t* src = t->body + t->cellStart[cell];
+        int encSize = readI32(src);
+        if (encSize > 0 && encSize < 12 + 16) {
+            throw std::runtime_error("셀 암호문이 IV + 태그보다 짧음");
+        }
+        int plainLen = plainLenOf(encSize);
+        if (plainLen == 0) {
+            static const uint8_t kEmpty = 0;
+            *data = &kEmpty;
+            *len = 0;
+            return 0;
+        }
+
+        // (3) 그 셀만 복호화 (태그 검증 실패 시 예외 → 캐시에 남기지 않음)
+        LazyCell entry;
+        entry.cell = cell;
+        entry.plain.resize((size_t)plainLen);
+        try {
+            t->hc->decryptInto(src + 4, (size_t)plainLen + 12 + 16, entry.plain.data());
+        } catch (...) {
+            wipeLazyCell(entry);
+            throw;
+        }
+
+        t->lru.push_front(std::move(entry));
+        t->lookup[cell] = t->lru.begin();
+        t->cachedBytes += t->lru.front().bytes();
+        t->evict();
+
+        *data = t->lru.front().plain.data();
+        *len = plainLen;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_table_get_cell] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+void hcrypt_table_close(hcrypt_table* t) {
+    delete t;
+}
+
+} // extern "C"
+
+/*******************************************************
+ * 9-4) 다중 레인 PBKDF2-HMAC-SHA256 (hcrypt_derive_keys_batch)
+ *  - 배포 직후 캐시 워밍업처럼 서로 다른 (비밀번호, salt) 여러 개를 한꺼번에 파생할 때 사용
+ *  - key_len <= 32 이므로 블록 하나(T_1)만 계산
+ *  - 반복 한 번 = HMAC 한 번 = SHA-256 압축 2번 (ipad/opad 상태는 미리 계산)
+ *    메시지는 항상 [U(32바이트) + 패딩] 한 블록이라 뒤쪽 8워드는 상수
+ *  - 엔진: AVX-512 16레인 / AVX2 8레인 / SHA-NI 2레인 교차 / 스칼라 1레인
+ *    레인 엔진은 GCC 벡터 확장으로 한 번만 쓰고 target 함수 안에서 인라인해서 ISA 별로 생성
+ *  - 반복 횟수가 비슷한 작업끼리 묶고, 일찍 끝난 레인은 T 누적만 멈춤 (마스크)
+ *******************************************************/
+namespace {
+
+const uint32_t kSha256Init[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+alignas(16) const uint32_t kSha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// [U 8워드][0x80 패딩][0 ...][길이 = (64 + 32) * 8 비트]
+const uint32_t kKdfBlockTail[8] = { 0x80000000, 0, 0, 0, 0, 0, 0, 768 };
+
+// PBKDF2 한 건의 상태 (SHA-256 워드 = 빅엔디언 해석 값)
+struct KdfLane {
+    uint32_t inner[8];    // H 상태: 압축(IV, K ^ ipad)
+    uint32_t outer[8];    // H 상태: 압축(IV, K ^ opad)
+    uint32_t u[8];        // U_j
+    uint32_t t[8];        // U_1 ^ ... ^ U_j
+    uint32_t rounds;      // 남은 반복 (iteration - 1)
+};
+
+inline uint32_t loadBe32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+inline void storeBe32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+// ---- 레인 엔진 (스칼라 uint32_t 또는 GCC 벡터 타입 공용) ----
+// 벡터 타입을 값으로 반환하는 함수는 target 밖에서 ABI 경고가 나므로 매크로로
+#define HCRYPT_ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+// state 8워드 + 메시지 앞 8워드(뒤 8워드는 kKdfBlockTail) → out
+template <class V>
+inline __attribute__((always_inline))
+void kdfCompress(const V state[8], const V msg[8], V out[8]) {
+    V w[64];
+    for (int i = 0; i < 8; i++) w[i] = msg[i];
+    for (int i = 8; i < 16; i++) w[i] = (V){} + kKdfBlockTail[i - 8];
+    for (int i = 16; i < 64; i++) {
+        V s0 = HCRYPT_ROTR32(w[i - 15], 7) ^ HCRYPT_ROTR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        V s1 = HCRYPT_ROTR32(w[i - 2], 17) ^ HCRYPT_ROTR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    V a = state[0], b = state[1], c = state[2], d = state[3];
+    V e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        V S1 = HCRYPT_ROTR32(e, 6) ^ HCRYPT_ROTR32(e, 11) ^ HCRYPT_ROTR32(e, 25);
+        V ch = (e & f) ^ (~e & g);
+        V t1 = h + S1 + ch + kSha256K[i] + w[i];
+        V S0 = HCRYPT_ROTR32(a, 2) ^ HCRYPT_ROTR32(a, 13) ^ HCRYPT_ROTR32(a, 22);
+        V maj = (a & b) ^ (a & c) ^ (b & c);
+        V t2 = S0 + maj;
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    out[0] = state[0] + a; out[1] = state[1] + b; out[2] = state[2] + c; out[3] = state[3] + d;
+    out[4] = state[4] + e; out[5] = state[5] + f; out[6] = state[6] + g; out[7] = state[7] + h;
+}
+
+// 레인 W 개를 전치해서 벡터 워드로 돌림 (남는 레인은 rounds = 0 으로 채움)
+template <class V, int W>
+inline __attribute__((always_inline))
+void kdfIterateLanes(KdfLane* lanes, int count) {
+    V inner[8], outer[8], u[8], t[8], rem;
+    uint32_t maxRounds = 0;
+    for (int l = 0; l < W; l++) {
+        const KdfLane& src = lanes[l < count ? l : 0];
+        for (int i = 0; i < 8; i++) {
+            inner[i][l] = src.inner[i];
+            outer[i][l] = src.outer[i];
+            u[i][l] = src.u[i];
+            t[i][l] = src.t[i];
+        }
+        rem[l] = l < count ? src.rounds : 0;
+        maxRounds = std::max(maxRounds, (uint32_t)rem[l]);
+    }
+
+    V h[8];
+    for (uint32_t r = 0; r < maxRounds; r++) {
+        V active = (V)(rem > r);
+        kdfCompress(inner, u, h);
+        kdfCompress(outer, h, u);
+        for (int i = 0; i < 8; i++) t[i] ^= u[i] & active;
+    }
+
+    for (int l = 0; l < count; l++) {
+        for (int i = 0; i < 8; i++) lanes[l].t[i] = t[i][l];
+        lanes[l].rounds = 0;
+    }
+}
+
+void kdfIterateScalar(KdfLane* lanes, int count) {
+    for (int l = 0; l < count; l++) {
+        KdfLane& k = lanes[l];
+        uint32_t h[8];
+        for (uint32_t r = 0; r < k.rounds; r++) {
+            kdfCompress(k.inner, k.u, h);
+            kdfCompress(k.outer, h, k.u);
+            for (int i = 0; i < 8; i++) k.t[i] ^= k.u[i];
+        }
+        k.rounds = 0;
+    }
+}
+
+#ifdef HCRYPT_X86_SIMD
+typedef uint32_t KdfVec8 __attribute__((vector_size(32)));
+typedef uint32_t KdfVec16 __attribute__((vector_size(64)));
+
+__attribute__((target("avx2")))
+void kdfIterateAvx2(KdfLane* lanes, int count) {
+    kdfIterateLanes<KdfVec8, 8>(lanes, count);
+}
+
+__attribute__((target("avx512f")))
+void kdfIterateAvx512(KdfLane* lanes, int count) {
+    kdfIterateLanes<KdfVec16, 16>(lanes, count);
+}
+
+// ---- SHA-NI ----
+//  - 상태는 ABEF / CDGH 배치로 들고 다님
+//  - sha256rnds2 는 지연이 길어서 독립적인 두 레인을 번갈아 돌림
+struct ShaNiState {
+    __m128i abef;
+    __m128i cdgh;
+};
+
+__attribute__((target("sha,sse4.1")))
+inline ShaNiState shaNiPack(const uint32_t s[8]) {
+    __m128i dcba = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)s), 0xB1);         // CDAB
+    __m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)(s + 4)), 0x1B);   // EFGH
+    ShaNiState st;
+    st.abef = _mm_alignr_epi8(dcba, efgh, 8);
+    st.cdgh = _mm_blend_epi16(efgh, dcba, 0xF0);
+    return st;
+}
+
+// ABEF/CDGH → 워드 0..3, 4..7 (다음 블록의 메시지로 바로 씀)
+__attribute__((target("sha,sse4.1")))
+inline void shaNiUnpack(ShaNiState st, __m128i& lo, __m128i& hi) {
+    __m128i feba = _mm_shuffle_epi32(st.abef, 0x1B);
+    __m128i dchg = _mm_shuffle_epi32(st.cdgh, 0xB1);
+    lo = _mm_blend_epi16(feba, dchg, 0xF0);
+    hi = _mm_alignr_epi8(dchg, feba, 8);
+}
+
+// 두 레인의 압축 한 번 (메시지 앞 8워드 = m0/m1, 뒤는 상수)
+__attribute__((target("sha,sse4.1")))
+inline void shaNiCompress2(const ShaNiState& sa, const ShaNiState& sb,
+                           __m128i aLo, __m128i aHi, __m128i bLo, __m128i bHi,
+                           ShaNiState& oa, ShaNiState& ob)
+{
+    const __m128i tail0 = _mm_loadu_si128((const __m128i*)kKdfBlockTail);
+    const __m128i tail1 = _mm_loadu_si128((const __m128i*)(kKdfBlockTail + 4));
+    __m128i ma[4] = { aLo, aHi, tail0, tail1 };
+    __m128i mb[4] = { bLo, bHi, tail0, tail1 };
+    __m128i a0 = sa.abef, a1 = sa.cdgh, b0 = sb.abef, b1 = sb.cdgh;
+
+#pragma GCC unroll 16
+    for (int i = 0; i < 16; i++) {
+        __m128i k = _mm_load_si128((const __m128i*)(kSha256K + 4 * i));
+        __m128i xa = _mm_add_epi32(ma[i & 3], k);
+        __m128i xb = _mm_add_epi32(mb[i & 3], k);
+        a1 = _mm_sha256rnds2_epu32(a1, a0, xa);
+        b1 = _mm_sha256rnds2_epu32(b1, b0, xb);
+        xa = _mm_shuffle_epi32(xa, 0x0E);
+        xb = _mm_shuffle_epi32(xb, 0x0E);
+        a0 = _mm_sha256rnds2_epu32(a0, a1, xa);
+        b0 = _mm_sha256rnds2_epu32(b0, b1, xb);
+        if (i < 12) {
+            // W[4(i+4)..] = msg2(msg1(W[4i..], W[4i+4..]) + W[4i+9..], W[4i+12..])
+            __m128i ta = _mm_sha256msg1_epu32(ma[i & 3], ma[(i + 1) & 3]);
+            __m128i tb = _mm_sha256msg1_epu32(mb[i & 3], mb[(i + 1) & 3]);
+            ta = _mm_add_epi32(ta, _mm_alignr_epi8(ma[(i + 3) & 3], ma[(i + 2) & 3], 4));
+            tb = _mm_add_epi32(tb, _mm_alignr_epi8(mb[(i + 3) & 3], mb[(i + 2) & 3], 4));
+            ma[i & 3] = _mm_sha256msg2_epu32(ta, ma[(i + 3) & 3]);
+            mb[i & 3] = _mm_sha256msg2_epu32(tb, mb[(i + 3) & 3]);
+        }
+    }
+    oa.abef = _mm_add_epi32(a0, sa.abef);
+    oa.cdgh = _mm_add_epi32(a1, sa.cdgh);
+    ob.abef = _mm_add_epi32(b0, sb.abef);
+    ob.cdgh = _mm_add_epi32(b1, sb.cdgh);
+}
+
+// 레인 2개씩 (홀수면 마지막 레인을 자기 자신과 짝지어 rounds 만큼만 누적)
+__attribute__((target("sha,sse4.1")))
+void kdfIterateShaNi(KdfLane* lanes, int count) {
+    for (int l = 0; l < count; l += 2) {
+        KdfLane& A = lanes[l];
+        KdfLane& B = lanes[l + 1 < count ? l + 1 : l];
+        uint32_t ra = A.rounds, rb = (&B == &A) ? 0 : B.rounds;
+
+        ShaNiState ia = shaNiPack(A.inner), oa = shaNiPack(A.outer);
+        ShaNiState ib = shaNiPack(B.inner), ob = shaNiPack(B.outer);
+        __m128i uaLo = _mm_loadu_si128((const __m128i*)A.u);
+        __m128i uaHi = _mm_loadu_si128((const __m128i*)(A.u + 4));
+        __m128i ubLo = _mm_loadu_si128((const __m128i*)B.u);
+        __m128i ubHi = _mm_loadu_si128((const __m128i*)(B.u + 4));
+        __m128i taLo = _mm_loadu_si128((const __m128i*)A.t);
+        __m128i taHi = _mm_loadu_si128((const __m128i*)(A.t + 4));
+        __m128i tbLo = _mm_loadu_si128((const __m128i*)B.t);
+        __m128i tbHi = _mm_loadu_si128((const __m128i*)(B.t + 4));
+
+        uint32_t maxRounds = std::max(ra, rb);
+        for (uint32_t r = 0; r < maxRounds; r++) {
+            ShaNiState ha, hb;
+            __m128i haLo, haHi, hbLo, hbHi;
+            shaNiCompress2(ia, ib, uaLo, uaHi, ubLo, ubHi, ha, hb);
+            shaNiUnpack(ha, haLo, haHi);
+            shaNiUnpack(hb, hbLo, hbHi);
+            shaNiCompress2(oa, ob, haLo, haHi, hbLo, hbHi, ha, hb);
+            shaNiUnpack(ha, uaLo, uaHi);
+            shaNiUnpack(hb, ubLo, ubHi);
+            __m128i ma = _mm_set1_epi32(r < ra ? -1 : 0);
+            __m128i mb = _mm_set1_epi32(r < rb ? -1 : 0);
+            taLo = _mm_xor_si128(taLo, _mm_and_si128(uaLo, ma));
+            taHi = _mm_xor_si128(taHi, _mm_and_si128(uaHi, ma));
+            tbLo = _mm_xor_si128(tbLo, _mm_and_si128(ubLo, mb));
+            tbHi = _mm_xor_si128(tbHi, _mm_and_si128(ubHi, mb));
+        }
+        _mm_storeu_si128((__m128i*)A.t, taLo);
+        _mm_storeu_si128((__m128i*)(A.t + 4), taHi);
+        if (&B != &A) {
+            _mm_storeu_si128((__m128i*)B.t, tbLo);
+            _mm_storeu_si128((__m128i*)(B.t + 4), tbHi);
+        }
+        A.rounds = 0;
+        B.rounds = 0;
+    }
+}
+#endif
+
+struct KdfEngine {
+    const char* name;
+    int width;                                   // 한 번에 넘길 레인 수
+    void (*iterate)(KdfLane* lanes, int count);
+};
+
+KdfEngine selectKdfEngine() {
+    KdfEngine engine = { "scalar", 1, kdfIterateScalar };
+#ifdef HCRYPT_X86_SIMD
+    const CpuIsa& isa = cpuIsa();
+    if (isa.usable(HCRYPT_CPU_AVX512F)) {
+        engine = { "avx512", 16, kdfIterateAvx512 };
+    } else if (isa.usable(HCRYPT_CPU_SHA | HCRYPT_CPU_SSE41)) {
+        engine = { "sha-ni", 2, kdfIterateShaNi };
+    } else if (isa.usable(HCRYPT_CPU_AVX2)) {
+        engine = { "avx2", 8, kdfIterateAvx2 };
+    }
+#endif
+    return engine;
+}
+
+const KdfEngine& kdfEngine() {
+    static const KdfEngine engine = selectKdfEngine();
+    return engine;
+}
+
+// 블록 64바이트 → 압축 (키 패드 상태 계산용)
+void sha256Block(const uint32_t state[8], const uint8_t block[64], uint32_t out[8]) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) w[i] = loadBe32(block + 4 * i);
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = HCRYPT_ROTR32(w[i - 15], 7) ^ HCRYPT_ROTR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = HCRYPT_ROTR32(w[i - 2], 17) ^ HCRYPT_ROTR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (HCRYPT_ROTR32(e, 6) ^ HCRYPT_ROTR32(e, 11) ^ HCRYPT_ROTR32(e, 25))
+                    + ((e & f) ^ (~e & g)) + kSha256K[i] + w[i];
+        uint32_t t2 = (HCRYPT_ROTR32(a, 2) ^ HCRYPT_ROTR32(a, 13) ^ HCRYPT_ROTR32(a, 22))
+                    + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    out[0] = state[0] + a; out[1] = state[1] + b; out[2] = state[2] + c; out[3] = state[3] + d;
+    out[4] = state[4] + e; out[5] = state[5] + f; out[6] = state[6] + g; out[7] = state[7] + h;
+    OPENSSL_cleanse(w, sizeof(w));
+}
+
+// ipad/opad 상태와 U_1 = HMAC(P, salt || INT(1)) 준비
+void kdfLaneSetup(KdfLane& lane, const char* password, const uint8_t* salt, int saltLen,
+                  int iteration)
+{
+    size_t pwLen = std::strlen(password);
+    uint8_t key[64] = {0};
+    if (pwLen > 64) {
+        SHA256(reinterpret_cast<const uint8_t*>(password), pwLen, key);
+    } else {
+        std::memcpy(key, password, pwLen);
+    }
+
+    uint8_t pad[64];
+    for (int i = 0; i < 64; i++) pad[i] = key[i] ^ 0x36;
+    sha256Block(kSha256Init, pad, lane.inner);
+    for (int i = 0; i < 64; i++) pad[i] = key[i] ^ 0x5c;
+    sha256Block(kSha256Init, pad, lane.outer);
+
+    std::vector<uint8_t> msg(salt, salt + saltLen);
+    const uint8_t blockIndex[4] = { 0, 0, 0, 1 };
+    msg.insert(msg.end(), blockIndex, blockIndex + 4);
+    uint8_t u1[32];
+    unsigned int macLen = 0;
+    if (!HMAC(sha256Md(), password, (int)pwLen, msg.data(), msg.size(), u1, &macLen)) {
+        OPENSSL_cleanse(key, sizeof(key));
+        OPENSSL_cleanse(pad, sizeof(pad));
+        throw std::runtime_error("HMAC 실패");
+    }
+    for (int i = 0; i < 8; i++) {
+        lane.u[i] = loadBe32(u1 + 4 * i);
+        lane.t[i] = lane.u[i];
+    }
+    lane.rounds = (uint32_t)(iteration - 1);
+
+    OPENSSL_cleanse(key, sizeof(key));
+    OPENSSL_cleanse(pad, sizeof(pad));
+    OPENSSL_cleanse(u1, sizeof(u1));
+}
+
+inline void wipeKdfLanes(std::vector<KdfLane>& lanes) {
+    if (!lanes.empty()) OPENSSL_cleanse(lanes.data(), lanes.size() * sizeof(KdfLane));
+}
+
+// 레인 묶음 하나 = 엔진 폭만큼의 작업 (반복 횟수 순으로 정렬된 순서)
+void deriveKeysBatch(hcrypt_pool* pool, int count, const char* const* passwords,
+                     const uint8_t* const* salts, const int* saltLens, const int* iterations,
+                     int keyLen, uint8_t* outKeys)
+{
+    const KdfEngine& engine = kdfEngine();
+
+    std::vector<int> order(count);
+    for (int i = 0; i < count; i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return iterations[a] < iterations[b];
+    });
+
+    std::vector<KdfLane> lanes(count);
+    int groups = (count + engine.width - 1) / engine.width;
+    int participants = pool ? pool->size() + 1 : 1;
+
+    try {
+        runStealing(pool, participants, groups, [&](int g) {
+            int first = g * engine.width;
+            int n = std::min(engine.width, count - first);
+            for (int l = 0; l < n; l++) {
+                int job = order[first + l];
+                kdfLaneSetup(lanes[first + l], passwords[job], salts[job], saltLens[job],
+                             iterations[job]);
+            }
+            engine.iterate(&lanes[first], n);
+            for (int l = 0; l < n; l++) {
+                uint8_t block[32];
+                for (int i = 0; i < 8; i++) storeBe32(block + 4 * i, lanes[first + l].t[i]);
+                std::memcpy(outKeys + (size_t)order[first + l] * keyLen, block, (size_t)keyLen);
+                OPENSSL_cleanse(block, sizeof(block));
+            }
+        });
+    } catch (...) {
+        wipeKdfLanes(lanes);
+        throw;
+    }
+    wipeKdfLanes(lanes);
+}
+
+#undef HCRYPT_ROTR32
+
+} // namespace
+
+/*******************************************************
+ * 9-5) 비동기 테이블 작업 (hcrypt_submit_* / hcrypt_job_*)
+ *  - submit 이 입력을 복사해 작업을 만들고 풀 워커에 넘김 → 호출자는 DB 대기 등과 겹쳐서 진행
+ *  - 작업은 번호로 찾음 (전역 표 하나 + condition_variable 하나)
+ *  - 워커에서 도는 테이블 커널은 같은 풀로 다시 나눠 실행 (parallelFor 중첩 가능)
+ *  - 결과는 작업이 소유, release 할 때 해제 (실행 중에 release 하면 끝난 뒤 해제)
+ *******************************************************/
+namespace {
+
+struct TableJob {
+    // 입력 복사본 (실행이 끝나면 지움)
+    std::vector<uint8_t> input;
+    std::vector<int64_t> inOffsets;      // 0 기준으로 옮긴 오프셋 (values/Base64 입력만)
+    std::vector<uint8_t> colMask;
+    int rowCount;
+    int colCount;
+    hcrypt_nonce_mode nonceMode;
+    bool perCell;
+    bool plainInput;                     // 입력이 평문이면 실행 뒤 지움
+
+    // 결과
+    std::unique_ptr<uint8_t[]> out;
+    int64_t outLen;
+    std::vector<int64_t> offsets;
+    std::vector<uint8_t> validity;
+    std::vector<uint8_t> status;
+    int64_t failed;
+
+    bool done;
+    std::string error;
+
+    TableJob()
+      : rowCount(0), colCount(0), nonceMode(HCRYPT_NONCE_RANDOM), perCell(false),
+        plainInput(false), outLen(0), failed(0), done(false) {}
+
+    int totalCells() const { return rowCount * colCount; }
+
+    // 복사해 둔 옵션 → 커널용 opts (status/failed 는 작업 소유 버퍼)
+    hcrypt_table_opts opts() {
+        hcrypt_table_opts o;
+        o.nonce_mode = (int)nonceMode;
+        o.col_mask = colMask.empty() ? nullptr : colMask.data();
+        o.cell_status = perCell ? status.data() : nullptr;
+        o.failed_cells = perCell ? &failed : nullptr;
+        return o;
+    }
+};
+
+std::mutex g_jobs_mutex;
+std::condition_variable g_jobs_cv;
+std::unordered_map<int64_t, std::shared_ptr<TableJob>> g_jobs;
+int64_t g_next_job_id = 1;
+
+// 표 모양 + 옵션 복사
+std::shared_ptr<TableJob> newTableJob(int rowCount, int colCount, const hcrypt_table_opts* opts) {
+    int totalCells = checkedCellCount(rowCount, colCount);
+    std::shared_ptr<TableJob> job = std::make_shared<TableJob>();
+    job->rowCount = rowCount;
+    job->colCount = colCount;
+    job->nonceMode = nonceModeOf(opts);
+    if (opts && opts->col_mask) {
+        job->colMask.assign(opts->col_mask, opts->col_mask + (colCount + 7) / 8);
+    }
+    if (opts && opts->cell_status) {
+        job->perCell = true;
+        job->status.resize((size_t)totalCells);
+    }
+    return job;
+}
+
+// values + offsets 입력을 0 기준으로 옮겨서 복사
+void copyValuesInput(TableJob& job, const uint8_t* values, const int64_t* offsets) {
+    int totalCells = job.totalCells();
+    job.input.assign(values + offsets[0], values + offsets[totalCells]);
+    job.inOffsets.resize((size_t)totalCells + 1);
+    for (int i = 0; i <= totalCells; i++) {
+        job.inOffsets[i] = offsets[i] - offsets[0];
+    }
+}
+
+// 작업 등록 + 풀에 넘김 (워커가 없는 풀이면 호출 스레드에서 바로 실행)
+int64_t startTableJob(hcrypt_pool* pool, const std::shared_ptr<TableJob>& job,
+                      std::function<void(TableJob&)> body, const char* name) {
+    int64_t id;
+    {
+        std::lock_guard<std::mutex> lock(g_jobs_mutex);
+        id = g_next_job_id++;
+        g_jobs[id] = job;
+    }
+
+    auto task = [job, body, name] {
+        try {
+            TraceCall trace(name);
+            body(*job);
+        } catch (const std::exception& e) {
+            job->error = e.what();
+        }
+        if (job->plainInput && !job->input.empty()) {
+            OPENSSL_cleanse(job->input.data(), job->input.size());
+        }
+        std::vector<uint8_t>().swap(job->input);
+        std::vector<int64_t>().swap(job->inOffsets);
+
+        std::lock_guard<std::mutex> lock(g_jobs_mutex);
+        job->done = true;
+        g_jobs_cv.notify_all();
+    };
+    if (pool->size() > 0) {
+        pool->submit(task);
+    } else {
+        task();
+    }
+    return id;
+}
+
+// 암호화 작업 본문 (input = 평문 values + inOffsets)
+void runEncryptJob(const hcrypt_gcm_kdf* hc, hcrypt_pool* pool, TableJob& job, CellFormat format) {
+    int totalCells = job.totalCells();
+    CellSource src = CellSource::fromValues(job.input.data(), job.inOffsets.data());
+    int64_t size = encryptedTableSize(src, totalCells, format);
+    job.out.reset(new uint8_t[size > 0 ? size : 1]);
+    if (format == kCellBase64) {
+        job.offsets.resize((size_t)totalCells + 1);
+    }
+    job.outLen = encryptTableInto(hc, pool, src, totalCells, pool->size() + 1, job.nonceMode,
+                                  job.out.get(), size, format,
+                                  job.offsets.empty() ? nullptr : job.offsets.data());
+}
+
+// 복호화 작업 본문
+//  - kJobFramed : [4바이트 plainLen][plain] × 셀 (hcrypt_decrypt_table_mt_alloc 과 같음)
+//  - kJobValues : 평문 values + offsets + validity
+//  - kJobBase64 : Base64 입력 → 평문 values + offsets + validity
+enum DecryptJobKind { kJobFramed, kJobValues, kJobBase64 };
+
+void runDecryptJob(const hcrypt_gcm_kdf* hc, hcrypt_pool* pool, TableJob& job, DecryptJobKind kind) {
+    int totalCells = job.totalCells();
+    int participants = pool->size() + 1;
+    hcrypt_table_opts opts = job.opts();
+    ColumnMask mask = columnMaskOf(&opts, job.colCount);
+    CellStatus status(&opts);
+
+    if (kind == kJobBase64) {
+        CellSource src = CellSource::fromValues(job.input.data(), job.inOffsets.data());
+        ChunkPlan plan = planDecryptB64(src, totalCells, participants, mask, status.on());
+        int64_t size = plan.outputSize();
+        job.out.reset(new uint8_t[size > 0 ? size : 1]);
+        job.offsets.resize((size_t)totalCells + 1);
+        job.validity.resize(((size_t)totalCells + 7) / 8);
+        job.outLen = decryptTableB64Into(hc, pool, participants, src, plan, totalCells,
+                                         job.out.get(), size, job.offsets.data(),
+                                         job.validity.data(), mask, &status);
+        return;
+    }
+
+    ChunkPlan plan = planDecrypt(job.input.data(), (int64_t)job.input.size(), totalCells,
+                                 participants, mask);
+    if (kind == kJobFramed) {
+        int64_t size = plan.outputSize();
+        job.out.reset(new uint8_t[size > 0 ? size : 1]);
+        job.outLen = decryptTableInto(hc, pool, participants, job.input.data(), plan,
+                                      job.out.get(), size, mask, &status);
+    } else {
+        int64_t size = valuesSizeOf(plan, totalCells);
+        job.out.reset(new uint8_t[size > 0 ? size : 1]);
+        job.offsets.resize((size_t)totalCells + 1);
+        job.validity.resize(((size_t)totalCells + 7) / 8);
+        job.outLen = decryptTableValuesInto(hc, pool, participants, job.input.data(), plan,
+                                            totalCells, job.out.get(), size, job.offsets.data(),
+                                            job.validity.data(), mask, &status);
+    }
+}
+
+// pool 이 NULL 이면 라이브러리 공용 풀
+hcrypt_pool* jobPool(hcrypt_pool* pool) {
+    return pool ? pool : sharedPool();
+}
+
+std::shared_ptr<TableJob> findJob(int64_t id) {
+    auto it = g_jobs.find(id);
+    return it == g_jobs.end() ? nullptr : it->second;
+}
+
+// g_jobs_mutex 를 잡은 상태에서: 1 = 성공, 0 = 실행 중, -1 = 실패
+int jobState(const TableJob& job) {
+    if (!job.done) return 0;
+    return job.error.empty() ? 1 : -1;
+}
+
+} // namespace
+
+/*******************************************************
+ * 10) extern "C" (C 인터페이스)
+ *******************************************************/
+extern "C" {
+
+// ------------ 라이브러리 초기화 ------------
+int hcrypt_library_init(void) {
+    return library().ok ? 0 : -1;
+}
+
+// ------------ 객체 생성/소멸 ------------
+hcrypt_gcm_kdf* hcrypt_new() {
+    try {
+        return new hcrypt_gcm_kdf();
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_new] 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+void hcrypt_delete(hcrypt_gcm_kdf* hc) {
+    delete hc;
+}
+
+// ------------ KDF (PBKDF2) ------------
+void hcrypt_deriveKeyFromPassword(hcrypt_gcm_kdf* hc,
+                                  const char* password,
+                                  const uint8_t* salt,
+                                  int salt_len,
+                                  int key_len,
+                                  int iteration)
+{
+    if (!hc || !password || !salt) return;
+    // 파생 키 캐시를 거침 (같은 입력이면 PBKDF2 를 다시 돌리지 않음)
+    hcrypt_derive_key_cached(hc, password, salt, salt_len, key_len, iteration);
+}
+
+// ------------ 키 직접 설정 ------------
+void hcrypt_setKey(hcrypt_gcm_kdf* hc, const uint8_t* keydata, int key_len) {
+    if (!hc || !keydata) return;
+    try {
+        std::vector<uint8_t> keyVec(keydata, keydata + key_len);
+        hc->setKey(keyVec);
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_setKey] 예외: " << e.what() << std::endl;
+    }
+}
+
+// ------------ 단일 청크 암/복호화 ------------
+uint8_t* hcrypt_encrypt_alloc(hcrypt_gcm_kdf* hc,
+                              const uint8_t* plain, int plain_len,
+                              int* out_len)
+{
+    if (!hc || !plain || !out_len) return nullptr;
+
+    // --- [빈 문자열 예외처리] ---
+    if (plain_len <= 0) {
+        *out_len = 0;
+        // 필요하다면, 빈 new[] 할당 또는 nullptr 반환
+        return nullptr;
+    }
+    // ---------------------------
+
+    try {
+        statAdd(kStatCalls, 1);
+        std::vector<uint8_t> input(plain, plain + plain_len);
+        std::vector<uint8_t> enc = hc->encrypt(input);
+
+        *out_len = (int)enc.size();
+        if (*out_len == 0) {
+            // 암호화 결과가 빈 벡터 → 빈 new[] 할당
+            uint8_t* result = new uint8_t[0]; // 실제 0바이트
+            return result;
+        }
+
+        uint8_t* result;
+        {
+            StatTimer timer(kStatNsAlloc);
+            result = new uint8_t[*out_len];
+        }
+        StatTimer timer(kStatNsOutput);
+        std::memcpy(result, enc.data(), enc.size());
+        return result;
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_encrypt_alloc] 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+uint8_t* hcrypt_decrypt_alloc(hcrypt_gcm_kdf* hc,
+                              const uint8_t* cipher, int cipher_len,
+                              int* out_len)
+{
+    if (!hc || !cipher || !out_len) return nullptr;
+
+    // --- [빈 문자열 예외처리] ---
+    if (cipher_len <= 0) {
+        *out_len = 0;
+        return nullptr;
+    }
+    // ---------------------------
+
+    try {
+        statAdd(kStatCalls, 1);
+        std::vector<uint8_t> input(cipher, cipher + cipher_len);
+        std::vector<uint8_t> dec = hc->decrypt(input);
+
+        *out_len = (int)dec.size();
+        if (*out_len == 0) {
+            uint8_t* result = new uint8_t[0];
+            return result;
+        }
+
+        uint8_t* result;
+        {
+            StatTimer timer(kStatNsAlloc);
+            result = new uint8_t[*out_len];
+        }
+        StatTimer timer(kStatNsOutput);
+        std::memcpy(result, dec.data(), dec.size());
+        return result;
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_decrypt_alloc] 예외: " << e.what() << std::endl;
+        return nullptr;
     }
 }
 
@@ -405,332 +4488,1663 @@ void hcrypt_free(uint8_t* data) {
     delete[] data;
 }
 
-// ------------ IV(Nonce) 생성 ------------
-uint8_t* hcrypt_generate_iv(int* out_len) {
-    if (!out_len) return nullptr;
+// ------------ IV(Nonce) 생성 ------------
+uint8_t* hcrypt_generate_iv(int* out_len) {
+    if (!out_len) return nullptr;
+    try {
+        auto iv = hcrypt_gcm_kdf::generateRandomIV();
+        *out_len = (int)iv.size();
+        uint8_t* result = new uint8_t[iv.size()];
+        std::memcpy(result, iv.data(), iv.size());
+        return result;
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_generate_iv] 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+// ------------ (단일 스레드) N×M 테이블 일괄 암/복호화 ------------
+uint8_t* hcrypt_encrypt_table_alloc(
+    hcrypt_gcm_kdf* hc,
+    const uint8_t** table,
+    const int* cell_sizes,
+    int rowCount,
+    int colCount,
+    int* out_len
+) {
+    if (!hc || !table || !cell_sizes || !out_len) return nullptr;
+
+    try {
+        TraceCall trace("hcrypt_encrypt_table_alloc");
+        int totalCells = checkedCellCount(rowCount, colCount);
+        CellSource src = CellSource::fromTable(table, cell_sizes);
+        src.validate(totalCells, 0);
+        return encryptTableAlloc(hc, nullptr, src, totalCells, 1,
+                                 nullptr, out_len, "[hcrypt_encrypt_table_alloc]");
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_encrypt_table_alloc] 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+uint8_t* hcrypt_decrypt_table_alloc(
+    hcrypt_gcm_kdf* hc,
+    const uint8_t* enc_data,
+    int enc_data_len,
+    int rowCount,
+    int colCount,
+    int* out_len
+) {
+    if (!hc || !enc_data || !out_len) return nullptr;
+
+    try {
+        statAdd(kStatCalls, 1);
+        std::vector<uint8_t> allDecrypted;
+        allDecrypted.reserve(enc_data_len);
+
+        int offset = 0;
+        int totalCells = rowCount * colCount;
+
+        for (int i = 0; i < totalCells; i++) {
+            if (offset + 4 > enc_data_len) {
+                throw std::runtime_error("[hcrypt_decrypt_table_alloc] 범위 초과(헤더4바이트)");
+            }
+            int encSize = 0;
+            std::memcpy(&encSize, enc_data + offset, 4);
+            offset += 4;
+
+            // --- [빈 문자열 예외처리] ---
+            if (encSize == 0) {
+                // 빈 셀 → 그냥 넘어가되, 여기서는 복원할 때
+                // "빈 문자열" 처리를 할 수 있도록 로직 설계
+                continue;
+            }
+            // ---------------------------
+
+            if (offset + encSize > enc_data_len) {
+                throw std::runtime_error("[hcrypt_decrypt_table_alloc] 범위 초과(encSize)");
+            }
+            std::vector<uint8_t> encCell(enc_data + offset, enc_data + offset + encSize);
+            offset += encSize;
+
+            std::vector<uint8_t> decCell = hc->decrypt(encCell);
+            StatTimer timer(kStatNsOutput);
+            allDecrypted.insert(allDecrypted.end(), decCell.begin(), decCell.end());
+        }
+
+        *out_len = (int)allDecrypted.size();
+        uint8_t* result;
+        {
+            StatTimer timer(kStatNsAlloc);
+            result = new uint8_t[*out_len];
+        }
+        StatTimer timer(kStatNsOutput);
+        std::memcpy(result, allDecrypted.data(), *out_len);
+        return result;
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_decrypt_table_alloc] 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+// ============ (멀티 스레드) N×M 테이블 암호화 ============
+//  - threadCount 는 동시에 일할 스레드 수, 실제 실행은 라이브러리 공용 풀에서
+uint8_t* hcrypt_encrypt_table_mt_alloc(
+    hcrypt_gcm_kdf* hc,
+    const uint8_t** table,
+    const int* cell_sizes,
+    int rowCount,
+    int colCount,
+    int threadCount,
+    int* out_len
+) {
+    if (!hc || !table || !cell_sizes || !out_len || threadCount <= 0) {
+        return nullptr;
+    }
+
+    try {
+        TraceCall trace("hcrypt_encrypt_table_mt_alloc");
+        int totalCells = checkedCellCount(rowCount, colCount);
+        CellSource src = CellSource::fromTable(table, cell_sizes);
+        src.validate(totalCells, 0);
+        hcrypt_pool* pool = sharedPool();
+        return encryptTableAlloc(hc, pool, src, totalCells, sharedParticipants(pool, threadCount),
+                                 nullptr, out_len, "[hcrypt_encrypt_table_mt_alloc]");
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_encrypt_table_mt_alloc] 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+// ============ (멀티 스레드) N×M 테이블 복호화 ============
+uint8_t* hcrypt_decrypt_table_mt_alloc(
+    hcrypt_gcm_kdf* hc,
+    const uint8_t* enc_data,
+    int enc_data_len,
+    int rowCount,
+    int colCount,
+    int threadCount,
+    int* out_len
+) {
+    if (!hc || !enc_data || !out_len || threadCount <= 0) {
+        return nullptr;
+    }
+
+    try {
+        TraceCall trace("hcrypt_decrypt_table_mt_alloc");
+        hcrypt_pool* pool = sharedPool();
+        return decryptTableAlloc(hc, pool, enc_data, enc_data_len, rowCount, colCount,
+                                 sharedParticipants(pool, threadCount), nullptr,
+                                 out_len, "[hcrypt_decrypt_table_mt_alloc]");
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_decrypt_table_mt_alloc] 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+uint8_t* hcrypt_decrypt_table_mt_alloc_opts(
+    hcrypt_gcm_kdf* hc,
+    const uint8_t* enc_data,
+    int enc_data_len,
+    int rowCount,
+    int colCount,
+    int threadCount,
+    const hcrypt_table_opts* opts,
+    int* out_len
+) {
+    if (!hc || !enc_data || !out_len || threadCount <= 0) {
+        return nullptr;
+    }
+
+    try {
+        TraceCall trace("hcrypt_decrypt_table_mt_alloc_opts");
+        hcrypt_pool* pool = sharedPool();
+        return decryptTableAlloc(hc, pool, enc_data, enc_data_len, rowCount, colCount,
+                                 sharedParticipants(pool, threadCount), opts,
+                                 out_len, "[hcrypt_decrypt_table_mt_alloc_opts]");
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_decrypt_table_mt_alloc_opts] 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+// ------------ 워커 스레드 풀 ------------
+hcrypt_pool* hcrypt_pool_create(int threadCount) {
+    try {
+        return new hcrypt_pool(threadCount);
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_pool_create] 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+void hcrypt_pool_destroy(hcrypt_pool* pool) {
+    delete pool;
+}
+
+int hcrypt_pool_size(hcrypt_pool* pool) {
+    if (!pool) return 0;
+    return pool->size();
+}
+
+// ============ (스레드 풀) N×M 테이블 암호화 ============
+uint8_t* hcrypt_encrypt_table_pool_alloc(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t** table,
+    const int* cell_sizes,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    int* out_len
+) {
+    if (!hc || !pool || !table || !cell_sizes || !out_len) return nullptr;
+
+    try {
+        TraceCall trace("hcrypt_encrypt_table_pool_alloc");
+        int totalCells = checkedCellCount(rowCount, colCount);
+        CellSource src = CellSource::fromTable(table, cell_sizes);
+        src.validate(totalCells, 0);
+        return encryptTableAlloc(hc, pool, src, totalCells, pool->size() + 1,
+                                 opts, out_len, "[hcrypt_encrypt_table_pool_alloc]");
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_encrypt_table_pool_alloc] 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+// ============ (스레드 풀) N×M 테이블 복호화 ============
+uint8_t* hcrypt_decrypt_table_pool_alloc(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* enc_data,
+    int enc_data_len,
+    int rowCount,
+    int colCount,
+    int* out_len
+) {
+    if (!hc || !pool || !enc_data || !out_len) return nullptr;
+
+    try {
+        TraceCall trace("hcrypt_decrypt_table_pool_alloc");
+        return decryptTableAlloc(hc, pool, enc_data, enc_data_len, rowCount, colCount,
+                                 pool->size() + 1, nullptr,
+                                 out_len, "[hcrypt_decrypt_table_pool_alloc]");
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_decrypt_table_pool_alloc] 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+uint8_t* hcrypt_decrypt_table_pool_alloc_opts(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* enc_data,
+    int enc_data_len,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    int* out_len
+) {
+    if (!hc || !pool || !enc_data || !out_len) return nullptr;
+
     try {
-        auto iv = hcrypt_gcm_kdf::generateRandomIV();
-        *out_len = (int)iv.size();
-        uint8_t* result = new uint8_t[iv.size()];
-        std::memcpy(result, iv.data(), iv.size());
+        TraceCall trace("hcrypt_decrypt_table_pool_alloc_opts");
+        return decryptTableAlloc(hc, pool, enc_data, enc_data_len, rowCount, colCount,
+                                 pool->size() + 1, opts,
+                                 out_len, "[hcrypt_decrypt_table_pool_alloc_opts]");
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_decrypt_table_pool_alloc_opts] 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+// ============ 호출자 버퍼로 N×M 테이블 암호화 ============
+int64_t hcrypt_table_encrypted_size(
+    const int* cell_sizes,
+    int rowCount,
+    int colCount
+) {
+    if (!cell_sizes) return -1;
+    try {
+        int totalCells = checkedCellCount(rowCount, colCount);
+        return encryptedTableSize(CellSource::fromTable(nullptr, cell_sizes), totalCells);
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_table_encrypted_size] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+int64_t hcrypt_encrypt_table_into(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t** table,
+    const int* cell_sizes,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    uint8_t* out,
+    int64_t capacity
+) {
+    if (!hc || !table || !cell_sizes || !out) return -1;
+
+    try {
+        TraceCall trace("hcrypt_encrypt_table_into");
+        int totalCells = checkedCellCount(rowCount, colCount);
+        CellSource src = CellSource::fromTable(table, cell_sizes);
+        src.validate(totalCells, 0);
+        int participants = pool ? pool->size() + 1 : 1;
+        return encryptTableInto(hc, pool, src, totalCells, participants,
+                                nonceModeOf(opts), out, capacity);
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_encrypt_table_into] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+// ============ 호출자 버퍼로 N×M 테이블 복호화 ============
+int64_t hcrypt_table_decrypted_size(
+    const uint8_t* enc_data,
+    int64_t enc_data_len,
+    int rowCount,
+    int colCount
+) {
+    if (!enc_data) return -1;
+    try {
+        int totalCells = checkedCellCount(rowCount, colCount);
+        return planDecrypt(enc_data, enc_data_len, totalCells, 1).outputSize();
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_table_decrypted_size] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+int64_t hcrypt_decrypt_table_into(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* enc_data,
+    int64_t enc_data_len,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    uint8_t* out,
+    int64_t capacity
+) {
+    if (!hc || !enc_data || !out) return -1;
+
+    try {
+        TraceCall trace("hcrypt_decrypt_table_into");
+        int totalCells = checkedCellCount(rowCount, colCount);
+        int participants = pool ? pool->size() + 1 : 1;
+        ColumnMask mask = columnMaskOf(opts, colCount);
+        ChunkPlan plan = planDecrypt(enc_data, enc_data_len, totalCells, participants, mask);
+        CellStatus status(opts);
+        return decryptTableInto(hc, pool, participants, enc_data, plan, out, capacity, mask, &status);
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_decrypt_table_into] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+// ============ Arrow 레이아웃 입력 N×M 테이블 암호화 ============
+int64_t hcrypt_table_encrypted_size_values(
+    const int64_t* offsets,
+    int rowCount,
+    int colCount
+) {
+    if (!offsets) return -1;
+    try {
+        int totalCells = checkedCellCount(rowCount, colCount);
+        CellSource src = CellSource::fromValues(nullptr, offsets);
+        src.validate(totalCells, INT64_MAX);
+        return encryptedTableSize(src, totalCells);
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_table_encrypted_size_values] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+int64_t hcrypt_encrypt_table_values_into(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* values,
+    int64_t values_len,
+    const int64_t* offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    uint8_t* out,
+    int64_t capacity
+) {
+    if (!hc || !offsets || !out || (!values && values_len > 0)) return -1;
+
+    try {
+        TraceCall trace("hcrypt_encrypt_table_values_into");
+        int totalCells = checkedCellCount(rowCount, colCount);
+        CellSource src = CellSource::fromValues(values, offsets);
+        src.validate(totalCells, values_len);
+        int participants = pool ? pool->size() + 1 : 1;
+        return encryptTableInto(hc, pool, src, totalCells, participants,
+                                nonceModeOf(opts), out, capacity);
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_encrypt_table_values_into] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+uint8_t* hcrypt_encrypt_table_values_alloc(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* values,
+    int64_t values_len,
+    const int64_t* offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    int* out_len
+) {
+    if (!hc || !offsets || !out_len || (!values && values_len > 0)) return nullptr;
+
+    try {
+        TraceCall trace("hcrypt_encrypt_table_values_alloc");
+        int totalCells = checkedCellCount(rowCount, colCount);
+        CellSource src = CellSource::fromValues(values, offsets);
+        src.validate(totalCells, values_len);
+        int participants = pool ? pool->size() + 1 : 1;
+        return encryptTableAlloc(hc, pool, src, totalCells, participants,
+                                 opts, out_len, "[hcrypt_encrypt_table_values_alloc]");
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_encrypt_table_values_alloc] 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+// ============ values + offsets 형식 N×M 테이블 복호화 ============
+int64_t hcrypt_table_decrypted_values_size(
+    const uint8_t* enc_data,
+    int64_t enc_data_len,
+    int rowCount,
+    int colCount
+) {
+    if (!enc_data) return -1;
+    try {
+        int totalCells = checkedCellCount(rowCount, colCount);
+        return valuesSizeOf(planDecrypt(enc_data, enc_data_len, totalCells, 1), totalCells);
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_table_decrypted_values_size] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+int64_t hcrypt_decrypt_table_values_into(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* enc_data,
+    int64_t enc_data_len,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    uint8_t* values,
+    int64_t capacity,
+    int64_t* offsets,
+    uint8_t* validity
+) {
+    if (!hc || !enc_data || !offsets || (!values && capacity > 0)) return -1;
+
+    try {
+        TraceCall trace("hcrypt_decrypt_table_values_into");
+        int totalCells = checkedCellCount(rowCount, colCount);
+        int participants = pool ? pool->size() + 1 : 1;
+        ColumnMask mask = columnMaskOf(opts, colCount);
+        ChunkPlan plan = planDecrypt(enc_data, enc_data_len, totalCells, participants, mask);
+        CellStatus status(opts);
+        return decryptTableValuesInto(hc, pool, participants, enc_data, plan, totalCells,
+                                      values, capacity, offsets, validity, mask, &status);
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_decrypt_table_values_into] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+uint8_t* hcrypt_decrypt_table_values_alloc(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* enc_data,
+    int64_t enc_data_len,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    int64_t* offsets,
+    uint8_t* validity,
+    int* out_len
+) {
+    if (!hc || !enc_data || !offsets || !out_len) return nullptr;
+
+    const char* where = "[hcrypt_decrypt_table_values_alloc]";
+    try {
+        TraceCall trace("hcrypt_decrypt_table_values_alloc");
+        int totalCells = checkedCellCount(rowCount, colCount);
+        int participants = pool ? pool->size() + 1 : 1;
+        ColumnMask mask = columnMaskOf(opts, colCount);
+        ChunkPlan plan = planDecrypt(enc_data, enc_data_len, totalCells, participants, mask);
+        int64_t size = valuesSizeOf(plan, totalCells);
+        uint8_t* result = allocResult(size, where);
+        try {
+            CellStatus status(opts);
+            decryptTableValuesInto(hc, pool, participants, enc_data, plan, totalCells,
+                                   result, size, offsets, validity, mask, &status);
+        } catch (...) {
+            OPENSSL_cleanse(result, size);
+            delete[] result;
+            throw;
+        }
+        *out_len = (int)size;
         return result;
     } catch (const std::exception& e) {
-        std::cerr << "[hcrypt_generate_iv] 예외: " << e.what() << std::endl;
+        std::cerr << where << " 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+// ============ Base64 암호문 입출력 N×M 테이블 ============
+int64_t hcrypt_table_encrypted_b64_size(
+    const int64_t* offsets,
+    int rowCount,
+    int colCount
+) {
+    if (!offsets) return -1;
+    try {
+        int totalCells = checkedCellCount(rowCount, colCount);
+        CellSource src = CellSource::fromValues(nullptr, offsets);
+        src.validate(totalCells, INT64_MAX);
+        return encryptedTableSize(src, totalCells, kCellBase64);
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_table_encrypted_b64_size] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+int64_t hcrypt_encrypt_table_b64_into(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* values,
+    int64_t values_len,
+    const int64_t* offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    uint8_t* out,
+    int64_t capacity,
+    int64_t* out_offsets
+) {
+    if (!hc || !offsets || !out_offsets || (!values && values_len > 0)) return -1;
+    if (!out && capacity > 0) return -1;
+
+    try {
+        TraceCall trace("hcrypt_encrypt_table_b64_into");
+        int totalCells = checkedCellCount(rowCount, colCount);
+        CellSource src = CellSource::fromValues(values, offsets);
+        src.validate(totalCells, values_len);
+        int participants = pool ? pool->size() + 1 : 1;
+        return encryptTableInto(hc, pool, src, totalCells, participants, nonceModeOf(opts),
+                                out, capacity, kCellBase64, out_offsets);
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_encrypt_table_b64_into] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+uint8_t* hcrypt_encrypt_table_b64_alloc(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* values,
+    int64_t values_len,
+    const int64_t* offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    int64_t* out_offsets,
+    int* out_len
+) {
+    if (!hc || !offsets || !out_offsets || !out_len || (!values && values_len > 0)) return nullptr;
+
+    const char* where = "[hcrypt_encrypt_table_b64_alloc]";
+    try {
+        TraceCall trace("hcrypt_encrypt_table_b64_alloc");
+        int totalCells = checkedCellCount(rowCount, colCount);
+        CellSource src = CellSource::fromValues(values, offsets);
+        src.validate(totalCells, values_len);
+        hcrypt_nonce_mode nonceMode = nonceModeOf(opts);
+        int participants = pool ? pool->size() + 1 : 1;
+        int64_t size = encryptedTableSize(src, totalCells, kCellBase64);
+        uint8_t* result = allocResult(size, where);
+        try {
+            encryptTableInto(hc, pool, src, totalCells, participants, nonceMode,
+                             result, size, kCellBase64, out_offsets);
+        } catch (...) {
+            delete[] result;
+            throw;
+        }
+        *out_len = (int)size;
+        return result;
+    } catch (const std::exception& e) {
+        std::cerr << where << " 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+int64_t hcrypt_table_decrypted_b64_size(
+    const uint8_t* b64,
+    int64_t b64_len,
+    const int64_t* b64_offsets,
+    int rowCount,
+    int colCount
+) {
+    if (!b64_offsets || (!b64 && b64_len > 0)) return -1;
+    try {
+        int totalCells = checkedCellCount(rowCount, colCount);
+        CellSource src = CellSource::fromValues(b64, b64_offsets);
+        src.validate(totalCells, b64_len);
+        // cell_status 를 쓰는 호출 기준 (길이가 틀린 셀 = 0 바이트) - 쓰지 않는 호출은 어차피 실패
+        return planDecryptB64(src, totalCells, 1, kAllColumns, true).outputSize();
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_table_decrypted_b64_size] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+int64_t hcrypt_decrypt_table_b64_into(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* b64,
+    int64_t b64_len,
+    const int64_t* b64_offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    uint8_t* values,
+    int64_t capacity,
+    int64_t* offsets,
+    uint8_t* validity
+) {
+    if (!hc || !b64_offsets || !offsets || (!b64 && b64_len > 0)) return -1;
+    if (!values && capacity > 0) return -1;
+
+    try {
+        TraceCall trace("hcrypt_decrypt_table_b64_into");
+        int totalCells = checkedCellCount(rowCount, colCount);
+        CellSource src = CellSource::fromValues(b64, b64_offsets);
+        src.validate(totalCells, b64_len);
+        int participants = pool ? pool->size() + 1 : 1;
+        ColumnMask mask = columnMaskOf(opts, colCount);
+        CellStatus status(opts);
+        ChunkPlan plan = planDecryptB64(src, totalCells, participants, mask, status.on());
+        return decryptTableB64Into(hc, pool, participants, src, plan, totalCells,
+                                   values, capacity, offsets, validity, mask, &status);
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_decrypt_table_b64_into] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+uint8_t* hcrypt_decrypt_table_b64_alloc(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* b64,
+    int64_t b64_len,
+    const int64_t* b64_offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts,
+    int64_t* offsets,
+    uint8_t* validity,
+    int* out_len
+) {
+    if (!hc || !b64_offsets || !offsets || !out_len || (!b64 && b64_len > 0)) return nullptr;
+
+    const char* where = "[hcrypt_decrypt_table_b64_alloc]";
+    try {
+        TraceCall trace("hcrypt_decrypt_table_b64_alloc");
+        int totalCells = checkedCellCount(rowCount, colCount);
+        CellSource src = CellSource::fromValues(b64, b64_offsets);
+        src.validate(totalCells, b64_len);
+        int participants = pool ? pool->size() + 1 : 1;
+        ColumnMask mask = columnMaskOf(opts, colCount);
+        CellStatus status(opts);
+        ChunkPlan plan = planDecryptB64(src, totalCells, participants, mask, status.on());
+        int64_t size = plan.outputSize();
+        uint8_t* result = allocResult(size, where);
+        try {
+            decryptTableB64Into(hc, pool, participants, src, plan, totalCells,
+                                result, size, offsets, validity, mask, &status);
+        } catch (...) {
+            OPENSSL_cleanse(result, size);
+            delete[] result;
+            throw;
+        }
+        *out_len = (int)size;
+        return result;
+    } catch (const std::exception& e) {
+        std::cerr << where << " 예외: " << e.what() << std::endl;
         return nullptr;
     }
 }
 
-// ------------ (단일 스레드) N×M 테이블 일괄 암/복호화 ------------
-uint8_t* hcrypt_encrypt_table_alloc(
+// ============ 스트리밍 암호화 ============
+hcrypt_stream* hcrypt_stream_begin(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    int colCount,
+    int format,
+    int64_t window_bytes,
+    const hcrypt_table_opts* opts
+) {
+    if (!hc || colCount <= 0 || window_bytes <= 0) return nullptr;
+    if (format != HCRYPT_STREAM_FRAMED && format != HCRYPT_STREAM_BASE64) {
+        std::cerr << "[hcrypt_stream_begin] 지원하지 않는 format" << std::endl;
+        return nullptr;
+    }
+
+    try {
+        if (hc->getKeyLength() == 0) {
+            throw std::runtime_error("키가 설정되지 않음");
+        }
+        std::unique_ptr<hcrypt_stream> s(new hcrypt_stream());
+        s->hc = hc;
+        s->pool = pool ? pool : sharedPool();
+        s->colCount = colCount;
+        s->format = (format == HCRYPT_STREAM_BASE64) ? kCellBase64 : kCellFramed;
+        s->nonceMode = nonceModeOf(opts);
+        s->windowBytes = window_bytes;
+        return s.release();
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_stream_begin] 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+int hcrypt_stream_push_rows(
+    hcrypt_stream* s,
+    const uint8_t* values,
+    int64_t values_len,
+    const int64_t* offsets,
+    int rowCount
+) {
+    if (!s || !offsets || rowCount < 0 || (!values && values_len > 0)) return -1;
+
+    try {
+        int totalCells = checkedCellCount(rowCount, s->colCount);
+        CellSource src = CellSource::fromValues(values, offsets);
+        src.validate(totalCells, values_len);
+        if (totalCells == 0) return 1;
+
+        int64_t inBytes = offsets[totalCells] - offsets[0];
+        int64_t bytes = inBytes + encryptedTableSize(src, totalCells, s->format)
+                      + (int64_t)(totalCells + 1) * 8 * (s->format == kCellBase64 ? 2 : 1);
+
+        {
+            std::lock_guard<std::mutex> lock(s->mtx);
+            if (s->failed) return -1;
+            // window 가 차면 거절 (단, 비어 있으면 큰 묶음도 하나는 받음)
+            bool empty = s->pending.empty() && !s->current;
+            if (!empty && s->inflightBytes + bytes > s->windowBytes) return 0;
+        }
+
+        // 입력 복사 (호출자는 반환 즉시 버퍼를 재사용할 수 있음)
+        std::shared_ptr<StreamBatch> batch = std::make_shared<StreamBatch>();
+        batch->rowCount = rowCount;
+        batch->bytes = bytes;
+        batch->values.assign(values + offsets[0], values + offsets[totalCells]);
+        batch->offsets.resize((size_t)totalCells + 1);
+        for (int i = 0; i <= totalCells; i++) {
+            batch->offsets[i] = offsets[i] - offsets[0];
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(s->mtx);
+            batch->firstRow = s->nextRow;
+            s->nextRow += rowCount;
+            s->inflightBytes += bytes;
+            s->pending.push_back(batch);
+            s->running++;
+        }
+
+        auto finish = [s, batch] {
+            runStreamBatch(s, *batch);
+            std::lock_guard<std::mutex> lock(s->mtx);
+            batch->done = true;
+            s->running--;
+            s->cv.notify_all();
+        };
+        if (s->pool && s->pool->size() > 0) {
+            s->pool->submit(finish);
+        } else {
+            finish();
+        }
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_stream_push_rows] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+int hcrypt_stream_pull_output(
+    hcrypt_stream* s,
+    int wait,
+    hcrypt_stream_chunk* chunk
+) {
+    if (!s || !chunk) return -1;
+
+    std::unique_lock<std::mutex> lock(s->mtx);
+    releaseStreamBatch(s, s->current);
+    if (s->pending.empty()) return 0;
+
+    std::shared_ptr<StreamBatch> head = s->pending.front();
+    if (!head->done) {
+        if (!wait) return 0;
+        s->cv.wait(lock, [&] { return head->done; });
+    }
+    s->pending.pop_front();
+
+    if (!head->error.empty()) {
+        s->failed = true;
+        s->inflightBytes -= head->bytes;
+        std::cerr << "[hcrypt_stream_pull_output] 예외: " << head->error << std::endl;
+        return -1;
+    }
+
+    s->current = head;
+    chunk->first_row = head->firstRow;
+    chunk->row_count = head->rowCount;
+    chunk->data = head->out.get();
+    chunk->data_len = head->outLen;
+    chunk->offsets = head->outOffsets.empty() ? nullptr : head->outOffsets.data();
+    return 1;
+}
+
+int64_t hcrypt_stream_finish(hcrypt_stream* s) {
+    if (!s) return -1;
+
+    int64_t rows;
+    bool failed;
+    {
+        // 풀에서 실행 중인 묶음이 끝나야 해제 가능
+        std::unique_lock<std::mutex> lock(s->mtx);
+        s->cv.wait(lock, [&] { return s->running == 0; });
+        rows = s->nextRow;
+        failed = s->failed;
+        for (auto &batch : s->pending) {
+            if (!batch->error.empty()) failed = true;
+        }
+    }
+    delete s;
+    return failed ? -1 : rows;
+}
+
+// ============ 비동기 테이블 작업 ============
+int64_t hcrypt_submit_encrypt_table(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t** table,
+    const int* cell_sizes,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts
+) {
+    if (!hc || !table || !cell_sizes) return -1;
+
+    try {
+        if (hc->getKeyLength() == 0) {
+            throw std::runtime_error("키가 설정되지 않음");
+        }
+        std::shared_ptr<TableJob> job = newTableJob(rowCount, colCount, opts);
+        int totalCells = job->totalCells();
+        CellSource::fromTable(table, cell_sizes).validate(totalCells, 0);
+
+        // 포인터 배열 → values + offsets 로 이어 붙여 복사
+        job->plainInput = true;
+        job->inOffsets.resize((size_t)totalCells + 1);
+        job->inOffsets[0] = 0;
+        for (int i = 0; i < totalCells; i++) {
+            job->inOffsets[i + 1] = job->inOffsets[i] + (cell_sizes[i] > 0 ? cell_sizes[i] : 0);
+        }
+        job->input.resize((size_t)job->inOffsets[totalCells]);
+        for (int i = 0; i < totalCells; i++) {
+            int64_t n = job->inOffsets[i + 1] - job->inOffsets[i];
+            if (n > 0) memcpy(job->input.data() + job->inOffsets[i], table[i], (size_t)n);
+        }
+
+        hcrypt_pool* p = jobPool(pool);
+        return startTableJob(p, job, [hc, p](TableJob& j) {
+            runEncryptJob(hc, p, j, kCellFramed);
+        }, "hcrypt_submit_encrypt_table");
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_submit_encrypt_table] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+int64_t hcrypt_submit_encrypt_table_values(
     hcrypt_gcm_kdf* hc,
-    const uint8_t** table,
-    const int* cell_sizes,
+    hcrypt_pool* pool,
+    const uint8_t* values,
+    int64_t values_len,
+    const int64_t* offsets,
     int rowCount,
     int colCount,
-    int* out_len
+    const hcrypt_table_opts* opts
 ) {
-    if (!hc || !table || !cell_sizes || !out_len) return nullptr;
+    if (!hc || !offsets || (!values && values_len > 0)) return -1;
 
     try {
-        std::vector<uint8_t> allEncrypted;
-        allEncrypted.reserve(rowCount * colCount * 64);
-
-        int totalCells = rowCount * colCount;
-        for (int i = 0; i < totalCells; i++) {
-            int cellLen = cell_sizes[i];
-
-            // --- [빈 문자열 예외처리] ---
-            if (cellLen <= 0) {
-                // 암호화 없이 [4바이트 encSize=0]만 기록
-                int encSize = 0;
-                uint8_t sizeBytes[4];
-                std::memcpy(sizeBytes, &encSize, 4);
-                allEncrypted.insert(allEncrypted.end(), sizeBytes, sizeBytes + 4);
-                continue; 
-            }
-            // ---------------------------
+        if (hc->getKeyLength() == 0) {
+            throw std::runtime_error("키가 설정되지 않음");
+        }
+        std::shared_ptr<TableJob> job = newTableJob(rowCount, colCount, opts);
+        CellSource::fromValues(values, offsets).validate(job->totalCells(), values_len);
+        job->plainInput = true;
+        copyValuesInput(*job, values, offsets);
 
-            std::vector<uint8_t> plain(table[i], table[i] + cellLen);
-            std::vector<uint8_t> enc = hc->encrypt(plain);
+        hcrypt_pool* p = jobPool(pool);
+        return startTableJob(p, job, [hc, p](TableJob& j) {
+            runEncryptJob(hc, p, j, kCellFramed);
+        }, "hcrypt_submit_encrypt_table_values");
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_submit_encrypt_table_values] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
 
-            // [4바이트 encSize] + [enc]
-            int encSize = (int)enc.size();
-            uint8_t sizeBytes[4];
-            std::memcpy(sizeBytes, &encSize, 4);
+int64_t hcrypt_submit_encrypt_table_b64(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* values,
+    int64_t values_len,
+    const int64_t* offsets,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts
+) {
+    if (!hc || !offsets || (!values && values_len > 0)) return -1;
 
-            allEncrypted.insert(allEncrypted.end(), sizeBytes, sizeBytes + 4);
-            allEncrypted.insert(allEncrypted.end(), enc.begin(), enc.end());
+    try {
+        if (hc->getKeyLength() == 0) {
+            throw std::runtime_error("키가 설정되지 않음");
         }
+        std::shared_ptr<TableJob> job = newTableJob(rowCount, colCount, opts);
+        CellSource::fromValues(values, offsets).validate(job->totalCells(), values_len);
+        job->plainInput = true;
+        copyValuesInput(*job, values, offsets);
 
-        *out_len = (int)allEncrypted.size();
-        uint8_t* result = new uint8_t[*out_len];
-        std::memcpy(result, allEncrypted.data(), *out_len);
-        return result;
+        hcrypt_pool* p = jobPool(pool);
+        return startTableJob(p, job, [hc, p](TableJob& j) {
+            runEncryptJob(hc, p, j, kCellBase64);
+        }, "hcrypt_submit_encrypt_table_b64");
     } catch (const std::exception& e) {
-        std::cerr << "[hcrypt_encrypt_table_alloc] 예외: " << e.what() << std::endl;
-        return nullptr;
+        std::cerr << "[hcrypt_submit_encrypt_table_b64] 예외: " << e.what() << std::endl;
+        return -1;
     }
 }
 
-uint8_t* hcrypt_decrypt_table_alloc(
+int64_t hcrypt_submit_decrypt_table(
     hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
     const uint8_t* enc_data,
-    int enc_data_len,
+    int64_t enc_data_len,
     int rowCount,
     int colCount,
-    int* out_len
+    const hcrypt_table_opts* opts
 ) {
-    if (!hc || !enc_data || !out_len) return nullptr;
+    if (!hc || !enc_data || enc_data_len < 0) return -1;
 
     try {
-        std::vector<uint8_t> allDecrypted;
-        allDecrypted.reserve(enc_data_len);
-
-        int offset = 0;
-        int totalCells = rowCount * colCount;
-
-        for (int i = 0; i < totalCells; i++) {
-            if (offset + 4 > enc_data_len) {
-                throw std::runtime_error("[hcrypt_decrypt_table_alloc] 범위 초과(헤더4바이트)");
-            }
-            int encSize = 0;
-            std::memcpy(&encSize, enc_data + offset, 4);
-            offset += 4;
+        if (hc->getKeyLength() == 0) {
+            throw std::runtime_error("키가 설정되지 않음");
+        }
+        std::shared_ptr<TableJob> job = newTableJob(rowCount, colCount, opts);
+        job->input.assign(enc_data, enc_data + enc_data_len);
 
-            // --- [빈 문자열 예외처리] ---
-            if (encSize == 0) {
-                // 빈 셀 → 그냥 넘어가되, 여기서는 복원할 때
-                // "빈 문자열" 처리를 할 수 있도록 로직 설계
-                continue;
-            }
-            // ---------------------------
+        hcrypt_pool* p = jobPool(pool);
+        return startTableJob(p, job, [hc, p](TableJob& j) {
+            runDecryptJob(hc, p, j, kJobFramed);
+        }, "hcrypt_submit_decrypt_table");
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_submit_decrypt_table] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
 
-            if (offset + encSize > enc_data_len) {
-                throw std::runtime_error("[hcrypt_decrypt_table_alloc] 범위 초과(encSize)");
-            }
-            std::vector<uint8_t> encCell(enc_data + offset, enc_data + offset + encSize);
-            offset += encSize;
+int64_t hcrypt_submit_decrypt_table_values(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* enc_data,
+    int64_t enc_data_len,
+    int rowCount,
+    int colCount,
+    const hcrypt_table_opts* opts
+) {
+    if (!hc || !enc_data || enc_data_len < 0) return -1;
 
-            std::vector<uint8_t> decCell = hc->decrypt(encCell);
-            allDecrypted.insert(allDecrypted.end(), decCell.begin(), decCell.end());
+    try {
+        if (hc->getKeyLength() == 0) {
+            throw std::runtime_error("키가 설정되지 않음");
         }
+        std::shared_ptr<TableJob> job = newTableJob(rowCount, colCount, opts);
+        job->input.assign(enc_data, enc_data + enc_data_len);
 
-        *out_len = (int)allDecrypted.size();
-        uint8_t* result = new uint8_t[*out_len];
-        std::memcpy(result, allDecrypted.data(), *out_len);
-        return result;
+        hcrypt_pool* p = jobPool(pool);
+        return startTableJob(p, job, [hc, p](TableJob& j) {
+            runDecryptJob(hc, p, j, kJobValues);
+        }, "hcrypt_submit_decrypt_table_values");
     } catch (const std::exception& e) {
-        std::cerr << "[hcrypt_decrypt_table_alloc] 예외: " << e.what() << std::endl;
-        return nullptr;
+        std::cerr << "[hcrypt_submit_decrypt_table_values] 예외: " << e.what() << std::endl;
+        return -1;
     }
 }
 
-// ============ (멀티 스레드) N×M 테이블 암호화 ============
-uint8_t* hcrypt_encrypt_table_mt_alloc(
+int64_t hcrypt_submit_decrypt_table_b64(
     hcrypt_gcm_kdf* hc,
-    const uint8_t** table,
-    const int* cell_sizes,
+    hcrypt_pool* pool,
+    const uint8_t* b64,
+    int64_t b64_len,
+    const int64_t* b64_offsets,
     int rowCount,
     int colCount,
-    int threadCount,
-    int* out_len
+    const hcrypt_table_opts* opts
 ) {
-    if (!hc || !table || !cell_sizes || !out_len || threadCount <= 0) {
-        return nullptr;
-    }
+    if (!hc || !b64_offsets || (!b64 && b64_len > 0)) return -1;
 
     try {
-        // (1) 우선 hc에서 키를 가져온다
-        std::vector<uint8_t> mainKey = hc->getKey();
-        if (mainKey.empty()) {
-            throw std::runtime_error("[hcrypt_encrypt_table_mt_alloc] 키가 설정되지 않음");
+        if (hc->getKeyLength() == 0) {
+            throw std::runtime_error("키가 설정되지 않음");
         }
+        std::shared_ptr<TableJob> job = newTableJob(rowCount, colCount, opts);
+        CellSource::fromValues(b64, b64_offsets).validate(job->totalCells(), b64_len);
+        copyValuesInput(*job, b64, b64_offsets);
 
-        int totalCells = rowCount * colCount;
-        std::vector<std::vector<uint8_t>> encryptedCells(totalCells);
-
-        // (2) 스레드 함수
-        auto worker = [&](int startIdx, int endIdx) {
-            // 이 스레드만의 local 객체
-            hcrypt_gcm_kdf localHc;
-            localHc.setKey(mainKey);  // 같은 키로 설정
-
-            for (int i = startIdx; i < endIdx; i++) {
-                int cellLen = cell_sizes[i];
-
-                // 빈 셀 처리
-                if (cellLen <= 0) {
-                    // [4바이트 encSize=0]만
-                    int encSize = 0;
-                    std::vector<uint8_t> resultCell(4, 0);
-                    std::memcpy(resultCell.data(), &encSize, 4);
-                    encryptedCells[i] = std::move(resultCell);
-                    continue;
-                }
+        hcrypt_pool* p = jobPool(pool);
+        return startTableJob(p, job, [hc, p](TableJob& j) {
+            runDecryptJob(hc, p, j, kJobBase64);
+        }, "hcrypt_submit_decrypt_table_b64");
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_submit_decrypt_table_b64] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
 
-                std::vector<uint8_t> plain(table[i], table[i] + cellLen);
-                std::vector<uint8_t> enc = localHc.encrypt(plain);
+int hcrypt_job_poll(int64_t job_id) {
+    std::lock_guard<std::mutex> lock(g_jobs_mutex);
+    std::shared_ptr<TableJob> job = findJob(job_id);
+    return job ? jobState(*job) : -1;
+}
 
-                // [4바이트 encSize] + [enc]
-                int encSize = (int)enc.size();
-                std::vector<uint8_t> resultCell(4 + encSize);
-                std::memcpy(resultCell.data(), &encSize, 4);
-                std::memcpy(resultCell.data() + 4, enc.data(), encSize);
+int hcrypt_job_wait(int64_t job_id, int timeout_ms) {
+    std::unique_lock<std::mutex> lock(g_jobs_mutex);
+    std::shared_ptr<TableJob> job = findJob(job_id);
+    if (!job) return -1;
 
-                encryptedCells[i] = std::move(resultCell);
-            }
-        };
+    if (timeout_ms < 0) {
+        g_jobs_cv.wait(lock, [&] { return job->done; });
+    } else {
+        g_jobs_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                           [&] { return job->done; });
+    }
+    return jobState(*job);
+}
 
-        // (3) 스레드 분할
-        std::vector<std::thread> threads;
-        threads.reserve(threadCount);
+int hcrypt_job_result(int64_t job_id, hcrypt_job_output* result) {
+    if (!result) return -1;
 
-        int chunkSize = (totalCells + threadCount - 1) / threadCount;
-        int start = 0;
-        for (int t = 0; t < threadCount; t++) {
-            int end = std::min(start + chunkSize, totalCells);
-            if (start >= end) break;
-            threads.emplace_back(worker, start, end);
-            start = end;
-        }
+    std::lock_guard<std::mutex> lock(g_jobs_mutex);
+    std::shared_ptr<TableJob> job = findJob(job_id);
+    if (!job || !job->done) return -1;
+    if (!job->error.empty()) {
+        std::cerr << "[hcrypt_job_result] 예외: " << job->error << std::endl;
+        return -1;
+    }
 
-        // (4) join
-        for (auto &th : threads) {
-            if (th.joinable()) th.join();
-        }
+    result->data = job->out.get();
+    result->data_len = job->outLen;
+    result->offsets = job->offsets.empty() ? nullptr : job->offsets.data();
+    result->validity = job->validity.empty() ? nullptr : job->validity.data();
+    result->cell_status = job->status.empty() ? nullptr : job->status.data();
+    result->failed_cells = job->failed;
+    return 0;
+}
 
-        // (5) 결과를 하나로 합침
-        std::vector<uint8_t> allEncrypted;
-        allEncrypted.reserve(rowCount * colCount * 64);
-        for (auto &cellEnc : encryptedCells) {
-            allEncrypted.insert(allEncrypted.end(), cellEnc.begin(), cellEnc.end());
-        }
+void hcrypt_job_release(int64_t job_id) {
+    // 실행 중이면 워커가 가진 참조가 끝날 때 해제됨
+    std::shared_ptr<TableJob> job;
+    {
+        std::lock_guard<std::mutex> lock(g_jobs_mutex);
+        auto it = g_jobs.find(job_id);
+        if (it == g_jobs.end()) return;
+        job = std::move(it->second);
+        g_jobs.erase(it);
+    }
+}
 
-        *out_len = (int)allEncrypted.size();
-        uint8_t* result = new uint8_t[*out_len];
-        std::memcpy(result, allEncrypted.data(), *out_len);
-        return result;
+// ============ 행 인덱스 컨테이너 ============
+int64_t hcrypt_table_index_size(int rowCount) {
+    if (rowCount < 0) return -1;
+    return containerIndexSize(rowCount);
+}
+
+int64_t hcrypt_table_build_index(
+    hcrypt_pool* pool,
+    const uint8_t* body,
+    int64_t body_len,
+    int rowCount,
+    int colCount,
+    uint8_t* out,
+    int64_t capacity
+) {
+    if ((!body && body_len > 0) || body_len < 0 || !out) return -1;
 
+    try {
+        int64_t size = containerIndexSize(rowCount);
+        if (size > capacity) {
+            throw std::runtime_error("출력 버퍼 용량 부족");
+        }
+        int participants = pool ? pool->size() + 1 : 1;
+        std::vector<int64_t> rowStart = buildRowIndex(pool, participants, body, body_len,
+                                                      rowCount, colCount);
+        writeContainerIndex(rowStart, body_len, rowCount, colCount, out);
+        return size;
     } catch (const std::exception& e) {
-        std::cerr << "[hcrypt_encrypt_table_mt_alloc] 예외: " << e.what() << std::endl;
-        return nullptr;
+        std::cerr << "[hcrypt_table_build_index] 예외: " << e.what() << std::endl;
+        return -1;
     }
 }
 
-// ============ (멀티 스레드) N×M 테이블 복호화 ============
-uint8_t* hcrypt_decrypt_table_mt_alloc(
+uint8_t* hcrypt_encrypt_table_container_alloc(
     hcrypt_gcm_kdf* hc,
-    const uint8_t* enc_data,
-    int enc_data_len,
+    hcrypt_pool* pool,
+    const uint8_t* values,
+    int64_t values_len,
+    const int64_t* offsets,
     int rowCount,
     int colCount,
-    int threadCount,
+    const hcrypt_table_opts* opts,
     int* out_len
 ) {
-    if (!hc || !enc_data || !out_len || threadCount <= 0) {
+    if (!hc || !offsets || !out_len || (!values && values_len > 0)) return nullptr;
+
+    const char* where = "[hcrypt_encrypt_table_container_alloc]";
+    try {
+        TraceCall trace("hcrypt_encrypt_table_container_alloc");
+        int totalCells = checkedCellCount(rowCount, colCount);
+        CellSource src = CellSource::fromValues(values, offsets);
+        src.validate(totalCells, values_len);
+        hcrypt_nonce_mode nonceMode = nonceModeOf(opts);
+        int participants = pool ? pool->size() + 1 : 1;
+
+        int64_t bodyLen = encryptedTableSize(src, totalCells);
+        int64_t size = bodyLen + containerIndexSize(rowCount);
+        uint8_t* result = allocResult(size, where);
+        try {
+            encryptTableInto(hc, pool, src, totalCells, participants, nonceMode, result, bodyLen);
+            writeContainerIndex(rowIndexFromSource(src, rowCount, colCount), bodyLen,
+                                rowCount, colCount, result + bodyLen);
+        } catch (...) {
+            delete[] result;
+            throw;
+        }
+        *out_len = (int)size;
+        return result;
+    } catch (const std::exception& e) {
+        std::cerr << where << " 예외: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+int hcrypt_table_container_info(
+    const uint8_t* blob,
+    int64_t blob_len,
+    int* rowCount,
+    int* colCount
+) {
+    if (!blob || !rowCount || !colCount) return -1;
+    try {
+        ContainerView c = openContainer(blob, blob_len);
+        *rowCount = c.rowCount;
+        *colCount = c.colCount;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_table_container_info] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+int64_t hcrypt_rows_decrypted_size(
+    const uint8_t* blob,
+    int64_t blob_len,
+    int first_row,
+    int row_count
+) {
+    if (!blob) return -1;
+    try {
+        ContainerView c = openContainer(blob, blob_len);
+        const uint8_t* sub = nullptr;
+        ChunkPlan plan = planRows(c, first_row, row_count, 1, &sub);
+        return valuesSizeOf(plan, row_count * c.colCount);
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_rows_decrypted_size] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+int64_t hcrypt_decrypt_rows_into(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* blob,
+    int64_t blob_len,
+    int first_row,
+    int row_count,
+    const hcrypt_table_opts* opts,
+    uint8_t* values,
+    int64_t capacity,
+    int64_t* offsets,
+    uint8_t* validity
+) {
+    if (!hc || !blob || !offsets || (!values && capacity > 0)) return -1;
+
+    try {
+        TraceCall trace("hcrypt_decrypt_rows_into");
+        ContainerView c = openContainer(blob, blob_len);
+        int participants = pool ? pool->size() + 1 : 1;
+        ColumnMask mask = columnMaskOf(opts, c.colCount);
+        const uint8_t* sub = nullptr;
+        ChunkPlan plan = planRows(c, first_row, row_count, participants, &sub, mask);
+        CellStatus status(opts);
+        return decryptTableValuesInto(hc, pool, participants, sub, plan, row_count * c.colCount,
+                                      values, capacity, offsets, validity, mask, &status);
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_decrypt_rows_into] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+uint8_t* hcrypt_decrypt_rows(
+    hcrypt_gcm_kdf* hc,
+    hcrypt_pool* pool,
+    const uint8_t* blob,
+    int64_t blob_len,
+    int first_row,
+    int row_count,
+    const hcrypt_table_opts* opts,
+    int64_t* offsets,
+    uint8_t* validity,
+    int* out_len
+) {
+    if (!hc || !blob || !offsets || !out_len) return nullptr;
+
+    const char* where = "[hcrypt_decrypt_rows]";
+    try {
+        TraceCall trace("hcrypt_decrypt_rows");
+        ContainerView c = openContainer(blob, blob_len);
+        int participants = pool ? pool->size() + 1 : 1;
+        ColumnMask mask = columnMaskOf(opts, c.colCount);
+        const uint8_t* sub = nullptr;
+        ChunkPlan plan = planRows(c, first_row, row_count, participants, &sub, mask);
+        int totalCells = row_count * c.colCount;
+        int64_t size = valuesSizeOf(plan, totalCells);
+        uint8_t* result = allocResult(size, where);
+        try {
+            CellStatus status(opts);
+            decryptTableValuesInto(hc, pool, participants, sub, plan, totalCells,
+                                   result, size, offsets, validity, mask, &status);
+        } catch (...) {
+            OPENSSL_cleanse(result, size);
+            delete[] result;
+            throw;
+        }
+        *out_len = (int)size;
+        return result;
+    } catch (const std::exception& e) {
+        std::cerr << where << " 예외: " << e.what() << std::endl;
         return nullptr;
     }
+}
+
+// ============ 프로세스 간 공유 복호화 캐시 ============
+int hcrypt_cache_attach(const char* name, int64_t budget_bytes) {
+    if (!name || budget_bytes <= 0) return -1;
 
+    std::lock_guard<std::mutex> lock(g_shm_cache_mutex);
     try {
-        std::vector<uint8_t> mainKey = hc->getKey();
-        if (mainKey.empty()) {
-            throw std::runtime_error("[hcrypt_decrypt_table_mt_alloc] 키가 설정되지 않음");
+        // 요청마다 attach 하는 PHP-FPM 워커: 같은 이름/예산이면 이미 붙은 세그먼트를 그대로 씀
+        ShmCellCache* current = g_shm_cache.load();
+        if (current) {
+            if (current->name == shmName(name) && current->budget == budget_bytes) return 0;
+            throw std::runtime_error("이미 다른 공유 캐시에 붙어 있습니다.");
         }
+        ShmCellCache* cache = openShmCellCache(shmName(name), budget_bytes);
+        cache->name = shmName(name);
+        cache->budget = budget_bytes;
+        g_shm_cache.store(cache, std::memory_order_release);
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_cache_attach] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
 
-        int totalCells = rowCount * colCount;
-        std::vector<int> offsets(totalCells);
-        std::vector<int> sizes(totalCells);
+void hcrypt_cache_detach(void) {
+    std::lock_guard<std::mutex> lock(g_shm_cache_mutex);
+    ShmCellCache* cache = g_shm_cache.exchange(nullptr);
+    if (cache) {
+        munmap(cache->base, cache->mapped);
+        delete cache;
+    }
+}
 
-        // (1) enc_data 스캔 → 각 셀 암호문 offset/size 파악
-        int offset = 0;
-        for (int i = 0; i < totalCells; i++) {
-            if (offset + 4 > enc_data_len) {
-                throw std::runtime_error("복호화: enc_data 범위 초과(헤더4바이트)");
-            }
-            int encSize = 0;
-            std::memcpy(&encSize, enc_data + offset, 4);
-            offset += 4;
+int hcrypt_cache_unlink(const char* name) {
+    if (!name) return -1;
+    if (shm_unlink(shmName(name).c_str()) != 0 && errno != ENOENT) {
+        std::cerr << "[hcrypt_cache_unlink] shm_unlink 실패: " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+    return 0;
+}
 
-            if (offset + encSize > enc_data_len) {
-                throw std::runtime_error("복호화: enc_data 범위 초과(encSize)");
-            }
-            offsets[i] = offset;
-            sizes[i]   = encSize;
-            offset    += encSize;
+int hcrypt_cache_get_stats(hcrypt_cache_stats* out) {
+    if (!out) return -1;
+    std::lock_guard<std::mutex> lock(g_shm_cache_mutex);
+    ShmCellCache* cache = g_shm_cache.load();
+    if (!cache) return -1;
+    ShmHeader* h = cache->header;
+    out->hits      = h->hits.load(std::memory_order_relaxed);
+    out->misses    = h->misses.load(std::memory_order_relaxed);
+    out->inserts   = h->inserts.load(std::memory_order_relaxed);
+    out->evictions = h->evictions.load(std::memory_order_relaxed);
+    out->capacity_bytes = (int64_t)h->segmentBytes;
+    out->max_cell_bytes = (int)(kShmMaxCipherLen - 12 - 16);
+    return 0;
+}
+
+// ============ CPU 기능 / 사용 중인 커널 ============
+int hcrypt_get_capabilities(hcrypt_capabilities* out) {
+    if (!out) return -1;
+    const CpuIsa& isa = cpuIsa();
+    out->cpu_features   = isa.features;
+    out->detected_level = isa.detected;
+    out->active_level   = isa.level;
+    out->small_gcm = smallGcmEngineName();
+    out->base64    = b64Codec().name;
+    out->pbkdf2    = kdfEngine().name;
+    return 0;
+}
+
+// ============ 성능 카운터 ============
+void hcrypt_stats_enable(int on) {
+    g_stats_enabled.store(on != 0, std::memory_order_relaxed);
+}
+
+int hcrypt_stats_enabled(void) {
+    return statsOn() ? 1 : 0;
+}
+
+int hcrypt_stats_snapshot(hcrypt_stats* out) {
+    if (!out) return -1;
+    uint64_t v[kStatCount];
+    {
+        std::lock_guard<std::mutex> lock(g_stats_mutex);
+        statTotals(v);
+        for (int i = 0; i < kStatCount; i++) v[i] -= g_stats_base[i];
+    }
+    out->calls        = v[kStatCalls];
+    out->cells        = v[kStatCells];
+    out->plain_bytes  = v[kStatPlainBytes];
+    out->cipher_bytes = v[kStatCipherBytes];
+    out->tag_failures = v[kStatTagFailures];
+    out->ns_nonce     = v[kStatNsNonce];
+    out->ns_aes_gcm   = v[kStatNsAesGcm];
+    out->ns_output    = v[kStatNsOutput];
+    out->ns_alloc     = v[kStatNsAlloc];
+    return 0;
+}
+
+void hcrypt_stats_reset(void) {
+    std::lock_guard<std::mutex> lock(g_stats_mutex);
+    statTotals(g_stats_base);
+}
+
+int64_t hcrypt_stats_prometheus(char* buf, int64_t cap) {
+    if (cap < 0 || (!buf && cap > 0)) return -1;
+    hcrypt_stats st;
+    if (hcrypt_stats_snapshot(&st) != 0) return -1;
+
+    try {
+        std::string text;
+        char line[128];
+        auto counter = [&](const char* name, const char* help, uint64_t value) {
+            text += std::string("# HELP ") + name + " " + help + "\n";
+            text += std::string("# TYPE ") + name + " counter\n";
+            std::snprintf(line, sizeof(line), "%s %llu\n", name, (unsigned long long)value);
+            text += line;
+        };
+        counter("hcrypt_calls_total", "Table and single-cell API calls.", st.calls);
+        counter("hcrypt_cells_total", "Cells encrypted or decrypted.", st.cells);
+        counter("hcrypt_plaintext_bytes_total", "Plaintext bytes processed.", st.plain_bytes);
+        counter("hcrypt_ciphertext_bytes_total", "Ciphertext bytes processed (IV + data + tag).", st.cipher_bytes);
+        counter("hcrypt_tag_failures_total", "Cells rejected by GCM tag check.", st.tag_failures);
+
+        text += "# HELP hcrypt_phase_seconds_total Thread time spent per phase.\n";
+        text += "# TYPE hcrypt_phase_seconds_total counter\n";
+        const std::pair<const char*, uint64_t> phases[] = {
+            {"nonce", st.ns_nonce}, {"aes_gcm", st.ns_aes_gcm},
+            {"output", st.ns_output}, {"alloc", st.ns_alloc},
+        };
+        for (const auto &ph : phases) {
+            std::snprintf(line, sizeof(line), "hcrypt_phase_seconds_total{phase=\"%s\"} %.9f\n",
+                          ph.first, (double)ph.second / 1e9);
+            text += line;
         }
 
-        std::vector<std::vector<uint8_t>> decryptedCells(totalCells);
+        text += "# HELP hcrypt_stats_enabled Whether counters are being collected.\n";
+        text += "# TYPE hcrypt_stats_enabled gauge\n";
+        text += statsOn() ? "hcrypt_stats_enabled 1\n" : "hcrypt_stats_enabled 0\n";
 
-        // (2) 스레드 함수
-        auto worker = [&](int startIdx, int endIdx) {
-            hcrypt_gcm_kdf localHc;
-            localHc.setKey(mainKey);
+        if (cap > 0) {
+            size_t n = std::min(text.size(), (size_t)(cap - 1));
+            std::memcpy(buf, text.data(), n);
+            buf[n] = '\0';
+        }
+        return (int64_t)text.size();
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_stats_prometheus] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+// ============ 추적 링 버퍼 ============
+void hcrypt_trace_enable(int on) {
+    try {
+        traceSetEnabled(on != 0);
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_trace_enable] 예외: " << e.what() << std::endl;
+    }
+}
 
-            for (int i = startIdx; i < endIdx; i++) {
-                int encSize   = sizes[i];
-                int encOffset = offsets[i];
+int hcrypt_trace_enabled(void) {
+    return traceOn() ? 1 : 0;
+}
 
-                // 빈 셀 처리
-                if (encSize == 0) {
-                    // [4바이트 plainLen=0]만
-                    std::vector<uint8_t> emptyCell(4, 0);
-                    decryptedCells[i] = std::move(emptyCell);
-                    continue;
-                }
+void hcrypt_trace_clear(void) {
+    g_trace_base.store(g_trace_next.load());
+}
 
-                std::vector<uint8_t> encCell(
-                    enc_data + encOffset,
-                    enc_data + encOffset + encSize
-                );
+int64_t hcrypt_trace_dump_json(char* buf, int64_t cap) {
+    if (cap < 0 || (!buf && cap > 0)) return -1;
 
-                // 실제 복호화
-                std::vector<uint8_t> dec = localHc.decrypt(encCell);
-                int plainLen = (int)dec.size();
+    try {
+        std::string text = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        TraceEvent* ring = g_trace_ring.load(std::memory_order_acquire);
+        uint64_t end = g_trace_next.load();
+        uint64_t begin = std::max(g_trace_base.load(), end > kTraceEvents ? end - kTraceEvents : 0);
+        int pid = (int)getpid();
+        char line[256];
+        bool first = true;
 
-                // 이제 [4바이트 plainLen] + [plainData] 기록
-                std::vector<uint8_t> resultCell(4 + plainLen);
-                std::memcpy(resultCell.data(), &plainLen, 4);
-                std::memcpy(resultCell.data() + 4, dec.data(), plainLen);
+        for (uint64_t idx = begin; ring && idx < end; idx++) {
+            // seqlock: 읽는 동안 seq 가 바뀌었으면 덮어쓰는 중인 칸 → 건너뜀
+            TraceEvent& e = ring[idx % kTraceEvents];
+            uint64_t seq = e.seq.load(std::memory_order_acquire);
+            uint64_t call = e.call.load(std::memory_order_relaxed);
+            uint64_t startNs = e.startNs.load(std::memory_order_relaxed);
+            uint64_t endNs = e.endNs.load(std::memory_order_relaxed);
+            int64_t arg = e.arg.load(std::memory_order_relaxed);
+            const char* name = e.name.load(std::memory_order_relaxed);
+            const char* argName = e.argName.load(std::memory_order_relaxed);
+            uint32_t tid = e.tid.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq != idx + 1 || e.seq.load(std::memory_order_relaxed) != seq) continue;
 
-                decryptedCells[i] = std::move(resultCell);
+            std::snprintf(line, sizeof(line),
+                          "%s\n{\"name\":\"%s\",\"cat\":\"hcrypt\",\"ph\":\"X\","
+                          "\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                          "\"args\":{\"call\":%llu",
+                          first ? "" : ",", name, pid, tid,
+                          (double)startNs / 1e3, (double)(endNs - startNs) / 1e3,
+                          (unsigned long long)call);
+            text += line;
+            if (argName) {
+                std::snprintf(line, sizeof(line), ",\"%s\":%lld", argName, (long long)arg);
+                text += line;
             }
-        };
+            text += "}}";
+            first = false;
+        }
+        text += "\n]}\n";
 
-        // (3) 스레드 분할
-        std::vector<std::thread> threads;
-        threads.reserve(threadCount);
+        if (cap > 0) {
+            size_t n = std::min(text.size(), (size_t)(cap - 1));
+            std::memcpy(buf, text.data(), n);
+            buf[n] = '\0';
+        }
+        return (int64_t)text.size();
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_trace_dump_json] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
 
-        int chunkSize = (totalCells + threadCount - 1) / threadCount;
-        int startIdx  = 0;
-        for (int t = 0; t < threadCount; t++) {
-            int endIdx = std::min(startIdx + chunkSize, totalCells);
-            if (startIdx >= endIdx) break;
-            threads.emplace_back(worker, startIdx, endIdx);
-            startIdx = endIdx;
+// ============ 파생 키 캐시 ============
+int hcrypt_derive_key_cached(hcrypt_gcm_kdf* hc,
+                             const char* password,
+                             const uint8_t* salt,
+                             int salt_len,
+                             int key_len,
+                             int iteration)
+{
+    if (!hc || !password || (!salt && salt_len > 0) || salt_len < 0) return -1;
+
+    uint8_t key[32];
+    try {
+        if (key_len != 16 && key_len != 24 && key_len != 32) {
+            throw std::invalid_argument("keyLen은 16/24/32 중 하나여야 합니다.");
         }
+        attachKeyTableFromEnv();
+        KeyTable* local = processKeyTable();
+        KeyTable* shared = g_shared_keys.load(std::memory_order_acquire);
 
-        // (4) join
-        for (auto &th : threads) {
-            if (th.joinable()) th.join();
+        uint8_t localTag[32], sharedTag[32];
+        keyTableTag(local, password, salt, salt_len, iteration, key_len, localTag);
+        if (shared) {
+            keyTableTag(shared, password, salt, salt_len, iteration, key_len, sharedTag);
         }
 
-        // (5) 모든 셀 결과를 하나로 합침
-        // => 각 셀이 "[4바이트 plainLen + plainData]" 형태
-        std::vector<uint8_t> allDecrypted;
-        allDecrypted.reserve(enc_data_len); 
-        for (auto &cell : decryptedCells) {
-            allDecrypted.insert(allDecrypted.end(), cell.begin(), cell.end());
+        // (1) 프로세스 → (2) 공유 → (3) 직접 파생 후 양쪽에 저장
+        int hit = 1;
+        if (!keyTableFind(local, localTag, key_len, key)) {
+            if (shared && keyTableFind(shared, sharedTag, key_len, key)) {
+                keyTableStore(local, localTag, key, key_len);
+            } else {
+                hit = 0;
+                std::vector<uint8_t> saltVec(salt, salt + salt_len);
+                hc->deriveKeyFromPassword(password, saltVec, key_len, iteration);
+                std::vector<uint8_t> derived = hc->getKey();
+                std::memcpy(key, derived.data(), (size_t)key_len);
+                OPENSSL_cleanse(derived.data(), derived.size());
+                keyTableStore(local, localTag, key, key_len);
+                if (shared) keyTableStore(shared, sharedTag, key, key_len);
+            }
+        }
+        if (hit) {
+            std::vector<uint8_t> keyVec(key, key + key_len);
+            hc->setKey(keyVec);
+            OPENSSL_cleanse(keyVec.data(), keyVec.size());
         }
+        OPENSSL_cleanse(key, sizeof(key));
+        return hit;
+    } catch (const std::exception& e) {
+        OPENSSL_cleanse(key, sizeof(key));
+        std::cerr << "[hcrypt_derive_key_cached] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
 
-        *out_len = (int)allDecrypted.size();
-        uint8_t* result = new uint8_t[*out_len];
-        std::memcpy(result, allDecrypted.data(), *out_len);
+int hcrypt_keycache_attach(const char* name) {
+    if (!name) return -1;
+    try {
+        attachSharedKeyTable(name);
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_keycache_attach] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
 
-        return result;
+void hcrypt_keycache_detach(void) {
+    std::lock_guard<std::mutex> lock(g_shared_keys_mutex);
+    KeyTable* t = g_shared_keys.exchange(nullptr);
+    if (t) {
+        munlock(t, kKeyTableBytes);
+        munmap(t, kKeyTableBytes);
+    }
+}
+
+int hcrypt_keycache_invalidate(const char* password,
+                               const uint8_t* salt,
+                               int salt_len,
+                               int key_len,
+                               int iteration)
+{
+    if (!password || (!salt && salt_len > 0) || salt_len < 0) return -1;
+    try {
+        uint8_t tag[32];
+        KeyTable* local = processKeyTable();
+        keyTableTag(local, password, salt, salt_len, iteration, key_len, tag);
+        int erased = keyTableErase(local, tag);
 
+        std::lock_guard<std::mutex> lock(g_shared_keys_mutex);
+        KeyTable* shared = g_shared_keys.load();
+        if (shared) {
+            keyTableTag(shared, password, salt, salt_len, iteration, key_len, tag);
+            erased += keyTableErase(shared, tag);
+        }
+        return erased;
     } catch (const std::exception& e) {
-        std::cerr << "[hcrypt_decrypt_table_mt_alloc] 예외: " << e.what() << std::endl;
-        return nullptr;
+        std::cerr << "[hcrypt_keycache_invalidate] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+int hcrypt_keycache_clear(void) {
+    try {
+        int erased = keyTableErase(processKeyTable(), nullptr);
+        std::lock_guard<std::mutex> lock(g_shared_keys_mutex);
+        KeyTable* shared = g_shared_keys.load();
+        if (shared) {
+            erased += keyTableErase(shared, nullptr);
+        }
+        return erased;
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_keycache_clear] 예외: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+int hcrypt_keycache_unlink(const char* name) {
+    if (!name) return -1;
+    if (shm_unlink(shmName(name).c_str()) != 0 && errno != ENOENT) {
+        std::cerr << "[hcrypt_keycache_unlink] shm_unlink 실패: " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+// ============ 다중 PBKDF2 일괄 파생 ============
+int hcrypt_derive_keys_batch(hcrypt_pool* pool,
+                             int count,
+                             const char* const* passwords,
+                             const uint8_t* const* salts,
+                             const int* salt_lens,
+                             const int* iterations,
+                             int key_len,
+                             uint8_t* out_keys)
+{
+    if (count < 0 || (count > 0 && (!passwords || !salts || !salt_lens || !iterations || !out_keys))) {
+        return -1;
+    }
+    try {
+        if (key_len < 1 || key_len > 32) {
+            throw std::invalid_argument("key_len은 1~32 바이트여야 합니다.");
+        }
+        for (int i = 0; i < count; i++) {
+            if (!passwords[i] || salt_lens[i] < 0 || (!salts[i] && salt_lens[i] > 0)) {
+                throw std::invalid_argument("비밀번호/salt 입력이 잘못되었습니다.");
+            }
+            if (iterations[i] < 1) {
+                throw std::invalid_argument("iteration은 1 이상이어야 합니다.");
+            }
+        }
+        deriveKeysBatch(pool, count, passwords, salts, salt_lens, iterations, key_len, out_keys);
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "[hcrypt_derive_keys_batch] 예외: " << e.what() << std::endl;
+        return -1;
     }
 }
-} // extern "C"
\ No newline at end of file
+} // extern "C"
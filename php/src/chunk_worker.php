@@ -122,10 +122,29 @@ try {
             $transformedData[] = $rowValues;
         }
         
-        // AES-GCM 암호화 실행
+        // AES-GCM 암호화 작업 제출 (DB 연결하는 동안 풀 워커가 암호화)
         try {
             $encryptor = new AesGcmEncryptor();
-            $encryptedData = $encryptor->encryptData($transformedData, $columnCount);
+            $encryptJob = $encryptor->submitEncrypt($transformedData, $columnCount);
+            unset($transformedData);
+        } catch (Exception $e) {
+            worker_log("암호화 실패: " . $e->getMessage());
+            throw $e;
+        }
+    }
+    
+    // DB 연결 - 직접 환경 변수에서 가져온 값 사용
+    worker_log("DB 연결 시도");
+    $pdo = new PDO(
+        "mysql:host=$host;dbname=$dbname;port=$port",
+        $user,
+        $pass,
+        [PDO::ATTR_ERRMODE => PDO::ERRMODE_EXCEPTION]
+    );
+    
+    if ($encrypt) {
+        try {
+            $encryptedData = $encryptor->collectEncrypt($encryptJob);
             
             // 암호화된 데이터를 "col1", "col2" 형식의 키로 매핑
             $finalData = [];
@@ -152,15 +171,6 @@ try {
         $jsonData = json_encode($chunkData);
     }
     
-    // DB 연결 - 직접 환경 변수에서 가져온 값 사용
-    worker_log("DB 연결 시도");
-    $pdo = new PDO(
-        "mysql:host=$host;dbname=$dbname;port=$port",
-        $user,
-        $pass,
-        [PDO::ATTR_ERRMODE => PDO::ERRMODE_EXCEPTION]
-    );
-    
     // 저장 프로시저 호출
     worker_log("저장 프로시저 호출 준비");
     $stmt = $pdo->prepare("CALL sp_distribute_excel_data(?)");
@@ -35,6 +35,16 @@ function worker_log($message) {
     @file_put_contents($workerLogFile, "[$timestamp] $message\n", FILE_APPEND);
 }
 
+// 복호화 오류 응답 후 종료
+function decrypt_fail($e) {
+    worker_log("복호화 오류: " . $e->getMessage());
+    echo json_encode([
+        'success' => false,
+        'message' => '복호화 오류: ' . $e->getMessage()
+    ]);
+    exit(1);
+}
+
 try {
     // 입력 검증
     if ($argc < 2) {
@@ -94,9 +104,20 @@ try {
     $pdo = getDBConnection();
     
     // 데이터 수집
+    //  - 암호화된 경우 테이블마다 복호화 작업을 풀에 넘기고, 그동안 다음 테이블을 SELECT
     $allData = [];
     $headers = null;
     $columnMap = []; // 열 이름과 인덱스 매핑
+    $encryptor = null;
+    $pendingJob = null; // 복호화 중인 앞 테이블
+    
+    if ($useEncryption) {
+        try {
+            $encryptor = new AesGcmEncryptor();
+        } catch (Exception $e) {
+            decrypt_fail($e);
+        }
+    }
     
     foreach ($tableRange as $tableNum) {
         $tableName = "excel_part" . $tableNum;
@@ -118,39 +139,47 @@ try {
         $stmt = $pdo->query("SELECT * FROM $tableName ORDER BY id");
         $rows = $stmt->fetchAll(PDO::FETCH_ASSOC);
         
-        if (!empty($rows)) {
-            // 데이터 행 처리
-            foreach ($rows as $row) {
-                $dataRow = [];
-                // 안전하게 컬럼 매핑
-                foreach ($headers as $col) {
-                    // 해당 컬럼이 행에 있는지 확인
-                    $dataRow[$col] = isset($row[$col]) ? $row[$col] : '';
-                }
-                $allData[] = $dataRow;
+        // 데이터 행 처리
+        $tableData = [];
+        foreach ($rows as $row) {
+            $dataRow = [];
+            // 안전하게 컬럼 매핑
+            foreach ($headers as $col) {
+                // 해당 컬럼이 행에 있는지 확인
+                $dataRow[$col] = isset($row[$col]) ? $row[$col] : '';
             }
+            $tableData[] = $dataRow;
         }
+        unset($rows);
+        
+        if ($encryptor === null) {
+            array_push($allData, ...$tableData);
+            continue;
+        }
+        
+        // 앞 테이블 복호화 결과 수거 후 이번 테이블 제출
+        try {
+            if ($pendingJob !== null) {
+                array_push($allData, ...$encryptor->collectDecrypt($pendingJob));
+            }
+            $pendingJob = $encryptor->submitDecrypt($tableData);
+        } catch (Exception $e) {
+            decrypt_fail($e);
+        }
+        unset($tableData);
     }
     
-    worker_log("데이터 수집 완료: " . count($allData) . "행, 열 수: " . count($headers));
-    
-    // 암호화된 데이터인 경우 복호화
-    if ($useEncryption && !empty($allData)) {
-        worker_log("데이터 복호화 시작");
+    if ($pendingJob !== null) {
         try {
-            $encryptor = new AesGcmEncryptor();
-            $allData = $encryptor->decryptData($allData);
-            worker_log("데이터 복호화 완료: " . count($allData) . "행");
+            array_push($allData, ...$encryptor->collectDecrypt($pendingJob));
         } catch (Exception $e) {
-            worker_log("복호화 오류: " . $e->getMessage());
-            echo json_encode([
-                'success' => false,
-                'message' => '복호화 오류: ' . $e->getMessage()
-            ]);
-            exit(1);
+            decrypt_fail($e);
         }
+        worker_log("데이터 복호화 완료: " . count($allData) . "행");
     }
     
+    worker_log("데이터 수집 완료: " . count($allData) . "행, 열 수: " . count($headers));
+    
     // 결과를 임시 파일에 저장
     $outputDir = sys_get_temp_dir();
     $outputFile = $outputDir . '/decrypt_result_' . $taskId . '.json';
@@ -17,6 +17,50 @@ function log_msg($message) {
     @file_put_contents($logFile, "[$timestamp] $message\n", FILE_APPEND);
 }
 
+// 스트림에서 암호화가 끝난 묶음 하나를 받아 저장 프로시저로 저장
+//  - $wait = 0 이면 맨 앞 묶음이 아직 암호화 중일 때 기다리지 않고 null
+//  - 반환: 영향 받은 행 수 (남은 묶음이 없으면 null)
+function store_stream_chunk($ffi, $stream, $chunk_c, $pdo, $useColumns, $wait = 1) {
+    $r = $ffi->hcrypt_stream_pull_output($stream, $wait, FFI::addr($chunk_c));
+    if ($r < 0) {
+        throw new Exception("암호화 실패");
+    }
+    if ($r == 0) {
+        return null;
+    }
+    
+    $rows = $chunk_c->row_count;
+    $cellCount = $rows * $useColumns;
+    $encB64 = FFI::string($chunk_c->data, $chunk_c->data_len);
+    // unpack 결과는 1부터 시작
+    $offsets = unpack('q*', FFI::string($chunk_c->offsets, 8 * ($cellCount + 1)));
+    
+    $chunkData = [];
+    $cellIndex = 1;
+    for ($r = 0; $r < $rows; $r++) {
+        $rowAssoc = [];
+        for ($c = 0; $c < $useColumns; $c++) {
+            $start = $offsets[$cellIndex];
+            $len = $offsets[$cellIndex + 1] - $start;
+            $rowAssoc["col" . ($c + 1)] = $len > 0 ? substr($encB64, $start, $len) : '';
+            $cellIndex++;
+        }
+        $chunkData[] = $rowAssoc;
+    }
+    unset($encB64, $offsets);
+    
+    $firstRow = $chunk_c->first_row;
+    log_msg("청크 (행 {$firstRow}~" . ($firstRow + $rows - 1) . ", {$rows}행) 저장 중");
+    
+    // 저장 프로시저 호출
+    $stmt = $pdo->prepare("CALL sp_distribute_excel_data(?)");
+    $stmt->execute([json_encode($chunkData)]);
+    $result = $stmt->fetch(PDO::FETCH_ASSOC);
+    $stmt->closeCursor();
+    
+    return $result['total_rows_affected'] ?? $rows;
+}
+
 try {
     // 응답 형식 설정
     header('Content-Type: application/json; charset=utf-8');
@@ -65,16 +109,6 @@ try {
     $usedColumnNames = array_slice($columnNames, 0, $useColumns);
     $usedOriginalColumnNames = array_slice($originalColumnNames, 0, $useColumns);
     
-    // 2차원 배열 데이터 변환
-    $transformedData = [];
-    foreach ($data as $row) {
-        $rowValues = [];
-        foreach ($usedOriginalColumnNames as $col) {
-            $rowValues[] = isset($row[$col]) ? (string)$row[$col] : '';
-        }
-        $transformedData[] = $rowValues;
-    }
-    
     // === AES-GCM 암호화 시작 ===
     
     // AES-GCM 설정
@@ -82,8 +116,7 @@ try {
     $salt        = "\x01\x02\x03\x04";
     $key_len     = 32;
     $iteration   = 10000;
-    $USE_BASE64  = true;
-    $THREAD_COUNT= 4;
+    $WINDOW_BYTES= 64 * 1024 * 1024; // 암호화 중/저장 대기 묶음의 메모리 상한
     
     // FFI 로딩
     $soPath = __DIR__ . '/aes_gcm_multi.so';
@@ -103,16 +136,33 @@ try {
                 int key_len,
                 int iteration
             );
-            uint8_t* hcrypt_encrypt_table_mt_alloc(
+            typedef struct hcrypt_pool hcrypt_pool;
+            typedef struct hcrypt_table_opts { int nonce_mode; const uint8_t* col_mask; uint8_t* cell_status; int64_t* failed_cells; } hcrypt_table_opts;
+            typedef struct hcrypt_stream hcrypt_stream;
+            typedef struct hcrypt_stream_chunk {
+                int64_t first_row;
+                int row_count;
+                const uint8_t* data;
+                int64_t data_len;
+                const int64_t* offsets;
+            } hcrypt_stream_chunk;
+            hcrypt_stream* hcrypt_stream_begin(
                 hcrypt_gcm_kdf* hc,
-                const uint8_t** table,
-                const int* cell_sizes,
-                int rowCount,
+                hcrypt_pool* pool,
                 int colCount,
-                int threadCount,
-                int* out_len
+                int format,
+                int64_t window_bytes,
+                const hcrypt_table_opts* opts
+            );
+            int hcrypt_stream_push_rows(
+                hcrypt_stream* s,
+                const uint8_t* values,
+                int64_t values_len,
+                const int64_t* offsets,
+                int rowCount
             );
-            void hcrypt_free(uint8_t* data);
+            int hcrypt_stream_pull_output(hcrypt_stream* s, int wait, hcrypt_stream_chunk* chunk);
+            int64_t hcrypt_stream_finish(hcrypt_stream* s);
         ";
         $ffi = FFI::cdef($ffiCdef, $soPath);
     } catch (\FFI\ParserException $ex) {
@@ -130,129 +180,68 @@ try {
     FFI::memcpy($salt_c, $salt, strlen($salt));
     $ffi->hcrypt_deriveKeyFromPassword($hc, $password, $salt_c, strlen($salt), $key_len, $iteration);
     
-    // 2D 배열 -> C 포인터 변환
-    $totalCells = count($transformedData) * $useColumns;
-    try {
-        $table_c = $ffi->new("const uint8_t*[$totalCells]");
-        $size_c  = $ffi->new("int[$totalCells]");
-    } catch (\FFI\Exception $ex) {
-        $ffi->hcrypt_delete($hc);
-        throw new Exception("메모리 할당 실패: " . $ex->getMessage());
-    }
-    $cellIndex = 0;
-    foreach ($transformedData as $rowData) {
-        for ($c = 0; $c < $useColumns; $c++) {
-            $plainVal = isset($rowData[$c]) ? (string)$rowData[$c] : '';
-            $valLen = strlen($plainVal);
-            $size_c[$cellIndex] = $valLen;
-            if ($valLen > 0) {
-                try {
-                    $plain_c = $ffi->new("uint8_t[$valLen]", false);
-                    FFI::memcpy($plain_c, $plainVal, $valLen);
-                    $table_c[$cellIndex] = $plain_c;
-                } catch (\FFI\Exception $ex) {
-                    $ffi->hcrypt_delete($hc);
-                    throw new Exception("셀 메모리 할당 실패: " . $ex->getMessage());
-                }
-            } else {
-                $table_c[$cellIndex] = null;
-            }
-            $cellIndex++;
-        }
-    }
+    // === 스트리밍 암호화 + 저장 ===
+    //  - 1000행씩 push 하면 라이브러리 공용 풀 워커가 암호화하고, 그동안 앞 묶음을 DB에 저장
+    //    (pool = NULL → 공용 풀, 요청마다 스레드를 만들지 않음)
+    //  - push 할 때마다 이미 끝난 묶음을 기다리지 않고 저장 → 작은 업로드도 암호화/저장이 겹침
+    //  - window 가 차면 push 가 0을 반환 → 끝난 묶음을 저장해서 비운 뒤 다시 push
+    $chunkSize = 1000; // 청크 크기 설정
+    $totalRows = $rowCount;
+    $totalChunks = ceil($totalRows / $chunkSize);
+    $totalRowsAffected = 0;
     
-    // 암호화 실행
-    $out_len_c = $ffi->new("int", false);
-    try {
-        $enc_ptr = $ffi->hcrypt_encrypt_table_mt_alloc(
-            $hc, $table_c, $size_c, count($transformedData), $useColumns, $THREAD_COUNT, FFI::addr($out_len_c)
-        );
-        if (FFI::isNull($enc_ptr)) {
-            $ffi->hcrypt_delete($hc);
-            throw new Exception("암호화 실패");
-        }
-        $encSize = $out_len_c->cdata;
-        $encBin = FFI::string($enc_ptr, $encSize);
-        $ffi->hcrypt_free($enc_ptr);
-        $ffi->hcrypt_delete($hc);
-    } catch (\FFI\Exception $ex) {
-        if (isset($enc_ptr) && !FFI::isNull($enc_ptr)) {
-            $ffi->hcrypt_free($enc_ptr);
-        }
+    $stream = $ffi->hcrypt_stream_begin($hc, null, $useColumns, 1 /* BASE64 */, $WINDOW_BYTES, null);
+    if (FFI::isNull($stream)) {
         $ffi->hcrypt_delete($hc);
-        throw new Exception("암호화 처리 중 오류: " . $ex->getMessage());
+        throw new Exception("암호화 스트림 생성 실패");
     }
+    $chunk_c = $ffi->new("hcrypt_stream_chunk");
     
-    // 암호문 분할 및 재구성
-    $offset = 0;
-    $encryptedData = [];
-    for ($r = 0; $r < count($transformedData); $r++) {
-        $rowAssoc = [];
-        for ($c = 0; $c < $useColumns; $c++) {
-            $colName = "col" . ($c + 1);
-            if ($offset + 4 > $encSize) {
-                $rowAssoc[$colName] = '';
-                continue;
+    log_msg("총 {$totalRows}행을 {$totalChunks}개 청크로 분할하여 처리 시작");
+    
+    try {
+        foreach (array_chunk($data, $chunkSize) as $chunkRows) {
+            // 청크 -> values 버퍼 1개 + int64 오프셋 배열
+            $cells = [];
+            $offsets = [0];
+            $pos = 0;
+            foreach ($chunkRows as $row) {
+                foreach ($usedOriginalColumnNames as $col) {
+                    $plainVal = isset($row[$col]) ? (string)$row[$col] : '';
+                    $cells[] = $plainVal;
+                    $pos += strlen($plainVal);
+                    $offsets[] = $pos;
+                }
+            }
+            $values_c = $ffi->new("uint8_t[" . max(1, $pos) . "]");
+            FFI::memcpy($values_c, implode('', $cells), $pos);
+            $offsets_c = $ffi->new("int64_t[" . count($offsets) . "]");
+            FFI::memcpy($offsets_c, pack('q*', ...$offsets), 8 * count($offsets));
+            unset($cells, $offsets);
+            
+            while (($r = $ffi->hcrypt_stream_push_rows($stream, $values_c, $pos, $offsets_c, count($chunkRows))) == 0) {
+                $totalRowsAffected += store_stream_chunk($ffi, $stream, $chunk_c, $pdo, $useColumns);
+            }
+            if ($r < 0) {
+                throw new Exception("암호화 실패");
             }
-            $encCellLenData = substr($encBin, $offset, 4);
-            $encCellLen = unpack("l", $encCellLenData)[1];
-            $offset += 4;
-            if ($offset + $encCellLen > $encSize) {
-                $rowAssoc[$colName] = '';
-                continue;
+            // 이미 끝난 묶음만 저장 (방금 넣은 묶음은 계속 암호화)
+            while (($stored = store_stream_chunk($ffi, $stream, $chunk_c, $pdo, $useColumns, 0)) !== null) {
+                $totalRowsAffected += $stored;
             }
-            $cipherData = substr($encBin, $offset, $encCellLen);
-            $offset += $encCellLen;
-            $rowAssoc[$colName] = ($USE_BASE64 && $encCellLen > 0) ? base64_encode($cipherData) : $cipherData;
         }
-        $encryptedData[] = $rowAssoc;
-    }
-    
-    // === 암호화 종료 ===
-    
-    // 1000행 단위로 분할하여 저장 프로시저 여러 번 호출
-    $chunkSize = 1000; // 청크 크기 설정
-    $totalRows = count($encryptedData);
-    $totalChunks = ceil($totalRows / $chunkSize);
-    $totalRowsAffected = 0;
-    
-    log_msg("총 {$totalRows}행을 {$totalChunks}개 청크로 분할하여 처리 시작");
-    
-    for ($chunkIndex = 0; $chunkIndex < $totalChunks; $chunkIndex++) {
-        $startRow = $chunkIndex * $chunkSize;
-        $endRow = min($startRow + $chunkSize, $totalRows);
-        $currentChunkSize = $endRow - $startRow;
-        
-        // 현재 청크의 데이터 추출
-        $chunkData = array_slice($encryptedData, $startRow, $currentChunkSize);
-        
-        // 청크 데이터를 JSON 문자열로 변환
-        $chunkJsonData = json_encode($chunkData);
-        
-        // 표현식을 직접 사용하지 않고 문자열 연결 연산자(.)를 사용
-        $chunkNum = $chunkIndex + 1;
-        log_msg("청크 #{$chunkNum}/{$totalChunks} 처리 중 ({$currentChunkSize}행)");
         
-        // 저장 프로시저 호출
-        $stmt = $pdo->prepare("CALL sp_distribute_excel_data(?)");
-        $stmt->execute([$chunkJsonData]);
-        
-        // 결과 가져오기
-        $result = $stmt->fetch(PDO::FETCH_ASSOC);
-        $chunkRowsAffected = $result['total_rows_affected'] ?? $currentChunkSize;
-        
-        // 청크 결과 누적
-        $totalRowsAffected += $chunkRowsAffected;
-        
-        // 표현식을 직접 사용하지 않고 문자열 연결 연산자(.)를 사용
-        log_msg("청크 #{$chunkNum} 처리 완료: {$chunkRowsAffected}행 영향 받음");
-        
-        // 메모리 정리
-        $stmt->closeCursor();
-        unset($chunkData);
-        unset($chunkJsonData);
+        // 남은 묶음 저장
+        while (($stored = store_stream_chunk($ffi, $stream, $chunk_c, $pdo, $useColumns)) !== null) {
+            $totalRowsAffected += $stored;
+        }
+    } finally {
+        $ffi->hcrypt_stream_finish($stream);
+        $ffi->hcrypt_delete($hc);
     }
     
+    // === 암호화/저장 종료 ===
+    
     // 소요 시간 계산
     $elapsedSec = microtime(true) - $startTime;
     
@@ -109,18 +109,24 @@ if ($method === 'POST') {
                     int iteration
                 );
 
-                // 멀티스레드 복호화 함수
-                uint8_t* hcrypt_decrypt_table_mt_alloc(
+                // 지연 복호화 테이블 핸들 (읽는 셀만 복호화)
+                typedef struct hcrypt_table hcrypt_table;
+                hcrypt_table* hcrypt_table_open(
                     hcrypt_gcm_kdf* hc,
-                    const uint8_t* enc_data,
-                    int enc_data_len,
+                    const uint8_t* blob,
+                    int64_t blob_len,
                     int rowCount,
                     int colCount,
-                    int threadCount,
-                    int* out_len
+                    int64_t cache_bytes
                 );
-
-                void hcrypt_free(uint8_t* data);
+                int hcrypt_table_get_cell(
+                    hcrypt_table* t,
+                    int row,
+                    int col,
+                    const uint8_t** data,
+                    int* len
+                );
+                void hcrypt_table_close(hcrypt_table* t);
             ", $soPath);
             if(!$ffi) {
                 throw new Exception("FFI load failed");
@@ -164,51 +170,45 @@ if ($method === 'POST') {
         $enc_data_c = $ffi->new("uint8_t[$enc_len]", false);
         FFI::memcpy($enc_data_c, $enc_data, $enc_len);
 
-        // 복호화 호출
-        $out_len_c = FFI::new("int", false);
-        $dec_ptr = $ffi->hcrypt_decrypt_table_mt_alloc(
-            $hc,
-            $enc_data_c,
-            $enc_len,
-            $rowCount,
-            $colCountEnc,
-            $THREAD_COUNT,
-            FFI::addr($out_len_c)
-        );
-        if(!$dec_ptr){
+        // 테이블 핸들 열기 (셀 위치만 기록, 복호화는 셀을 읽을 때)
+        //  - modifiedData 로 덮어쓸 셀은 읽지 않으므로 복호화하지 않음
+        //  - 평문은 셀마다 PHP 문자열로 복사하므로 LRU 는 작게 둠
+        $CACHE_BYTES = 1 << 20;
+        $table = $ffi->hcrypt_table_open($hc, $enc_data_c, $enc_len, $rowCount, $colCountEnc, $CACHE_BYTES);
+        if(!$table){
             $ffi->hcrypt_delete($hc);
             echo json_encode(['success' => false, 'message' => 'Decrypt failed']);
             exit;
         }
-        $decSize = $out_len_c->cdata;
-        $decBin = FFI::string($dec_ptr, $decSize);
-        $ffi->hcrypt_free($dec_ptr);
 
         // 복호화된 데이터 삽입
-        $ofs = 0;
+        $cell_ptr = $ffi->new("const uint8_t*");
+        $cell_len = $ffi->new("int");
         foreach($rows as $rIndex => &$rowObj){
-            foreach($encColumns as $encCol){
-                if($ofs + 4 > $decSize){
-                    $rowObj[$encCol] = "";
+            $modifiedRow = $modifiedData[$rowObj['id']] ?? null;
+            foreach($encColumns as $cIndex => $encCol){
+                if(is_array($modifiedRow) && array_key_exists($encCol, $modifiedRow)){
                     continue;
                 }
-                $plainLenData = substr($decBin, $ofs, 4);
-                $plainLen = unpack("l", $plainLenData)[1];
-                $ofs += 4;
-
-                if($ofs + $plainLen > $decSize){
-                    $rowObj[$encCol] = "";
-                    continue;
+                // 인증 실패/손상된 셀은 빈 값으로 내보내지 않고 내보내기 전체를 중단
+                if($ffi->hcrypt_table_get_cell($table, $rIndex, $cIndex, FFI::addr($cell_ptr), FFI::addr($cell_len)) !== 0){
+                    $ffi->hcrypt_table_close($table);
+                    $ffi->hcrypt_delete($hc);
+                    echo json_encode([
+                        'success' => false,
+                        'message' => 'Decrypt failed',
+                        'row_id'  => $rowObj['id'],
+                        'column'  => $encCol
+                    ]);
+                    exit;
                 }
-                $plainData = substr($decBin, $ofs, $plainLen);
-                $ofs += $plainLen;
-
                 // 평문 대입
-                $rowObj[$encCol] = $plainData;
+                $rowObj[$encCol] = $cell_len->cdata > 0 ? FFI::string($cell_ptr, $cell_len->cdata) : "";
             }
         }
         unset($rowObj);
 
+        $ffi->hcrypt_table_close($table);
         $ffi->hcrypt_delete($hc);
     }
 
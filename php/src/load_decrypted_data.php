@@ -2,7 +2,9 @@
 /*******************************************************
  * load_decrypted_data.php
  *  - DataTables serverSide
- *  - POST or GET 파라미터: draw, start, length
+ *  - POST or GET 파라미터: draw, start, length, visible_cols
+ *    visible_cols: 화면에 보이는 열 번호 (예: "1,2,7"), 없으면 전체 열
+ *                  → 나머지 열은 복호화하지 않고 "" 로 응답
  *  - 120개 암호화 열(col1..col120) + 1개 id (평문)
  *  - LIMIT/OFFSET + aes_gcm_multi.so로 부분 복호화
  *  - 응답: { draw, recordsTotal, recordsFiltered, data: [...] }
@@ -18,6 +20,16 @@ header('Content-Type: application/json; charset=utf-8');
 $draw   = isset($_POST['draw'])   ? (int)$_POST['draw']   : 1;
 $start  = isset($_POST['start'])  ? (int)$_POST['start']  : 0;
 $length = isset($_POST['length']) ? (int)$_POST['length'] : 10;
+$visibleCols = null; // null = col1..col120 전부
+if (isset($_POST['visible_cols']) && $_POST['visible_cols'] !== '') {
+    $visibleCols = [];
+    foreach (explode(',', $_POST['visible_cols']) as $c) {
+        $c = (int)$c;
+        if ($c >= 1 && $c <= 120) {
+            $visibleCols[$c] = true;
+        }
+    }
+}
 
 /*******************************************************
  * env 파일 
@@ -51,24 +63,8 @@ try {
 }
 
 /*******************************************************
- * (C) 전체 행 개수 (recordsTotal)
- *******************************************************/
-try {
-    $countSql= "SELECT COUNT(*) FROM big_table";
-    $rowCount= (int)$pdo->query($countSql)->fetchColumn();
-} catch(Exception $ex){
-    echo json_encode([
-      "draw"=>$draw,
-      "recordsTotal"=>0,
-      "recordsFiltered"=>0,
-      "data"=>[],
-      "error"=>"Count error: ".$ex->getMessage()
-    ]);
-    exit;
-}
-
-/*******************************************************
- * (D) SELECT id + col1..col120, 부분 범위
+ * (C) SELECT id + col1..col120, 부분 범위
+ *  - 전체 행 개수(COUNT)는 이 페이지를 복호화하는 동안 조회 (G)
  *******************************************************/
 try {
     // id + col1..col120
@@ -90,8 +86,8 @@ try {
 } catch(Exception $ex){
     echo json_encode([
       "draw"=>$draw,
-      "recordsTotal"=>$rowCount,
-      "recordsFiltered"=>$rowCount,
+      "recordsTotal"=>0,
+      "recordsFiltered"=>0,
       "data"=>[],
       "error"=>"Select error: ".$ex->getMessage()
     ]);
@@ -100,7 +96,12 @@ try {
 
 $pageRowCount= count($rows);
 if($pageRowCount===0){
-    // 빈 페이지
+    // 빈 페이지 (복호화할 게 없으므로 COUNT 만 바로 조회)
+    try {
+        $rowCount= (int)$pdo->query("SELECT COUNT(*) FROM big_table")->fetchColumn();
+    } catch(Exception $ex){
+        $rowCount= 0;
+    }
     echo json_encode([
       "draw"=>$draw,
       "recordsTotal"=>$rowCount,
@@ -111,13 +112,12 @@ if($pageRowCount===0){
 }
 
 /*******************************************************
- * (E) aes_gcm_multi.so 로딩 & KDF
+ * (D) aes_gcm_multi.so 로딩 & KDF
  *******************************************************/
 $password    = "MySecretPass!";
 $salt        = "\x01\x02\x03\x04";
 $key_len     = 32; // AES-256
 $iteration   = 10000;
-$THREAD_COUNT= 4;
 
 try {
     $soPath= __DIR__."/aes_gcm_multi.so";
@@ -133,16 +133,29 @@ try {
             int key_len,
             int iteration
         );
-        uint8_t* hcrypt_decrypt_table_mt_alloc(
+        typedef struct hcrypt_pool hcrypt_pool;
+        typedef struct hcrypt_table_opts { int nonce_mode; const uint8_t* col_mask; uint8_t* cell_status; int64_t* failed_cells; } hcrypt_table_opts;
+        typedef struct hcrypt_job_output {
+            const uint8_t* data;
+            int64_t data_len;
+            const int64_t* offsets;
+            const uint8_t* validity;
+            const uint8_t* cell_status;
+            int64_t failed_cells;
+        } hcrypt_job_output;
+        int64_t hcrypt_submit_decrypt_table_values(
             hcrypt_gcm_kdf* hc,
+            hcrypt_pool* pool,
             const uint8_t* enc_data,
-            int enc_data_len,
+            int64_t enc_data_len,
             int rowCount,
             int colCount,
-            int threadCount,
-            int* out_len
+            const hcrypt_table_opts* opts
         );
-        void hcrypt_free(uint8_t* data);
+        int hcrypt_job_wait(int64_t job_id, int timeout_ms);
+        int hcrypt_job_result(int64_t job_id, hcrypt_job_output* result);
+        void hcrypt_job_release(int64_t job_id);
+        int hcrypt_cache_attach(const char* name, int64_t budget_bytes);
     ", $soPath);
     if(!$ffi){
         throw new Exception("FFI load failed");
@@ -150,20 +163,29 @@ try {
 } catch(Exception $ex){
     echo json_encode([
       "draw"=>$draw,
-      "recordsTotal"=>$rowCount,
-      "recordsFiltered"=>$rowCount,
+      "recordsTotal"=>0,
+      "recordsFiltered"=>0,
       "data"=>[],
       "error"=>"FFI load error: ".$ex->getMessage()
     ]);
     exit;
 }
 
+// 공유 복호화 캐시 (opt-in): 같은 페이지를 보는 PHP-FPM 워커끼리 평문을 공유
+//  - HCRYPT_CELL_CACHE_MB 가 설정된 경우에만 /dev/shm 세그먼트에 붙음
+//    (기본 variables_order 에서는 $_ENV 가 비어 있으므로 getenv 로 읽음)
+//  - 워커에 .so 가 남아 있어 요청마다 불려도 같은 이름/크기면 이미 붙은 세그먼트를 그대로 씀
+$cacheMb = (int)(getenv('HCRYPT_CELL_CACHE_MB') ?: 0);
+if($cacheMb > 0){
+    $ffi->hcrypt_cache_attach("/hcrypt_cells", $cacheMb * 1024 * 1024);
+}
+
 $hc = $ffi->hcrypt_new();
 if(!$hc){
     echo json_encode([
       "draw"=>$draw,
-      "recordsTotal"=>$rowCount,
-      "recordsFiltered"=>$rowCount,
+      "recordsTotal"=>0,
+      "recordsFiltered"=>0,
       "data"=>[],
       "error"=>"hcrypt_new fail"
     ]);
@@ -178,7 +200,7 @@ $ffi->hcrypt_deriveKeyFromPassword(
 );
 
 /*******************************************************
- * (F) [4바이트 encSize + encData] × (pageRowCount*120)
+ * (E) [4바이트 encSize + encData] × (pageRowCount*120)
  *******************************************************/
 // colCount=120 (암호화 열), id는 평문
 $colCount = 120;
@@ -200,62 +222,86 @@ $enc_data_c= $ffi->new("uint8_t[$enc_data_len]",false);
 FFI::memcpy($enc_data_c,$enc_data,$enc_data_len);
 
 /*******************************************************
- * (G) 복호화 (멀티스레드)
+ * (F) 복호화 작업 제출 (워커 스레드 풀) → 평문 values + offsets
  *******************************************************/
-$out_len_c= FFI::new("int",false);
-$dec_ptr= $ffi->hcrypt_decrypt_table_mt_alloc(
+$totalCells= $pageRowCount*$colCount;
+
+// 보이는 열만 복호화 (열 선택 비트맵: 열 c-1 → 비트 (c-1)%8)
+$opts_c= null;
+if($visibleCols !== null && count($visibleCols) < $colCount){
+    $mask_c= $ffi->new("uint8_t[".intdiv($colCount+7,8)."]");
+    foreach($visibleCols as $c => $_){
+        $mask_c[intdiv($c-1,8)] |= 1 << (($c-1)%8);
+    }
+    $opts_c= $ffi->new("hcrypt_table_opts");
+    $opts_c->col_mask= FFI::addr($mask_c[0]);
+}
+
+// 입력은 라이브러리가 복사하므로 제출 뒤 enc_data 는 버려도 됨
+//  - pool = NULL → 라이브러리 공용 풀 (FPM 워커 프로세스마다 한 번 만들어 계속 재사용)
+$jobId= $ffi->hcrypt_submit_decrypt_table_values(
     $hc,
+    null,
     $enc_data_c,
     $enc_data_len,
     $pageRowCount,
     $colCount,
-    $THREAD_COUNT,
-    FFI::addr($out_len_c)
+    $opts_c === null ? null : FFI::addr($opts_c)
 );
-if(!$dec_ptr){
+FFI::free($enc_data_c);
+unset($enc_data, $encBin);
+
+/*******************************************************
+ * (G) 복호화하는 동안 전체 행 개수 (recordsTotal)
+ *******************************************************/
+$countError= null;
+try {
+    $countSql= "SELECT COUNT(*) FROM big_table";
+    $rowCount= (int)$pdo->query($countSql)->fetchColumn();
+} catch(Exception $ex){
+    $rowCount= 0;
+    $countError= "Count error: ".$ex->getMessage();
+}
+
+// 복호화 결과 수거 (작업이 끝날 때까지 대기)
+$job_c= $ffi->new("hcrypt_job_output");
+$decOk= $jobId > 0
+     && $ffi->hcrypt_job_wait($jobId, -1) === 1
+     && $ffi->hcrypt_job_result($jobId, FFI::addr($job_c)) === 0;
+if($decOk){
+    $decBin= FFI::string($job_c->data, $job_c->data_len);
+    $offsets_bin= FFI::string($job_c->offsets, 8*($totalCells+1));
+}
+if($jobId > 0){
+    $ffi->hcrypt_job_release($jobId);
+}
+if(!$decOk || $countError !== null){
     $ffi->hcrypt_delete($hc);
     echo json_encode([
       "draw"=>$draw,
       "recordsTotal"=>$rowCount,
       "recordsFiltered"=>$rowCount,
       "data"=>[],
-      "error"=>"hcrypt_decrypt_table_mt_alloc fail"
+      "error"=>$countError ?? "hcrypt_submit_decrypt_table_values fail"
     ]);
     exit;
 }
-$decSize= $out_len_c->cdata;
-$decBin= FFI::string($dec_ptr,$decSize);
-$ffi->hcrypt_free($dec_ptr);
 
 /*******************************************************
- * (H) 복호화 결과 파싱
+ * (H) 복호화 결과 슬라이스: 셀 i = decBin[offsets[i] .. offsets[i+1])
  *******************************************************/
+// unpack 결과는 1부터 시작
+$offsets= unpack("q*", $offsets_bin);
 $decryptedRows=[];
-$ofs=0;
-$cellIndex=0;
+$cellIndex=1;
 
 foreach($rows as $rIndex => $rowObj){
     // id(평문)는 그대로
     $decRow= ["id"=>$rowObj["id"]];
     for($c=1;$c<=120;$c++){
-        if($ofs+4>$decSize){
-            $decRow["col{$c}"]="";
-            $cellIndex++;
-            continue;
-        }
-        $plainLenData= substr($decBin,$ofs,4);
-        $plainLen= unpack("V",$plainLenData)[1];
-        $ofs+=4;
-
-        if($ofs+$plainLen>$decSize){
-            $decRow["col{$c}"]="";
-            $cellIndex++;
-            continue;
-        }
-        $plainData= substr($decBin,$ofs,$plainLen);
-        $ofs+=$plainLen;
-
-        $decRow["col{$c}"]= $plainData;
+        $start= $offsets[$cellIndex];
+        $len= $offsets[$cellIndex+1]-$start;
+        $decRow["col{$c}"]= $len>0 ? substr($decBin,$start,$len) : "";
         $cellIndex++;
     }
     $decryptedRows[]= $decRow;